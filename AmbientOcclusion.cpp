@@ -0,0 +1,323 @@
+///////////////////////////////////////////////////////////////////////////////
+// ambientocclusion.cpp
+// ============
+// manage the screen space ambient occlusion - contact shading computed at
+// half resolution with temporal reuse and depth aware upsample
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AmbientOcclusion.h"
+#include "FullscreenPass.h"
+
+#include <iostream>
+
+// declare the global variables
+namespace
+{
+	// the occlusion and its history are half the scene size
+	const int g_OcclusionDivisor = 2;
+	// occlusion in R, view distance in G for the reprojection and
+	// the upsample
+	const GLenum g_OcclusionFormat = GL_RG16F;
+	// timings averaged for each report
+	const int g_TimingsPerReport = 300;
+}
+
+/***********************************************************
+ *  AmbientOcclusion()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+AmbientOcclusion::AmbientOcclusion(ViewManager* pViewManager)
+{
+	m_pViewManager = pViewManager;
+	m_pRenderTargetPool = NULL;
+	m_pFrameGraph = NULL;
+	m_pOcclusionShader = NULL;
+	m_pTemporalShader = NULL;
+	m_pApplyShader = NULL;
+	m_historyTargets[0] = -1;
+	m_historyTargets[1] = -1;
+	m_historyIndex = 0;
+	m_bHistoryValid = false;
+	m_frameIndex = 0;
+	m_timerQuery = 0;
+	m_bTimerPending = false;
+	m_timeSum = 0.0f;
+	m_timeCount = 0;
+	m_averageTime = 0.0f;
+	m_width = 0;
+	m_height = 0;
+	m_occlusionWidth = 0;
+	m_occlusionHeight = 0;
+
+	// the radius covers the gap under the laptop and the tumbler
+	// without shading whole walls
+	m_settings.bEnabled = true;
+	m_settings.radius = 1.5f;
+	m_settings.intensity = 1.5f;
+	m_settings.sampleCount = 8;
+	m_settings.historyWeight = 0.9f;
+}
+
+/***********************************************************
+ *  ~AmbientOcclusion()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+AmbientOcclusion::~AmbientOcclusion()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for loading the occlusion shaders and
+ *  acquiring the two history targets.
+ ***********************************************************/
+bool AmbientOcclusion::Create(int width, int height, RenderTargetPool* pRenderTargetPool)
+{
+	if (NULL == pRenderTargetPool)
+	{
+		return false;
+	}
+
+	m_pRenderTargetPool = pRenderTargetPool;
+	m_width = width;
+	m_height = height;
+	m_occlusionWidth = (width / g_OcclusionDivisor > 1) ? width / g_OcclusionDivisor : 1;
+	m_occlusionHeight = (height / g_OcclusionDivisor > 1) ? height / g_OcclusionDivisor : 1;
+
+	m_pOcclusionShader = FullscreenPass::LoadShader("ssaoFragmentShader.glsl");
+	m_pTemporalShader = FullscreenPass::LoadShader("reprojectTemporalFragmentShader.glsl");
+	m_pApplyShader = FullscreenPass::LoadShader("ssaoApplyFragmentShader.glsl");
+	m_occlusionState = FullscreenPass::GetState(m_pOcclusionShader);
+	m_temporalState = FullscreenPass::GetState(m_pTemporalShader);
+	m_applyState = FullscreenPass::GetState(m_pApplyShader, PipelineState::BLEND_MULTIPLY);
+
+	// the history is held for the whole run, so it is acquired once
+	// and never handed back to the pool
+	for (int i = 0; i < 2; i++)
+	{
+		m_historyTargets[i] = m_pRenderTargetPool->AcquireTarget(
+			m_occlusionWidth, m_occlusionHeight, g_OcclusionFormat);
+		if (m_historyTargets[i] < 0)
+		{
+			std::cout << "Failed to create the occlusion history" << std::endl;
+			return false;
+		}
+	}
+
+	glGenQueries(1, &m_timerQuery);
+
+	std::cout << "INFO: Ambient occlusion " << m_occlusionWidth << "x" << m_occlusionHeight << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shader programs and
+ *  the timer query.
+ ***********************************************************/
+void AmbientOcclusion::Destroy()
+{
+	if (NULL != m_pOcclusionShader)
+	{
+		delete m_pOcclusionShader;
+		m_pOcclusionShader = NULL;
+	}
+	if (NULL != m_pTemporalShader)
+	{
+		delete m_pTemporalShader;
+		m_pTemporalShader = NULL;
+	}
+	if (NULL != m_pApplyShader)
+	{
+		delete m_pApplyShader;
+		m_pApplyShader = NULL;
+	}
+	if (m_timerQuery != 0)
+	{
+		glDeleteQueries(1, &m_timerQuery);
+		m_timerQuery = 0;
+	}
+
+	// the pool frees the history targets when it is destroyed
+	if (NULL != m_pRenderTargetPool)
+	{
+		m_pRenderTargetPool->ReleaseTarget(m_historyTargets[0]);
+		m_pRenderTargetPool->ReleaseTarget(m_historyTargets[1]);
+		m_pRenderTargetPool = NULL;
+	}
+	m_historyTargets[0] = -1;
+	m_historyTargets[1] = -1;
+	m_bHistoryValid = false;
+	m_pFrameGraph = NULL;
+}
+
+/***********************************************************
+ *  AddPasses()
+ *
+ *  This method is used for adding the occlusion passes to
+ *  the frame graph:
+ *    1. half resolution hemisphere samples against the depth
+ *    2. temporal accumulation into the history
+ *    3. depth aware upsample multiplied into the HDR color
+ *  One timer query spans all three passes.
+ ***********************************************************/
+void AmbientOcclusion::AddPasses(FrameGraph* pFrameGraph, int hdrColor, int sceneDepth, int sceneSurface)
+{
+	if ((NULL == pFrameGraph) || (m_settings.bEnabled == false) || (NULL == m_pOcclusionShader))
+	{
+		m_bHistoryValid = false;
+		return;
+	}
+	m_pFrameGraph = pFrameGraph;
+	m_frameIndex++;
+
+	UpdateTiming();
+
+	int readIndex = m_historyIndex;
+	int writeIndex = 1 - m_historyIndex;
+	m_historyIndex = writeIndex;
+	int historyRead = pFrameGraph->ImportTarget("ssaoHistoryRead",
+		m_pRenderTargetPool->GetFramebuffer(m_historyTargets[readIndex]),
+		m_pRenderTargetPool->GetTexture(m_historyTargets[readIndex]),
+		m_occlusionWidth, m_occlusionHeight);
+	int historyWrite = pFrameGraph->ImportTarget("ssaoHistoryWrite",
+		m_pRenderTargetPool->GetFramebuffer(m_historyTargets[writeIndex]),
+		m_pRenderTargetPool->GetTexture(m_historyTargets[writeIndex]),
+		m_occlusionWidth, m_occlusionHeight);
+	int occlusion = pFrameGraph->CreateTarget("ssao", m_occlusionWidth, m_occlusionHeight,
+		g_OcclusionFormat);
+
+	// only one timing is in flight, so reading it back never stalls
+	bool bTimed = (m_bTimerPending == false);
+
+	pFrameGraph->AddPass("ssao", { sceneDepth, sceneSurface }, { occlusion },
+		[this, sceneDepth, sceneSurface, bTimed]()
+		{
+			// the depth was rasterized with the jittered projection
+			glm::mat4 projection = m_pViewManager->GetProjectionMatrix();
+			glm::vec2 jitter = m_pViewManager->GetProjectionJitter();
+			projection[2][0] -= jitter.x;
+			projection[2][1] -= jitter.y;
+
+			if (bTimed == true)
+			{
+				glBeginQuery(GL_TIME_ELAPSED, m_timerQuery);
+			}
+
+			PipelineState::Bind(m_occlusionState);
+			m_pOcclusionShader->setMat4Value("projection", projection);
+			m_pOcclusionShader->setMat4Value("inverseProjection", glm::inverse(projection));
+			m_pOcclusionShader->setFloatValue("radius", m_settings.radius);
+			m_pOcclusionShader->setIntValue("sampleCount", m_settings.sampleCount);
+			m_pOcclusionShader->setIntValue("frameIndex", m_frameIndex);
+			FullscreenPass::BindTexture(m_pOcclusionShader, "depthTexture", 0, m_pFrameGraph->GetTexture(sceneDepth));
+			FullscreenPass::BindTexture(m_pOcclusionShader, "surfaceTexture", 1, m_pFrameGraph->GetTexture(sceneSurface));
+			FullscreenPass::Draw();
+		});
+
+	pFrameGraph->AddPass("ssaoTemporal", { occlusion, historyRead }, { historyWrite },
+		[this, occlusion, historyRead]()
+		{
+			glm::mat4 view = m_pViewManager->GetViewMatrix();
+			glm::mat4 inverseView = glm::inverse(view);
+			glm::mat4 projection = m_pViewManager->GetProjectionMatrix();
+			glm::vec2 jitter = m_pViewManager->GetProjectionJitter();
+			projection[2][0] -= jitter.x;
+			projection[2][1] -= jitter.y;
+			glm::mat4 viewProjection = projection * view;
+
+			PipelineState::Bind(m_temporalState);
+			m_pTemporalShader->setMat4Value("inverseViewProjection", glm::inverse(viewProjection));
+			m_pTemporalShader->setMat4Value("previousViewProjection", m_pViewManager->GetPreviousViewProjection());
+			m_pTemporalShader->setVec3Value("viewPosition", glm::vec3(inverseView[3].x, inverseView[3].y, inverseView[3].z));
+			m_pTemporalShader->setBoolValue("bHistoryValid", m_bHistoryValid);
+			m_pTemporalShader->setFloatValue("historyWeight", m_settings.historyWeight);
+			FullscreenPass::BindTexture(m_pTemporalShader, "currentTexture", 0, m_pFrameGraph->GetTexture(occlusion));
+			FullscreenPass::BindTexture(m_pTemporalShader, "historyTexture", 1, m_pFrameGraph->GetTexture(historyRead));
+			FullscreenPass::Draw();
+
+			m_bHistoryValid = true;
+		});
+
+	// the HDR color is multiplied by the occlusion
+	pFrameGraph->AddPass("ssaoApply", { historyWrite, sceneDepth, hdrColor }, { hdrColor },
+		[this, historyWrite, sceneDepth, bTimed]()
+		{
+			glm::mat4 view = m_pViewManager->GetViewMatrix();
+			glm::mat4 inverseView = glm::inverse(view);
+			glm::mat4 projection = m_pViewManager->GetProjectionMatrix();
+			glm::vec2 jitter = m_pViewManager->GetProjectionJitter();
+			projection[2][0] -= jitter.x;
+			projection[2][1] -= jitter.y;
+			glm::mat4 viewProjection = projection * view;
+
+			PipelineState::Bind(m_applyState);
+			m_pApplyShader->setMat4Value("inverseViewProjection", glm::inverse(viewProjection));
+			m_pApplyShader->setVec3Value("viewPosition", glm::vec3(inverseView[3].x, inverseView[3].y, inverseView[3].z));
+			m_pApplyShader->setFloatValue("intensity", m_settings.intensity);
+			FullscreenPass::BindTexture(m_pApplyShader, "occlusionTexture", 0, m_pFrameGraph->GetTexture(historyWrite));
+			FullscreenPass::BindTexture(m_pApplyShader, "depthTexture", 1, m_pFrameGraph->GetTexture(sceneDepth));
+			FullscreenPass::Draw();
+
+			if (bTimed == true)
+			{
+				glEndQuery(GL_TIME_ELAPSED);
+				m_bTimerPending = true;
+			}
+		});
+}
+
+/***********************************************************
+ *  GetAverageTime()
+ *
+ *  This method is used for getting the average GPU time of
+ *  the occlusion passes over the last report.
+ ***********************************************************/
+float AmbientOcclusion::GetAverageTime() const
+{
+	return(m_averageTime);
+}
+
+/***********************************************************
+ *  UpdateTiming()
+ *
+ *  This method is used for reading back the time of the last
+ *  timed frame, once the GPU has it, and printing the average
+ *  every few hundred timings.  The result is only read when
+ *  available, so the CPU never waits on the GPU.
+ ***********************************************************/
+void AmbientOcclusion::UpdateTiming()
+{
+	if ((m_bTimerPending == false) || (m_timerQuery == 0))
+	{
+		return;
+	}
+
+	GLint bAvailable = 0;
+	glGetQueryObjectiv(m_timerQuery, GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+	if (bAvailable == 0)
+	{
+		return;
+	}
+
+	GLuint64 elapsed = 0;
+	glGetQueryObjectui64v(m_timerQuery, GL_QUERY_RESULT, &elapsed);
+	m_bTimerPending = false;
+
+	m_timeSum += elapsed / 1000000.0f;
+	m_timeCount++;
+	if (m_timeCount >= g_TimingsPerReport)
+	{
+		m_averageTime = m_timeSum / m_timeCount;
+		m_timeSum = 0.0f;
+		m_timeCount = 0;
+		std::cout << "INFO: Ambient occlusion " << m_averageTime << " ms at "
+			<< m_settings.sampleCount << " samples" << std::endl;
+	}
+}
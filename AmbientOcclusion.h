@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////////
+// ambientocclusion.h
+// ============
+// manage the screen space ambient occlusion - contact shading computed at
+// half resolution with temporal reuse and depth aware upsample
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "PipelineState.h"
+#include "ViewManager.h"
+#include "FrameGraph.h"
+#include "RenderTargetPool.h"
+
+/***********************************************************
+ *  AmbientOcclusion
+ *
+ *  This class contains the code for darkening creases and
+ *  contact points.  A few samples in the hemisphere above
+ *  each half resolution pixel are tested against the resolved
+ *  depth, rotated every frame so the history turns them into
+ *  many.  The forward pass has no separate ambient target, so
+ *  the upsampled occlusion multiplies the HDR color before the
+ *  reflections and the light shafts are added.  The passes are
+ *  timed together and the average cost is reported.
+ ***********************************************************/
+class AmbientOcclusion
+{
+public:
+	// constructor
+	AmbientOcclusion(ViewManager* pViewManager);
+	// destructor
+	~AmbientOcclusion();
+
+	// adjustable settings for the occlusion
+	struct SSAO_SETTINGS
+	{
+		bool bEnabled;
+		// radius of the sampled hemisphere in world units
+		float radius;
+		// exponent of the occlusion, above 1 darkens it
+		float intensity;
+		// samples per pixel each frame
+		int sampleCount;
+		// share of last frame's result kept each frame
+		float historyWeight;
+	};
+
+	// load the shaders and create the persistent targets
+	bool Create(int width, int height, RenderTargetPool* pRenderTargetPool);
+	// free the shaders and OpenGL objects
+	void Destroy();
+
+	// add the passes that compute the occlusion and apply it to
+	// the resolved HDR color
+	void AddPasses(FrameGraph* pFrameGraph, int hdrColor, int sceneDepth, int sceneSurface);
+
+	// average GPU time of the passes in milliseconds, 0 before the
+	// first timing is read back
+	float GetAverageTime() const;
+
+	// settings used by the next call to AddPasses()
+	SSAO_SETTINGS m_settings;
+
+private:
+	// pointer to the view manager for the camera matrices
+	ViewManager* m_pViewManager;
+	// pool that owns the history targets
+	RenderTargetPool* m_pRenderTargetPool;
+	// frame graph the passes were added to
+	FrameGraph* m_pFrameGraph;
+	// one shader program per pass
+	ShaderManager* m_pOcclusionShader;
+	ShaderManager* m_pTemporalShader;
+	ShaderManager* m_pApplyShader;
+	// the state each pass draws with
+	PipelineState m_occlusionState;
+	PipelineState m_temporalState;
+	PipelineState m_applyState;
+	// occlusion history, read and written on alternate frames
+	int m_historyTargets[2];
+	int m_historyIndex;
+	bool m_bHistoryValid;
+	// changes the rotation of the samples every frame
+	int m_frameIndex;
+	// GPU timer across the passes, and the timings summed so far
+	GLuint m_timerQuery;
+	bool m_bTimerPending;
+	float m_timeSum;
+	int m_timeCount;
+	float m_averageTime;
+	// size of the scene and of the occlusion in pixels
+	int m_width;
+	int m_height;
+	int m_occlusionWidth;
+	int m_occlusionHeight;
+
+	// read the last timing and report the average now and then
+	void UpdateTiming();
+};
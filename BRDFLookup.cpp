@@ -0,0 +1,259 @@
+///////////////////////////////////////////////////////////////////////////////
+// brdflookup.cpp
+// ============
+// manage the split-sum BRDF lookup texture used by the metallic/roughness
+// lighting - generated once and cached on disk
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BRDFLookup.h"
+#include "GLDebug.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// declare the global variables and helper functions
+namespace
+{
+	// edge of the lookup table in texels
+	const int g_TableSize = 128;
+	// GGX samples integrated per texel
+	const int g_SampleCount = 256;
+	// identifies a cache file written by this version of the code
+	const char g_CacheMagic[4] = { 'B', 'R', 'D', 'F' };
+	const int g_CacheVersion = 1;
+
+	const float g_Pi = 3.14159265f;
+
+	/***********************************************************
+	 *  RadicalInverse()
+	 *
+	 *  Returns the Van der Corput radical inverse of the passed
+	 *  in index, the second coordinate of the Hammersley set.
+	 ***********************************************************/
+	float RadicalInverse(unsigned int bits)
+	{
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return(bits * 2.3283064365386963e-10f);
+	}
+
+	/***********************************************************
+	 *  IntegrateBRDF()
+	 *
+	 *  Returns the F0 scale (A) and bias (B) of the GGX BRDF
+	 *  for the passed in NdotV and roughness, by importance
+	 *  sampling halfway vectors around the normal (0, 0, 1).
+	 ***********************************************************/
+	void IntegrateBRDF(float NdotV, float roughness, float& A, float& B)
+	{
+		float viewX = std::sqrt(1.0f - NdotV * NdotV);
+		float viewZ = NdotV;
+		float alpha = roughness * roughness;
+		// Smith-Schlick k for image based lighting
+		float k = alpha * 0.5f;
+
+		A = 0.0f;
+		B = 0.0f;
+		for (int i = 0; i < g_SampleCount; i++)
+		{
+			float u = (float)i / g_SampleCount;
+			float v = RadicalInverse(i);
+
+			// halfway vector from the GGX distribution
+			float phi = 2.0f * g_Pi * u;
+			float cosTheta = std::sqrt((1.0f - v) / (1.0f + (alpha * alpha - 1.0f) * v));
+			float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+			float halfX = sinTheta * std::cos(phi);
+			float halfZ = cosTheta;
+
+			// reflect the view direction about it
+			float VdotH = viewX * halfX + viewZ * halfZ;
+			float lightZ = 2.0f * VdotH * halfZ - viewZ;
+
+			float NdotL = lightZ;
+			float NdotH = halfZ;
+			if ((NdotL > 0.0f) && (VdotH > 0.0f))
+			{
+				float G = (NdotV / (NdotV * (1.0f - k) + k)) * (NdotL / (NdotL * (1.0f - k) + k));
+				float visibility = G * VdotH / (NdotH * NdotV);
+				float fresnel = std::pow(1.0f - VdotH, 5.0f);
+				A += (1.0f - fresnel) * visibility;
+				B += fresnel * visibility;
+			}
+		}
+		A /= g_SampleCount;
+		B /= g_SampleCount;
+	}
+}
+
+/***********************************************************
+ *  BRDFLookup()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BRDFLookup::BRDFLookup()
+{
+	m_textureID = 0;
+}
+
+/***********************************************************
+ *  ~BRDFLookup()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+BRDFLookup::~BRDFLookup()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the lookup texture.  The
+ *  table is read from the cache file when it holds a table
+ *  of the current size, otherwise it is integrated here and
+ *  the cache is written for the next run.
+ ***********************************************************/
+bool BRDFLookup::Create(const char* cacheFile)
+{
+	std::vector<float> table;
+
+	if (LoadCache(cacheFile, table) == true)
+	{
+		std::cout << "INFO: Loaded BRDF lookup from " << cacheFile << std::endl;
+	}
+	else
+	{
+		Generate(table);
+		if (SaveCache(cacheFile, table) == true)
+		{
+			std::cout << "INFO: Generated BRDF lookup, cached in " << cacheFile << std::endl;
+		}
+		else
+		{
+			std::cout << "INFO: Generated BRDF lookup, could not write " << cacheFile << std::endl;
+		}
+	}
+
+	glGenTextures(1, &m_textureID);
+	glBindTexture(GL_TEXTURE_2D, m_textureID);
+	GL_DEBUG_LABEL(GL_TEXTURE, m_textureID, "BRDF lookup");
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, g_TableSize, g_TableSize, 0,
+		GL_RG, GL_FLOAT, table.data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the lookup texture.
+ ***********************************************************/
+void BRDFLookup::Destroy()
+{
+	if (m_textureID != 0)
+	{
+		glDeleteTextures(1, &m_textureID);
+		m_textureID = 0;
+	}
+}
+
+/***********************************************************
+ *  GetTexture()
+ *
+ *  This method is used for getting the lookup texture, with
+ *  NdotV along U and roughness along V.
+ ***********************************************************/
+GLuint BRDFLookup::GetTexture() const
+{
+	return(m_textureID);
+}
+
+/***********************************************************
+ *  Generate()
+ *
+ *  This method is used for integrating the table at the
+ *  center of every texel.
+ ***********************************************************/
+void BRDFLookup::Generate(std::vector<float>& table)
+{
+	table.resize(g_TableSize * g_TableSize * 2);
+
+	for (int y = 0; y < g_TableSize; y++)
+	{
+		float roughness = (y + 0.5f) / g_TableSize;
+		for (int x = 0; x < g_TableSize; x++)
+		{
+			float NdotV = (x + 0.5f) / g_TableSize;
+			float A = 0.0f;
+			float B = 0.0f;
+			IntegrateBRDF(NdotV, roughness, A, B);
+			table[(y * g_TableSize + x) * 2] = A;
+			table[(y * g_TableSize + x) * 2 + 1] = B;
+		}
+	}
+}
+
+/***********************************************************
+ *  LoadCache()
+ *
+ *  This method is used for reading the table from the cache
+ *  file.  Returns false when the file is missing or was
+ *  written with a different size, sample count or version.
+ ***********************************************************/
+bool BRDFLookup::LoadCache(const char* cacheFile, std::vector<float>& table)
+{
+	std::ifstream file(cacheFile, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	char magic[4];
+	int header[3] = { 0, 0, 0 };
+	file.read(magic, sizeof(magic));
+	file.read((char*)header, sizeof(header));
+	if ((!file) ||
+		(std::memcmp(magic, g_CacheMagic, sizeof(magic)) != 0) ||
+		(header[0] != g_CacheVersion) ||
+		(header[1] != g_TableSize) ||
+		(header[2] != g_SampleCount))
+	{
+		return false;
+	}
+
+	table.resize(g_TableSize * g_TableSize * 2);
+	file.read((char*)table.data(), table.size() * sizeof(float));
+	return(file.good());
+}
+
+/***********************************************************
+ *  SaveCache()
+ *
+ *  This method is used for writing the table to the cache
+ *  file, behind a header that identifies how it was made.
+ ***********************************************************/
+bool BRDFLookup::SaveCache(const char* cacheFile, const std::vector<float>& table)
+{
+	std::ofstream file(cacheFile, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	int header[3] = { g_CacheVersion, g_TableSize, g_SampleCount };
+	file.write(g_CacheMagic, sizeof(g_CacheMagic));
+	file.write((const char*)header, sizeof(header));
+	file.write((const char*)table.data(), table.size() * sizeof(float));
+	return(file.good());
+}
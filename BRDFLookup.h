@@ -0,0 +1,50 @@
+///////////////////////////////////////////////////////////////////////////////
+// brdflookup.h
+// ============
+// manage the split-sum BRDF lookup texture used by the metallic/roughness
+// lighting - generated once and cached on disk
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/***********************************************************
+ *  BRDFLookup
+ *
+ *  This class contains the code for the split-sum lookup
+ *  table of the GGX specular BRDF.  For every NdotV and
+ *  roughness it holds the scale and bias applied to F0, so
+ *  the shader gets the integrated reflection with one texture
+ *  read.  The table is expensive to integrate, so it is
+ *  written to a cache file and loaded from there next time.
+ ***********************************************************/
+class BRDFLookup
+{
+public:
+	// constructor
+	BRDFLookup();
+	// destructor
+	~BRDFLookup();
+
+	// load the table from the cache file, or generate and cache it
+	bool Create(const char* cacheFile);
+	// free the texture
+	void Destroy();
+
+	// the RG16F lookup texture
+	GLuint GetTexture() const;
+
+private:
+	// lookup texture created from the table
+	GLuint m_textureID;
+
+	// integrate the table by importance sampling the GGX lobe
+	void Generate(std::vector<float>& table);
+	// read the table from the cache, false if missing or stale
+	bool LoadCache(const char* cacheFile, std::vector<float>& table);
+	// write the table to the cache
+	bool SaveCache(const char* cacheFile, const std::vector<float>& table);
+};
@@ -0,0 +1,183 @@
+///////////////////////////////////////////////////////////////////////////////
+// debugviews.cpp
+// ============
+// manage the diagnostic views of the scene - wireframe, overdraw, light count
+// and mip level, switched at run time in place of the post chain
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DebugViews.h"
+#include "FullscreenPass.h"
+
+#include <iostream>
+
+// declare the global variables
+namespace
+{
+	const char* g_DebugViewName = "debugView";
+
+	// names printed when the view changes, by DEBUG_VIEW
+	const char* g_ViewNames[DebugViews::VIEW_COUNT] = {
+		"off", "wireframe", "overdraw", "light count", "mip level" };
+}
+
+/***********************************************************
+ *  DebugViews()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DebugViews::DebugViews(ViewManager* pViewManager, ShaderManager* pSceneShader)
+{
+	m_pViewManager = pViewManager;
+	m_pSceneShader = pSceneShader;
+	m_pHeatMapShader = NULL;
+	m_pFrameGraph = NULL;
+
+	m_settings.view = VIEW_OFF;
+	m_settings.maxOverdraw = 8.0f;
+	m_settings.maxLightCount = 7.0f;
+}
+
+/***********************************************************
+ *  ~DebugViews()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DebugViews::~DebugViews()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for loading the heat map shader.
+ ***********************************************************/
+bool DebugViews::Create()
+{
+	m_pHeatMapShader = FullscreenPass::LoadShader("debugViewFragmentShader.glsl");
+	m_heatMapState = FullscreenPass::GetState(m_pHeatMapShader);
+
+	// back faces are culled like in the lit scene, so the views
+	// count the triangles the scene really rasterizes.  The lines
+	// are pulled towards the camera so they win the depth test
+	// against their own filled triangles.
+	GLuint sceneProgram = PipelineState::GetProgram(m_pSceneShader);
+	m_overdrawState = PipelineState(sceneProgram, PipelineState::BLEND_ADDITIVE,
+		PipelineState::DEPTH_OFF, true, PipelineState::CULL_BACK);
+	m_wireframeState = PipelineState(sceneProgram, PipelineState::BLEND_NONE,
+		PipelineState::DEPTH_LEQUAL, false, PipelineState::CULL_BACK, PipelineState::RASTER_LINES);
+	return(NULL != m_pHeatMapShader);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shader program.
+ ***********************************************************/
+void DebugViews::Destroy()
+{
+	if (NULL != m_pHeatMapShader)
+	{
+		delete m_pHeatMapShader;
+		m_pHeatMapShader = NULL;
+	}
+	m_pFrameGraph = NULL;
+}
+
+/***********************************************************
+ *  NextView()
+ *
+ *  This method is used for stepping to the next view.
+ ***********************************************************/
+void DebugViews::NextView()
+{
+	m_settings.view = (DEBUG_VIEW)((m_settings.view + 1) % VIEW_COUNT);
+	std::cout << "INFO: Debug view " << g_ViewNames[m_settings.view] << std::endl;
+}
+
+/***********************************************************
+ *  IsActive()
+ *
+ *  This method is used for checking whether a view replaces
+ *  the lit scene this frame.
+ ***********************************************************/
+bool DebugViews::IsActive() const
+{
+	return((m_settings.view != VIEW_OFF) && (NULL != m_pHeatMapShader));
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for drawing the scene for the view.
+ *  The overdraw view adds one for every fragment with the
+ *  depth test off, so hidden surfaces are counted too.  The
+ *  wireframe view draws the lit scene, then the scene again
+ *  as lines on top of it - the scene program is built by the
+ *  shader manager from a vertex and a fragment stage only, so
+ *  there is no geometry stage to hand the fragments their
+ *  barycentric coordinates in a single pass.
+ ***********************************************************/
+void DebugViews::RenderScene(std::function<void()> renderScene)
+{
+	if ((NULL == m_pSceneShader) || (IsActive() == false))
+	{
+		renderScene();
+		return;
+	}
+
+	PipelineState saved = PipelineState::GetCurrent();
+	switch (m_settings.view)
+	{
+	case VIEW_WIREFRAME:
+		m_pSceneShader->setIntValue(g_DebugViewName, VIEW_OFF);
+		renderScene();
+
+		PipelineState::Bind(m_wireframeState);
+		m_pSceneShader->setIntValue(g_DebugViewName, VIEW_WIREFRAME);
+		renderScene();
+		break;
+
+	case VIEW_OVERDRAW:
+		PipelineState::Bind(m_overdrawState);
+		m_pSceneShader->setIntValue(g_DebugViewName, VIEW_OVERDRAW);
+		renderScene();
+		break;
+
+	default:
+		m_pSceneShader->setIntValue(g_DebugViewName, m_settings.view);
+		renderScene();
+		break;
+	}
+
+	// the probe and the light depth maps draw the scene too
+	PipelineState::Bind(saved.WithProgram(m_wireframeState.GetProgram()));
+	m_pSceneShader->setIntValue(g_DebugViewName, VIEW_OFF);
+}
+
+/***********************************************************
+ *  AddPasses()
+ *
+ *  This method is used for adding the heat map pass.  The
+ *  jitter is cleared since nothing accumulates the frames.
+ ***********************************************************/
+void DebugViews::AddPasses(FrameGraph* pFrameGraph, int hdrColor, int backBuffer)
+{
+	if ((NULL == pFrameGraph) || (IsActive() == false))
+	{
+		return;
+	}
+	m_pFrameGraph = pFrameGraph;
+	m_pViewManager->SetProjectionJitter(glm::vec2(0.0f));
+
+	pFrameGraph->AddPass("debugView", { hdrColor }, { backBuffer },
+		[this, hdrColor]()
+		{
+			PipelineState::Bind(m_heatMapState);
+			m_pHeatMapShader->setIntValue(g_DebugViewName, m_settings.view);
+			m_pHeatMapShader->setFloatValue("maxOverdraw", m_settings.maxOverdraw);
+			m_pHeatMapShader->setFloatValue("maxLightCount", m_settings.maxLightCount);
+			FullscreenPass::BindTexture(m_pHeatMapShader, "sceneTexture", 0, m_pFrameGraph->GetTexture(hdrColor));
+			FullscreenPass::Draw();
+		});
+}
@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////////
+// debugviews.h
+// ============
+// manage the diagnostic views of the scene - wireframe, overdraw, light count
+// and mip level, switched at run time in place of the post chain
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "PipelineState.h"
+#include "ViewManager.h"
+#include "FrameGraph.h"
+
+#include <functional>
+
+/***********************************************************
+ *  DebugViews
+ *
+ *  This class contains the code for showing where the fill
+ *  rate of the scene goes.  In a debug view the scene shader
+ *  writes what the view measures in place of the lit color,
+ *  and one fullscreen pass turns it into a heat map in the
+ *  back buffer.  The screen space passes and the post chain
+ *  are skipped, so the numbers are not blurred or blended
+ *  over frames.
+ ***********************************************************/
+class DebugViews
+{
+public:
+	// constructor
+	DebugViews(ViewManager* pViewManager, ShaderManager* pSceneShader);
+	// destructor
+	~DebugViews();
+
+	// the views, in the order the key steps through them.  The
+	// values are the debugView modes of the scene shader.
+	enum DEBUG_VIEW
+	{
+		VIEW_OFF = 0,
+		// the lit scene with the triangle edges drawn over it
+		VIEW_WIREFRAME = 1,
+		// fragments shaded per pixel, with no depth test
+		VIEW_OVERDRAW = 2,
+		// lights that ran the full BRDF for the visible surface
+		VIEW_LIGHT_COUNT = 3,
+		// mip level the base texture is sampled at
+		VIEW_MIP_LEVEL = 4,
+		VIEW_COUNT = 5
+	};
+
+	// adjustable settings for the views
+	struct DEBUG_SETTINGS
+	{
+		DEBUG_VIEW view;
+		// counts shown at the hot end of the heat map
+		float maxOverdraw;
+		float maxLightCount;
+	};
+
+	// load the heat map shader
+	bool Create();
+	// free the shader
+	void Destroy();
+
+	// step to the next view, back to off after the last one
+	void NextView();
+	// true when a view replaces the lit scene
+	bool IsActive() const;
+
+	// draw the scene through renderScene with the state and the
+	// scene shader mode of the current view
+	void RenderScene(std::function<void()> renderScene);
+	// add the pass that draws the view into the back buffer
+	void AddPasses(FrameGraph* pFrameGraph, int hdrColor, int backBuffer);
+
+	// settings used by the next frame
+	DEBUG_SETTINGS m_settings;
+
+private:
+	// pointer to the view manager, whose jitter is cleared
+	ViewManager* m_pViewManager;
+	// pointer to the scene shader the modes are set on
+	ShaderManager* m_pSceneShader;
+	// shader program for the heat map
+	ShaderManager* m_pHeatMapShader;
+	// the state each pass draws with
+	PipelineState m_heatMapState;
+	// the scene drawn for the overdraw and the wireframe views
+	PipelineState m_overdrawState;
+	PipelineState m_wireframeState;
+	// frame graph the pass was added to
+	FrameGraph* m_pFrameGraph;
+};
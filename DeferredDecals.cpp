@@ -0,0 +1,329 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferreddecals.cpp
+// ============
+// manage the box projected decals - stickers, labels and stains drawn over
+// the lit scene in screen space with one instanced draw
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DeferredDecals.h"
+#include "FullscreenPass.h"
+#include "GLDebug.h"
+
+#include "stb_image.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <iostream>
+
+// declare the global variables
+namespace
+{
+	const char* g_DecalVertexShader = "../../Utilities/shaders/decalVertexShader.glsl";
+	const char* g_DecalFragmentShader = "../../Utilities/shaders/decalFragmentShader.glsl";
+
+	// every decal image is resampled to one layer of this size
+	const int g_DecalTextureSize = 256;
+	const int g_MaxDecalTextures = 8;
+
+	// unit cube, counter-clockwise from the outside - 6 faces of
+	// 2 triangles
+	const float g_CubeVertices[] = {
+		// +Z
+		-0.5f, -0.5f, 0.5f,  0.5f, -0.5f, 0.5f,  0.5f, 0.5f, 0.5f,
+		-0.5f, -0.5f, 0.5f,  0.5f, 0.5f, 0.5f,  -0.5f, 0.5f, 0.5f,
+		// -Z
+		0.5f, -0.5f, -0.5f,  -0.5f, -0.5f, -0.5f,  -0.5f, 0.5f, -0.5f,
+		0.5f, -0.5f, -0.5f,  -0.5f, 0.5f, -0.5f,  0.5f, 0.5f, -0.5f,
+		// +X
+		0.5f, -0.5f, 0.5f,  0.5f, -0.5f, -0.5f,  0.5f, 0.5f, -0.5f,
+		0.5f, -0.5f, 0.5f,  0.5f, 0.5f, -0.5f,  0.5f, 0.5f, 0.5f,
+		// -X
+		-0.5f, -0.5f, -0.5f,  -0.5f, -0.5f, 0.5f,  -0.5f, 0.5f, 0.5f,
+		-0.5f, -0.5f, -0.5f,  -0.5f, 0.5f, 0.5f,  -0.5f, 0.5f, -0.5f,
+		// +Y
+		-0.5f, 0.5f, 0.5f,  0.5f, 0.5f, 0.5f,  0.5f, 0.5f, -0.5f,
+		-0.5f, 0.5f, 0.5f,  0.5f, 0.5f, -0.5f,  -0.5f, 0.5f, -0.5f,
+		// -Y
+		-0.5f, -0.5f, -0.5f,  0.5f, -0.5f, -0.5f,  0.5f, -0.5f, 0.5f,
+		-0.5f, -0.5f, -0.5f,  0.5f, -0.5f, 0.5f,  -0.5f, -0.5f, 0.5f };
+	const int g_CubeVertexCount = 36;
+}
+
+/***********************************************************
+ *  DeferredDecals()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DeferredDecals::DeferredDecals(ViewManager* pViewManager)
+{
+	m_pViewManager = pViewManager;
+	m_pFrameGraph = NULL;
+	m_pDecalShader = NULL;
+	m_cubeVAO = 0;
+	m_cubeVBO = 0;
+	m_instanceVBO = 0;
+	m_textureArray = 0;
+	m_textureLayers = 0;
+	m_bInstancesDirty = false;
+}
+
+/***********************************************************
+ *  ~DeferredDecals()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DeferredDecals::~DeferredDecals()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for loading the decal shader and
+ *  creating the instanced cube and the empty texture array.
+ ***********************************************************/
+bool DeferredDecals::Create()
+{
+	m_pDecalShader = new ShaderManager();
+	m_pDecalShader->LoadShaders(g_DecalVertexShader, g_DecalFragmentShader);
+	GL_DEBUG_LABEL_SHADER(m_pDecalShader, "decals");
+
+	// only the far side of each box is drawn, so every covered
+	// pixel is shaded once even with the camera inside a box.
+	// The alpha is faded by the decal in both targets, which
+	// takes the reflectivity away under an opaque decal.
+	m_decalState = PipelineState(PipelineState::GetProgram(m_pDecalShader), PipelineState::BLEND_ALPHA_FADE,
+		PipelineState::DEPTH_OFF, true, PipelineState::CULL_FRONT);
+
+	glGenVertexArrays(1, &m_cubeVAO);
+	glGenBuffers(1, &m_cubeVBO);
+	glGenBuffers(1, &m_instanceVBO);
+	glBindVertexArray(m_cubeVAO);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_cubeVBO);
+	GL_DEBUG_LABEL(GL_BUFFER, m_cubeVBO, "decal cube");
+	glBufferData(GL_ARRAY_BUFFER, sizeof(g_CubeVertices), g_CubeVertices, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+
+	// the two matrices take four attributes each, then the color
+	// and the parameters - all advance once per decal
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	for (int i = 0; i < 10; i++)
+	{
+		glEnableVertexAttribArray(1 + i);
+		glVertexAttribPointer(1 + i, 4, GL_FLOAT, GL_FALSE, sizeof(DECAL_INSTANCE),
+			(void*)(i * sizeof(glm::vec4)));
+		glVertexAttribDivisor(1 + i, 1);
+	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glGenTextures(1, &m_textureArray);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureArray);
+	GL_DEBUG_LABEL(GL_TEXTURE, m_textureArray, "decal textures");
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, g_DecalTextureSize, g_DecalTextureSize,
+		g_MaxDecalTextures, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shader program, the
+ *  cube buffers and the texture array.
+ ***********************************************************/
+void DeferredDecals::Destroy()
+{
+	if (NULL != m_pDecalShader)
+	{
+		delete m_pDecalShader;
+		m_pDecalShader = NULL;
+	}
+	if (m_cubeVAO != 0)
+	{
+		glDeleteVertexArrays(1, &m_cubeVAO);
+		m_cubeVAO = 0;
+	}
+	if (m_cubeVBO != 0)
+	{
+		glDeleteBuffers(1, &m_cubeVBO);
+		m_cubeVBO = 0;
+	}
+	if (m_instanceVBO != 0)
+	{
+		glDeleteBuffers(1, &m_instanceVBO);
+		m_instanceVBO = 0;
+	}
+	if (m_textureArray != 0)
+	{
+		glDeleteTextures(1, &m_textureArray);
+		m_textureArray = 0;
+	}
+	m_textureLayers = 0;
+}
+
+/***********************************************************
+ *  LoadDecalTexture()
+ *
+ *  This method is used for loading a decal image into the
+ *  next free layer of the texture array.  The image is
+ *  resampled to the layer size on the CPU, since the layers
+ *  of an array all share one size.
+ ***********************************************************/
+int DeferredDecals::LoadDecalTexture(const char* filename)
+{
+	if ((m_textureArray == 0) || (m_textureLayers >= g_MaxDecalTextures))
+	{
+		std::cout << "Could not add decal texture " << filename << std::endl;
+		return(-1);
+	}
+
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+	stbi_set_flip_vertically_on_load(true);
+	unsigned char* image = stbi_load(filename, &width, &height, &colorChannels, 4);
+	if (NULL == image)
+	{
+		std::cout << "Could not load decal image " << filename << std::endl;
+		return(-1);
+	}
+
+	// bilinear resample into the layer size
+	std::vector<unsigned char> layer((size_t)g_DecalTextureSize * g_DecalTextureSize * 4);
+	for (int y = 0; y < g_DecalTextureSize; y++)
+	{
+		float sourceY = (y + 0.5f) * height / g_DecalTextureSize - 0.5f;
+		sourceY = (sourceY < 0.0f) ? 0.0f : sourceY;
+		int y0 = (int)sourceY;
+		int y1 = (y0 + 1 < height) ? y0 + 1 : height - 1;
+		float fy = sourceY - y0;
+		for (int x = 0; x < g_DecalTextureSize; x++)
+		{
+			float sourceX = (x + 0.5f) * width / g_DecalTextureSize - 0.5f;
+			sourceX = (sourceX < 0.0f) ? 0.0f : sourceX;
+			int x0 = (int)sourceX;
+			int x1 = (x0 + 1 < width) ? x0 + 1 : width - 1;
+			float fx = sourceX - x0;
+			for (int c = 0; c < 4; c++)
+			{
+				float top = image[(y0 * width + x0) * 4 + c] * (1.0f - fx) + image[(y0 * width + x1) * 4 + c] * fx;
+				float bottom = image[(y1 * width + x0) * 4 + c] * (1.0f - fx) + image[(y1 * width + x1) * 4 + c] * fx;
+				layer[((size_t)y * g_DecalTextureSize + x) * 4 + c] = (unsigned char)(top * (1.0f - fy) + bottom * fy + 0.5f);
+			}
+		}
+	}
+	stbi_image_free(image);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureArray);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, m_textureLayers,
+		g_DecalTextureSize, g_DecalTextureSize, 1, GL_RGBA, GL_UNSIGNED_BYTE, layer.data());
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	return(m_textureLayers++);
+}
+
+/***********************************************************
+ *  AddDecal()
+ *
+ *  This method is used for adding a decal to the instance
+ *  list.  The model matrix is built in the same order as the
+ *  scene objects, scale first and translation last.
+ ***********************************************************/
+void DeferredDecals::AddDecal(const DECAL& decal)
+{
+	glm::mat4 model =
+		glm::translate(decal.position) *
+		glm::rotate(glm::radians(decal.ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f)) *
+		glm::rotate(glm::radians(decal.YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f)) *
+		glm::rotate(glm::radians(decal.XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f)) *
+		glm::scale(decal.scale);
+
+	DECAL_INSTANCE instance;
+	instance.model = model;
+	instance.inverseModel = glm::inverse(model);
+	instance.color = decal.color;
+	instance.params = glm::vec4((float)decal.textureLayer, decal.bumpStrength, 0.0f, 0.0f);
+	m_instances.push_back(instance);
+	m_bInstancesDirty = true;
+}
+
+/***********************************************************
+ *  UpdateInstances()
+ *
+ *  This method is used for uploading the instance list after
+ *  decals were added.  Static decals are uploaded only once.
+ ***********************************************************/
+void DeferredDecals::UpdateInstances()
+{
+	if (m_bInstancesDirty == false)
+	{
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, m_instances.size() * sizeof(DECAL_INSTANCE),
+		m_instances.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	m_bInstancesDirty = false;
+}
+
+/***********************************************************
+ *  AddPasses()
+ *
+ *  This method is used for adding the decal pass to the frame
+ *  graph.  The pass blends into the resolved HDR color and
+ *  surface targets at once - the color is the decal albedo
+ *  lit by the stored diffuse light, and the surface gets the
+ *  bent normal with the reflectivity faded under the decal.
+ ***********************************************************/
+void DeferredDecals::AddPasses(FrameGraph* pFrameGraph, int hdrColor, int sceneSurface,
+	int sceneDepth, int sceneLighting)
+{
+	if ((NULL == pFrameGraph) || (NULL == m_pDecalShader) || (m_instances.size() == 0))
+	{
+		return;
+	}
+	m_pFrameGraph = pFrameGraph;
+
+	pFrameGraph->AddPass("decals", { sceneDepth, sceneLighting }, { hdrColor, sceneSurface },
+		[this, hdrColor, sceneDepth, sceneLighting]()
+		{
+			UpdateInstances();
+
+			// the boxes and the depth they read line up with the jittered
+			// scene
+			glm::mat4 view = m_pViewManager->GetViewMatrix();
+			glm::mat4 projection = m_pViewManager->GetProjectionMatrix();
+			glm::vec2 jitter = m_pViewManager->GetProjectionJitter();
+			projection[2][0] -= jitter.x;
+			projection[2][1] -= jitter.y;
+			glm::mat4 viewProjection = projection * view;
+
+			PipelineState::Bind(m_decalState);
+			m_pDecalShader->setMat4Value("viewProjection", viewProjection);
+			m_pDecalShader->setMat4Value("inverseViewProjection", glm::inverse(viewProjection));
+			m_pDecalShader->setMat4Value("view", view);
+			m_pDecalShader->setVec2Value("screenSize", glm::vec2(
+				m_pFrameGraph->GetWidth(hdrColor), m_pFrameGraph->GetHeight(hdrColor)));
+			FullscreenPass::BindTexture(m_pDecalShader, "depthTexture", 0, m_pFrameGraph->GetTexture(sceneDepth));
+			FullscreenPass::BindTexture(m_pDecalShader, "lightingTexture", 1, m_pFrameGraph->GetTexture(sceneLighting));
+			glActiveTexture(GL_TEXTURE16 + 2);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureArray);
+			m_pDecalShader->setSampler2DValue("decalTextures", 16 + 2);
+
+			glBindVertexArray(m_cubeVAO);
+			glDrawArraysInstanced(GL_TRIANGLES, 0, g_CubeVertexCount, (GLsizei)m_instances.size());
+			glBindVertexArray(0);
+		});
+}
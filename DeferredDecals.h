@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferreddecals.h
+// ============
+// manage the box projected decals - stickers, labels and stains drawn over
+// the lit scene in screen space with one instanced draw
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "PipelineState.h"
+#include "ViewManager.h"
+#include "FrameGraph.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  DeferredDecals
+ *
+ *  This class contains the code for projecting decals onto
+ *  whatever surface lies inside their box.  Each decal box is
+ *  one instance of a single cube draw - the fragments rebuild
+ *  the surface position from the resolved depth, replace the
+ *  albedo lit by the diffuse light the scene pass stored, and
+ *  bend the normal in the surface target the screen space
+ *  passes read.  The decal images share one texture array.
+ ***********************************************************/
+class DeferredDecals
+{
+public:
+	// constructor
+	DeferredDecals(ViewManager* pViewManager);
+	// destructor
+	~DeferredDecals();
+
+	// properties for one projected decal
+	struct DECAL
+	{
+		// the decal is projected down the box's local Y axis, with
+		// the image over its local X and Z
+		glm::vec3 position;
+		glm::vec3 scale;
+		float XrotationDegrees;
+		float YrotationDegrees;
+		float ZrotationDegrees;
+		// albedo of the decal, multiplied by the image when it has one
+		glm::vec4 color;
+		// layer of the decal texture array, -1 for a plain color
+		int textureLayer;
+		// height of the image brightness for the bent normal
+		float bumpStrength;
+	};
+
+	// load the shader and create the cube and the texture array
+	bool Create();
+	// free the shader and OpenGL objects
+	void Destroy();
+
+	// load an image into the next layer of the texture array and
+	// return the layer, or -1 if it could not be loaded
+	int LoadDecalTexture(const char* filename);
+	// add a decal to the instance list
+	void AddDecal(const DECAL& decal);
+
+	// add the pass that draws every decal over the resolved targets
+	void AddPasses(FrameGraph* pFrameGraph, int hdrColor, int sceneSurface,
+		int sceneDepth, int sceneLighting);
+
+private:
+	// per instance data read by the decal vertex shader
+	struct DECAL_INSTANCE
+	{
+		glm::mat4 model;
+		glm::mat4 inverseModel;
+		glm::vec4 color;
+		// texture layer, bump strength, unused, unused
+		glm::vec4 params;
+	};
+
+	// pointer to the view manager for the camera matrices
+	ViewManager* m_pViewManager;
+	// frame graph the pass was added to
+	FrameGraph* m_pFrameGraph;
+	// shader program for the decal boxes
+	ShaderManager* m_pDecalShader;
+	// far faces only, alpha blended with no depth test
+	PipelineState m_decalState;
+	// unit cube with the instance attributes
+	GLuint m_cubeVAO;
+	GLuint m_cubeVBO;
+	GLuint m_instanceVBO;
+	// decal images, one per layer
+	GLuint m_textureArray;
+	int m_textureLayers;
+	// decals added so far, uploaded when the list changes
+	std::vector<DECAL_INSTANCE> m_instances;
+	bool m_bInstancesDirty;
+
+	// upload the instance list if it changed
+	void UpdateInstances();
+};
@@ -0,0 +1,417 @@
+///////////////////////////////////////////////////////////////////////////////
+// distancefields.cpp
+// ============
+// manage the signed distance fields of the composite objects - baked once into
+// a 3D atlas and cone traced by the scene shader for soft shadows and occlusion
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DistanceFields.h"
+#include "GLDebug.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+// declare the global variables and helper functions
+namespace
+{
+	// samples along each side of a brick, and the bricks along each
+	// side of the atlas
+	const int g_BrickSize = 32;
+	const glm::ivec3 g_AtlasBricks = glm::ivec3(4, 2, 1);
+	const GLenum g_AtlasFormat = GL_R16F;
+	const int g_AtlasTextureUnit = 27;
+
+	// must match MAX_FIELD_OBJECTS in the scene shader
+	const int g_MaxObjects = 8;
+
+	// samples of empty space kept around each object, so the traces
+	// see the surface coming before they reach the bounds
+	const int g_BorderSamples = 2;
+
+	/***********************************************************
+	 *  GetModelAxes()
+	 *
+	 *  Splits a model matrix into its unit axes and the scale
+	 *  along them, and returns the point in those axes.
+	 ***********************************************************/
+	glm::vec3 GetModelAxes(const glm::mat4& model, glm::vec3 point, glm::vec3& scale)
+	{
+		glm::vec3 offset = point - glm::vec3(model[3]);
+		glm::vec3 local;
+		for (int i = 0; i < 3; i++)
+		{
+			glm::vec3 axis = glm::vec3(model[i]);
+			scale[i] = std::max(glm::length(axis), 0.0001f);
+			local[i] = glm::dot(offset, axis / scale[i]);
+		}
+		return(local);
+	}
+
+	/***********************************************************
+	 *  GetTriangleDistance()
+	 *
+	 *  Returns the distance from a point to the closest point
+	 *  of a triangle, and that point.
+	 ***********************************************************/
+	float GetTriangleDistance(glm::vec3 point, glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec3& closest)
+	{
+		glm::vec3 ab = b - a;
+		glm::vec3 ac = c - a;
+		glm::vec3 ap = point - a;
+
+		// the closest point is found by the region of the triangle's
+		// plane the point projects into - a corner, an edge or inside
+		float d1 = glm::dot(ab, ap);
+		float d2 = glm::dot(ac, ap);
+		if ((d1 <= 0.0f) && (d2 <= 0.0f))
+		{
+			closest = a;
+			return(glm::length(point - closest));
+		}
+
+		glm::vec3 bp = point - b;
+		float d3 = glm::dot(ab, bp);
+		float d4 = glm::dot(ac, bp);
+		if ((d3 >= 0.0f) && (d4 <= d3))
+		{
+			closest = b;
+			return(glm::length(point - closest));
+		}
+
+		float vc = d1 * d4 - d3 * d2;
+		if ((vc <= 0.0f) && (d1 >= 0.0f) && (d3 <= 0.0f))
+		{
+			closest = a + ab * (d1 / (d1 - d3));
+			return(glm::length(point - closest));
+		}
+
+		glm::vec3 cp = point - c;
+		float d5 = glm::dot(ab, cp);
+		float d6 = glm::dot(ac, cp);
+		if ((d6 >= 0.0f) && (d5 <= d6))
+		{
+			closest = c;
+			return(glm::length(point - closest));
+		}
+
+		float vb = d5 * d2 - d1 * d6;
+		if ((vb <= 0.0f) && (d2 >= 0.0f) && (d6 <= 0.0f))
+		{
+			closest = a + ac * (d2 / (d2 - d6));
+			return(glm::length(point - closest));
+		}
+
+		float va = d3 * d6 - d5 * d4;
+		if ((va <= 0.0f) && ((d4 - d3) >= 0.0f) && ((d5 - d6) >= 0.0f))
+		{
+			closest = b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+			return(glm::length(point - closest));
+		}
+
+		float denom = 1.0f / (va + vb + vc);
+		closest = a + ab * (vb * denom) + ac * (vc * denom);
+		return(glm::length(point - closest));
+	}
+}
+
+/***********************************************************
+ *  DistanceFields()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DistanceFields::DistanceFields()
+{
+	m_atlasID = 0;
+
+	m_settings.bEnabled = true;
+	m_settings.shadowLight = 0;
+	m_settings.shadowSteps = 16;
+	m_settings.occlusionSteps = 5;
+	m_settings.shadowConeWidth = 0.08f;
+	m_settings.shadowStart = 1.0f;
+	m_settings.shadowDistance = 60.0f;
+	m_settings.occlusionDistance = 4.0f;
+	m_settings.occlusionIntensity = 0.8f;
+}
+
+/***********************************************************
+ *  ~DistanceFields()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DistanceFields::~DistanceFields()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the atlas.  It is read
+ *  with linear filtering, so the traces get a smooth field
+ *  between the samples.
+ ***********************************************************/
+bool DistanceFields::Create()
+{
+	glm::ivec3 atlasSize = g_AtlasBricks * g_BrickSize;
+
+	glGenTextures(1, &m_atlasID);
+	glBindTexture(GL_TEXTURE_3D, m_atlasID);
+	GL_DEBUG_LABEL(GL_TEXTURE, m_atlasID, "distance field atlas");
+	glTexImage3D(GL_TEXTURE_3D, 0, g_AtlasFormat, atlasSize.x, atlasSize.y, atlasSize.z,
+		0, GL_RED, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_3D, 0);
+
+	return(m_atlasID != 0);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the atlas and forgetting
+ *  the objects baked into it.
+ ***********************************************************/
+void DistanceFields::Destroy()
+{
+	if (m_atlasID != 0)
+	{
+		glDeleteTextures(1, &m_atlasID);
+		m_atlasID = 0;
+	}
+	m_objects.clear();
+}
+
+/***********************************************************
+ *  AddObject()
+ *
+ *  This method is used for baking the field of an object
+ *  into the next free brick.  The brick spans the object's
+ *  bounding box plus a border, and each sample holds the
+ *  distance to the closest of the parts.  The slices of the
+ *  brick are spread over every hardware thread.
+ ***********************************************************/
+bool DistanceFields::AddObject(const std::string& tag, glm::vec3 center, glm::vec3 halfSize,
+	const std::vector<PART>& parts)
+{
+	int brickCount = g_AtlasBricks.x * g_AtlasBricks.y * g_AtlasBricks.z;
+	if ((m_atlasID == 0) || ((int)m_objects.size() >= std::min(brickCount, g_MaxObjects)))
+	{
+		std::cout << "ERROR: No room in the distance field atlas for " << tag << std::endl;
+		return false;
+	}
+
+	// the border grows the box so it is g_BorderSamples spacings
+	// wider on each side than the object
+	int spacings = g_BrickSize - 1;
+	glm::vec3 paddedHalf = halfSize * ((float)spacings / (float)(spacings - 2 * g_BorderSamples));
+
+	int index = (int)m_objects.size();
+	FIELD_OBJECT object;
+	object.tag = tag;
+	object.boundsMin = center - paddedHalf;
+	object.boundsMax = center + paddedHalf;
+	object.brick = glm::ivec3(index % g_AtlasBricks.x,
+		(index / g_AtlasBricks.x) % g_AtlasBricks.y,
+		index / (g_AtlasBricks.x * g_AtlasBricks.y));
+
+	// the face normals give the side of the closest triangle
+	// a sample is on
+	std::vector<std::vector<glm::vec3>> faceNormals(parts.size());
+	int triangleCount = 0;
+	for (int i = 0; i < (int)parts.size(); i++)
+	{
+		const std::vector<glm::vec3>& triangles = parts[i].triangles;
+		for (int j = 0; j + 2 < (int)triangles.size(); j += 3)
+		{
+			glm::vec3 normal = glm::cross(triangles[j + 1] - triangles[j], triangles[j + 2] - triangles[j]);
+			float length = glm::length(normal);
+			faceNormals[i].push_back((length > 0.0f) ? normal / length : glm::vec3(0.0f));
+		}
+		triangleCount += (int)faceNormals[i].size();
+	}
+
+	std::vector<float> samples((size_t)g_BrickSize * g_BrickSize * g_BrickSize);
+	glm::vec3 spacing = (object.boundsMax - object.boundsMin) / (float)spacings;
+	int threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+
+	// every thread takes every threadCount'th slice of the brick
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; t++)
+	{
+		threads.push_back(std::thread([&, t]()
+			{
+				for (int z = t; z < g_BrickSize; z += threadCount)
+				{
+					for (int y = 0; y < g_BrickSize; y++)
+					{
+						for (int x = 0; x < g_BrickSize; x++)
+						{
+							glm::vec3 point = object.boundsMin + glm::vec3(x, y, z) * spacing;
+							float distance = 1e30f;
+							for (int i = 0; i < (int)parts.size(); i++)
+							{
+								distance = std::min(distance, GetPartDistance(parts[i], faceNormals[i], point));
+							}
+							samples[((size_t)z * g_BrickSize + y) * g_BrickSize + x] = distance;
+						}
+					}
+				}
+			}));
+	}
+	for (int t = 0; t < threads.size(); t++)
+	{
+		threads[t].join();
+	}
+
+	glm::ivec3 offset = object.brick * g_BrickSize;
+	glBindTexture(GL_TEXTURE_3D, m_atlasID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexSubImage3D(GL_TEXTURE_3D, 0, offset.x, offset.y, offset.z,
+		g_BrickSize, g_BrickSize, g_BrickSize, GL_RED, GL_FLOAT, samples.data());
+	glBindTexture(GL_TEXTURE_3D, 0);
+
+	m_objects.push_back(object);
+
+	std::cout << "INFO: Baked distance field of " << tag << " from " << parts.size() << " parts ("
+		<< triangleCount << " triangles) on " << threadCount << " threads" << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  SetSamplerUnit()
+ *
+ *  This method is used for setting the unit of the atlas
+ *  sampler on the bound scene shader.  The scene manager
+ *  calls it before its first draw, long before the fields are
+ *  baked, since a 3D sampler left on unit 0 with the 2D
+ *  samplers fails every draw.
+ ***********************************************************/
+void DistanceFields::SetSamplerUnit(ShaderManager* pShader)
+{
+	if (NULL == pShader)
+	{
+		return;
+	}
+
+	pShader->setSampler2DValue("distanceAtlas", g_AtlasTextureUnit);
+}
+
+/***********************************************************
+ *  SetShaderValues()
+ *
+ *  This method is used for binding the atlas and setting the
+ *  bounds and brick of every object, and the trace settings,
+ *  on the bound scene shader.  The shader maps a world point
+ *  to the atlas as offset + (point - min) / (max - min) *
+ *  scale, which lands on the centers of the brick's samples.
+ ***********************************************************/
+void DistanceFields::SetShaderValues(ShaderManager* pShader)
+{
+	if (NULL == pShader)
+	{
+		return;
+	}
+
+	bool bEnabled = (m_settings.bEnabled == true) && (m_atlasID != 0) && (m_objects.empty() == false);
+	pShader->setBoolValue("bUseDistanceFields", bEnabled);
+	if (bEnabled == false)
+	{
+		return;
+	}
+
+	glm::vec3 atlasSize = glm::vec3(g_AtlasBricks * g_BrickSize);
+
+	glActiveTexture(GL_TEXTURE0 + g_AtlasTextureUnit);
+	glBindTexture(GL_TEXTURE_3D, m_atlasID);
+	glActiveTexture(GL_TEXTURE0);
+	pShader->setVec3Value("fieldBrickScale", glm::vec3((float)(g_BrickSize - 1)) / atlasSize);
+	pShader->setIntValue("fieldObjectCount", (int)m_objects.size());
+	for (int i = 0; i < (int)m_objects.size(); i++)
+	{
+		std::string index = "[" + std::to_string(i) + "]";
+		pShader->setVec3Value("fieldBoundsMin" + index, m_objects[i].boundsMin);
+		pShader->setVec3Value("fieldBoundsMax" + index, m_objects[i].boundsMax);
+		pShader->setVec3Value("fieldAtlasOffset" + index,
+			(glm::vec3(m_objects[i].brick * g_BrickSize) + 0.5f) / atlasSize);
+	}
+
+	pShader->setIntValue("fieldShadowLight", m_settings.shadowLight);
+	pShader->setIntValue("fieldShadowSteps", m_settings.shadowSteps);
+	pShader->setIntValue("fieldOcclusionSteps", m_settings.occlusionSteps);
+	pShader->setFloatValue("fieldShadowConeWidth", m_settings.shadowConeWidth);
+	pShader->setFloatValue("fieldShadowStart", m_settings.shadowStart);
+	pShader->setFloatValue("fieldShadowDistance", m_settings.shadowDistance);
+	pShader->setFloatValue("fieldOcclusionDistance", m_settings.occlusionDistance);
+	pShader->setFloatValue("fieldOcclusionIntensity", m_settings.occlusionIntensity);
+}
+
+/***********************************************************
+ *  GetPartDistance()
+ *
+ *  This method is used for finding the signed distance from
+ *  a point to one part.  The basic shapes are measured in
+ *  their own axes - exact for boxes, and close for stretched
+ *  spheres and cylinders, where the distance is scaled by the
+ *  smallest radius so it is never too long.  Meshes take the
+ *  closest of their triangles, and the sign from the side of
+ *  that triangle the point is on.
+ ***********************************************************/
+float DistanceFields::GetPartDistance(const PART& part, const std::vector<glm::vec3>& faceNormals, glm::vec3 point) const
+{
+	glm::vec3 scale;
+	glm::vec3 local = GetModelAxes(part.model, point, scale);
+
+	switch (part.shape)
+	{
+	case PART_BOX:
+		{
+			glm::vec3 q = glm::abs(local) - scale * 0.5f;
+			return(glm::length(glm::max(q, glm::vec3(0.0f))) +
+				std::min(std::max(q.x, std::max(q.y, q.z)), 0.0f));
+		}
+	case PART_CYLINDER:
+		{
+			float radial = glm::length(glm::vec2(local.x / scale.x, local.z / scale.z));
+			glm::vec2 q((radial - 1.0f) * std::min(scale.x, scale.z),
+				std::max(-local.y, local.y - scale.y));
+			return(glm::length(glm::max(q, glm::vec2(0.0f))) + std::min(std::max(q.x, q.y), 0.0f));
+		}
+	case PART_SPHERE:
+		{
+			float minRadius = std::min(scale.x, std::min(scale.y, scale.z));
+			return((glm::length(local / scale) - 1.0f) * minRadius);
+		}
+	default:
+		break;
+	}
+
+	// triangles sharing the closest edge or corner are equally
+	// close, the one facing the point most squarely gives the sign
+	float best = 1e30f;
+	float bestSide = 0.0f;
+	const std::vector<glm::vec3>& triangles = part.triangles;
+	for (int j = 0; j + 2 < (int)triangles.size(); j += 3)
+	{
+		glm::vec3 closest;
+		float distance = GetTriangleDistance(point, triangles[j], triangles[j + 1], triangles[j + 2], closest);
+		if (distance > best + 0.0001f)
+		{
+			continue;
+		}
+
+		float side = glm::dot(point - closest, faceNormals[j / 3]) / std::max(distance, 0.0001f);
+		if ((distance < best - 0.0001f) || (std::fabs(side) > std::fabs(bestSide)))
+		{
+			best = std::min(best, distance);
+			bestSide = side;
+		}
+	}
+	return((bestSide < 0.0f) ? -best : best);
+}
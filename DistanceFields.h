@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////////////////////////////////
+// distancefields.h
+// ============
+// manage the signed distance fields of the composite objects - baked once into
+// a 3D atlas and cone traced by the scene shader for soft shadows and occlusion
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include "ShaderManager.h"
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  DistanceFields
+ *
+ *  This class contains the code for the distance fields of
+ *  the static objects.  Each object gets one brick of the
+ *  atlas, a low resolution grid over its bounding box that
+ *  holds the distance to its nearest surface, negative
+ *  inside.  Boxes, cylinders and spheres are measured
+ *  exactly, every other mesh is voxelized from its triangles
+ *  on all hardware threads.  The scene shader marches cones
+ *  through the fields with a fixed number of steps - towards
+ *  the window light for a soft shadow, and along the normal
+ *  for the occlusion of the ambient light.
+ ***********************************************************/
+class DistanceFields
+{
+public:
+	// constructor
+	DistanceFields();
+	// destructor
+	~DistanceFields();
+
+	// the kinds of object parts, the unit shapes of the basic meshes
+	enum PART_SHAPE
+	{
+		// cube from -0.5 to 0.5
+		PART_BOX = 0,
+		// radius 1 from y = 0 to y = 1
+		PART_CYLINDER = 1,
+		// radius 1 around the origin
+		PART_SPHERE = 2,
+		// any other mesh, from its triangles
+		PART_MESH = 3
+	};
+
+	// one mesh of an object
+	struct PART
+	{
+		PART_SHAPE shape;
+		// model matrix the mesh was drawn with
+		glm::mat4 model;
+		// world space corners of the triangles of a PART_MESH,
+		// counterclockwise seen from outside
+		std::vector<glm::vec3> triangles;
+	};
+
+	// adjustable settings for the cone traces
+	struct FIELD_SETTINGS
+	{
+		bool bEnabled;
+		// index of the point light with the soft shadow, -1 for none
+		int shadowLight;
+		// steps of each cone, the fixed budget of the traces
+		int shadowSteps;
+		int occlusionSteps;
+		// width of the shadow cone per unit traced, wider is softer
+		float shadowConeWidth;
+		// the shadow trace starts this far from the surface, past the
+		// error of the coarse grid, and ends this far
+		float shadowStart;
+		float shadowDistance;
+		// height above the surface the occlusion reaches, and its
+		// strength
+		float occlusionDistance;
+		float occlusionIntensity;
+	};
+
+	// create the atlas
+	bool Create();
+	// free the atlas and the objects
+	void Destroy();
+
+	// bake the field of an object from its parts into the next brick,
+	// false when the atlas is full
+	bool AddObject(const std::string& tag, glm::vec3 center, glm::vec3 halfSize,
+		const std::vector<PART>& parts);
+	// set the atlas, the objects and the settings on the scene shader,
+	// which must be bound
+	void SetShaderValues(ShaderManager* pShader);
+	// give the 3D sampler of the bound scene shader its unit, which
+	// must happen before the shader draws anything
+	static void SetSamplerUnit(ShaderManager* pShader);
+
+	// settings used by the next SetShaderValues()
+	FIELD_SETTINGS m_settings;
+
+private:
+	// field of one object
+	struct FIELD_OBJECT
+	{
+		std::string tag;
+		// world space box the brick spans
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		// brick position in the atlas, in bricks
+		glm::ivec3 brick;
+	};
+
+	// 3D texture with one brick per object
+	GLuint m_atlasID;
+	std::vector<FIELD_OBJECT> m_objects;
+
+	// distance from a point to a part, negative inside
+	float GetPartDistance(const PART& part, const std::vector<glm::vec3>& faceNormals, glm::vec3 point) const;
+};
@@ -0,0 +1,557 @@
+///////////////////////////////////////////////////////////////////////////////
+// environmentprobe.cpp
+// ============
+// manage the environment cubemap captured from a probe in the room and
+// prefiltered into roughness levels for image based reflections
+///////////////////////////////////////////////////////////////////////////////
+
+#include "EnvironmentProbe.h"
+#include "GLDebug.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+// declare the global variables and helper functions
+namespace
+{
+	const char* g_EnvironmentValueName = "environmentTexture";
+	const char* g_UseEnvironmentName = "bUseEnvironment";
+	const char* g_EnvironmentLevelsName = "environmentMaxLevel";
+
+	// the cubemap is bound once, after the BRDF lookup
+	const int g_EnvironmentTextureUnit = 25;
+	// edge of the captured faces in texels
+	const int g_CaptureSize = 128;
+	// number of roughness levels, the last one is 4x4
+	const int g_LevelCount = 6;
+	// GGX samples per prefiltered texel
+	const int g_SampleCount = 128;
+	// identifies a cache file written by this version of the code
+	const char g_CacheMagic[4] = { 'E', 'N', 'V', 'P' };
+	const int g_CacheVersion = 1;
+
+	const float g_Pi = 3.14159265f;
+
+	// view direction and up vector of each cubemap face
+	const glm::vec3 g_FaceDirections[6] = {
+		glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f) };
+	const glm::vec3 g_FaceUps[6] = {
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f) };
+
+	/***********************************************************
+	 *  GetTexelDirection()
+	 *
+	 *  Returns the direction through the passed in face
+	 *  coordinates (-1 to 1), following the OpenGL cubemap
+	 *  face layout.
+	 ***********************************************************/
+	glm::vec3 GetTexelDirection(int face, float u, float v)
+	{
+		switch (face)
+		{
+		case 0: return(glm::normalize(glm::vec3(1.0f, -v, -u)));
+		case 1: return(glm::normalize(glm::vec3(-1.0f, -v, u)));
+		case 2: return(glm::normalize(glm::vec3(u, 1.0f, v)));
+		case 3: return(glm::normalize(glm::vec3(u, -1.0f, -v)));
+		case 4: return(glm::normalize(glm::vec3(u, -v, 1.0f)));
+		default: return(glm::normalize(glm::vec3(-u, -v, -1.0f)));
+		}
+	}
+
+	/***********************************************************
+	 *  SampleCube()
+	 *
+	 *  Returns the bilinear filtered color of a cube level in
+	 *  the passed in direction.  Filtering is clamped to the
+	 *  face, which is fine for the already blurry levels.
+	 ***********************************************************/
+	glm::vec3 SampleCube(const std::vector<float>& texels, int size, glm::vec3 direction)
+	{
+		glm::vec3 a = glm::abs(direction);
+		int face = 0;
+		float sc = 0.0f, tc = 0.0f, ma = 1.0f;
+
+		if ((a.x >= a.y) && (a.x >= a.z))
+		{
+			face = (direction.x > 0.0f) ? 0 : 1;
+			sc = (direction.x > 0.0f) ? -direction.z : direction.z;
+			tc = -direction.y;
+			ma = a.x;
+		}
+		else if (a.y >= a.z)
+		{
+			face = (direction.y > 0.0f) ? 2 : 3;
+			sc = direction.x;
+			tc = (direction.y > 0.0f) ? direction.z : -direction.z;
+			ma = a.y;
+		}
+		else
+		{
+			face = (direction.z > 0.0f) ? 4 : 5;
+			sc = (direction.z > 0.0f) ? direction.x : -direction.x;
+			tc = -direction.y;
+			ma = a.z;
+		}
+
+		float x = ((sc / ma) * 0.5f + 0.5f) * size - 0.5f;
+		float y = ((tc / ma) * 0.5f + 0.5f) * size - 0.5f;
+		x = std::min(std::max(x, 0.0f), size - 1.0f);
+		y = std::min(std::max(y, 0.0f), size - 1.0f);
+		int x0 = (int)x;
+		int y0 = (int)y;
+		int x1 = std::min(x0 + 1, size - 1);
+		int y1 = std::min(y0 + 1, size - 1);
+		float fx = x - x0;
+		float fy = y - y0;
+
+		const float* base = texels.data() + (size_t)face * size * size * 3;
+		glm::vec3 color(0.0f);
+		int xs[2] = { x0, x1 };
+		int ys[2] = { y0, y1 };
+		float wx[2] = { 1.0f - fx, fx };
+		float wy[2] = { 1.0f - fy, fy };
+		for (int j = 0; j < 2; j++)
+		{
+			for (int i = 0; i < 2; i++)
+			{
+				const float* texel = base + (ys[j] * size + xs[i]) * 3;
+				color += glm::vec3(texel[0], texel[1], texel[2]) * (wx[i] * wy[j]);
+			}
+		}
+		return(color);
+	}
+
+	/***********************************************************
+	 *  RadicalInverse()
+	 *
+	 *  Returns the Van der Corput radical inverse of the passed
+	 *  in index, the second coordinate of the Hammersley set.
+	 ***********************************************************/
+	float RadicalInverse(unsigned int bits)
+	{
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return(bits * 2.3283064365386963e-10f);
+	}
+}
+
+/***********************************************************
+ *  EnvironmentProbe()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+EnvironmentProbe::EnvironmentProbe(ShaderManager* pShaderManager)
+{
+	m_pShaderManager = pShaderManager;
+	m_cubemapID = 0;
+	m_position = glm::vec3(0.0f);
+}
+
+/***********************************************************
+ *  ~EnvironmentProbe()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+EnvironmentProbe::~EnvironmentProbe()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the prefiltered cubemap
+ *  and binding it for the scene shader.  A cache written for
+ *  the same position and settings is loaded as is, otherwise
+ *  the scene is captured and prefiltered, and the cache is
+ *  written for the next run.
+ ***********************************************************/
+bool EnvironmentProbe::Create(glm::vec3 position, const char* cacheFile,
+	std::function<void()> renderScene)
+{
+	if (NULL == m_pShaderManager)
+	{
+		return false;
+	}
+
+	m_position = position;
+	m_captureState = PipelineState(PipelineState::GetProgram(m_pShaderManager),
+		PipelineState::BLEND_NONE, PipelineState::DEPTH_LESS, true, PipelineState::CULL_BACK);
+
+	// the scene draws no reflections of itself into the capture
+	PipelineState::Bind(m_captureState);
+	SetSamplerUnit(m_pShaderManager);
+	m_pShaderManager->setBoolValue(g_UseEnvironmentName, false);
+
+	std::vector<CUBE_LEVEL> levels;
+	if (LoadCache(cacheFile, levels) == true)
+	{
+		std::cout << "INFO: Loaded environment probe from " << cacheFile << std::endl;
+	}
+	else
+	{
+		levels.resize(g_LevelCount);
+		Capture(renderScene, levels[0]);
+		Prefilter(levels);
+		if (SaveCache(cacheFile, levels) == false)
+		{
+			std::cout << "INFO: Could not write the environment cache " << cacheFile << std::endl;
+		}
+	}
+
+	Upload(levels);
+
+	glActiveTexture(GL_TEXTURE0 + g_EnvironmentTextureUnit);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, m_cubemapID);
+	PipelineState::Bind(m_captureState);
+	m_pShaderManager->setBoolValue(g_UseEnvironmentName, true);
+	m_pShaderManager->setFloatValue(g_EnvironmentLevelsName, (float)(g_LevelCount - 1));
+
+	return true;
+}
+
+/***********************************************************
+ *  SetSamplerUnit()
+ *
+ *  This method is used for setting the unit of the cube
+ *  sampler on the bound scene shader.  The scene manager
+ *  calls it before its first draw, long before the probe is
+ *  created, since a cube sampler left on unit 0 with the 2D
+ *  samplers fails every draw.
+ ***********************************************************/
+void EnvironmentProbe::SetSamplerUnit(ShaderManager* pShaderManager)
+{
+	if (NULL == pShaderManager)
+	{
+		return;
+	}
+
+	pShaderManager->setSampler2DValue(g_EnvironmentValueName, g_EnvironmentTextureUnit);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the cubemap.
+ ***********************************************************/
+void EnvironmentProbe::Destroy()
+{
+	if (m_cubemapID != 0)
+	{
+		glDeleteTextures(1, &m_cubemapID);
+		m_cubemapID = 0;
+	}
+}
+
+/***********************************************************
+ *  Capture()
+ *
+ *  This method is used for drawing the scene once per face
+ *  with a 90 degree camera at the probe position, into a
+ *  floating point target that is read back for prefiltering.
+ ***********************************************************/
+void EnvironmentProbe::Capture(std::function<void()> renderScene, CUBE_LEVEL& level)
+{
+	GLuint framebufferID = 0;
+	GLuint colorID = 0;
+	GLuint depthID = 0;
+
+	level.size = g_CaptureSize;
+	level.texels.resize((size_t)6 * g_CaptureSize * g_CaptureSize * 3);
+
+	glGenTextures(1, &colorID);
+	glBindTexture(GL_TEXTURE_2D, colorID);
+	GL_DEBUG_LABEL(GL_TEXTURE, colorID, "probe capture");
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, g_CaptureSize, g_CaptureSize, 0, GL_RGBA, GL_FLOAT, NULL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glGenRenderbuffers(1, &depthID);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, g_CaptureSize, g_CaptureSize);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &framebufferID);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebufferID);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorID, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthID);
+	glViewport(0, 0, g_CaptureSize, g_CaptureSize);
+
+	glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
+	for (int face = 0; face < 6; face++)
+	{
+		glm::mat4 view = glm::lookAt(m_position, m_position + g_FaceDirections[face], g_FaceUps[face]);
+
+		// bound before the clear, which obeys its depth writes
+		PipelineState::Bind(m_captureState);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		m_pShaderManager->setMat4Value("view", view);
+		m_pShaderManager->setMat4Value("projection", projection);
+		m_pShaderManager->setVec3Value("viewPosition", m_position);
+		if (renderScene)
+		{
+			renderScene();
+		}
+
+		glReadPixels(0, 0, g_CaptureSize, g_CaptureSize, GL_RGB, GL_FLOAT,
+			level.texels.data() + (size_t)face * g_CaptureSize * g_CaptureSize * 3);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &framebufferID);
+	glDeleteRenderbuffers(1, &depthID);
+	glDeleteTextures(1, &colorID);
+}
+
+/***********************************************************
+ *  Prefilter()
+ *
+ *  This method is used for filling levels 1 and up from the
+ *  captured level 0.  Each texel integrates the GGX lobe of
+ *  its level's roughness around its direction, reading the
+ *  captured room from a box filtered copy whose level matches
+ *  the footprint of each sample, so few samples are needed.
+ *  The rows are spread over every hardware thread.
+ ***********************************************************/
+void EnvironmentProbe::Prefilter(std::vector<CUBE_LEVEL>& levels)
+{
+	// box filtered copies of the capture for the sample lookups
+	std::vector<CUBE_LEVEL> sources(1, levels[0]);
+	while (sources.back().size > 1)
+	{
+		const CUBE_LEVEL& larger = sources.back();
+		CUBE_LEVEL smaller;
+		smaller.size = larger.size / 2;
+		smaller.texels.resize((size_t)6 * smaller.size * smaller.size * 3);
+		for (int face = 0; face < 6; face++)
+		{
+			const float* from = larger.texels.data() + (size_t)face * larger.size * larger.size * 3;
+			float* to = smaller.texels.data() + (size_t)face * smaller.size * smaller.size * 3;
+			for (int y = 0; y < smaller.size; y++)
+			{
+				for (int x = 0; x < smaller.size; x++)
+				{
+					for (int c = 0; c < 3; c++)
+					{
+						to[(y * smaller.size + x) * 3 + c] = 0.25f * (
+							from[((y * 2) * larger.size + x * 2) * 3 + c] +
+							from[((y * 2) * larger.size + x * 2 + 1) * 3 + c] +
+							from[((y * 2 + 1) * larger.size + x * 2) * 3 + c] +
+							from[((y * 2 + 1) * larger.size + x * 2 + 1) * 3 + c]);
+					}
+				}
+			}
+		}
+		sources.push_back(smaller);
+	}
+
+	// solid angle of one captured texel
+	float texelSolidAngle = 4.0f * g_Pi / (6.0f * g_CaptureSize * g_CaptureSize);
+	int threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+
+	for (int levelIndex = 1; levelIndex < levels.size(); levelIndex++)
+	{
+		CUBE_LEVEL& level = levels[levelIndex];
+		level.size = std::max(1, g_CaptureSize >> levelIndex);
+		level.texels.resize((size_t)6 * level.size * level.size * 3);
+
+		float roughness = (float)levelIndex / (levels.size() - 1);
+		float alpha = roughness * roughness;
+		int rowCount = 6 * level.size;
+
+		// every thread takes every threadCount'th row of all faces
+		std::vector<std::thread> threads;
+		for (int t = 0; t < threadCount; t++)
+		{
+			threads.push_back(std::thread([&, t]()
+				{
+					for (int row = t; row < rowCount; row += threadCount)
+					{
+						int face = row / level.size;
+						int y = row % level.size;
+						for (int x = 0; x < level.size; x++)
+						{
+							float u = ((x + 0.5f) / level.size) * 2.0f - 1.0f;
+							float v = ((y + 0.5f) / level.size) * 2.0f - 1.0f;
+							glm::vec3 normal = GetTexelDirection(face, u, v);
+
+							// tangent frame around the texel direction
+							glm::vec3 up = (std::fabs(normal.z) < 0.999f) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+							glm::vec3 tangent = glm::normalize(glm::cross(up, normal));
+							glm::vec3 bitangent = glm::cross(normal, tangent);
+
+							glm::vec3 color(0.0f);
+							float totalWeight = 0.0f;
+							for (int i = 0; i < g_SampleCount; i++)
+							{
+								float phi = 2.0f * g_Pi * ((float)i / g_SampleCount);
+								float e = RadicalInverse(i);
+								float cosTheta = std::sqrt((1.0f - e) / (1.0f + (alpha * alpha - 1.0f) * e));
+								float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+								glm::vec3 halfway = glm::normalize(
+									tangent * (sinTheta * std::cos(phi)) +
+									bitangent * (sinTheta * std::sin(phi)) +
+									normal * cosTheta);
+
+								// the view is assumed to be along the normal
+								glm::vec3 light = 2.0f * glm::dot(normal, halfway) * halfway - normal;
+								float NdotL = glm::dot(normal, light);
+								if (NdotL <= 0.0f)
+								{
+									continue;
+								}
+
+								// pick the source level whose texels cover
+								// about the solid angle of the sample
+								float NdotH = cosTheta;
+								float denom = NdotH * NdotH * (alpha * alpha - 1.0f) + 1.0f;
+								float D = (alpha * alpha) / (g_Pi * denom * denom);
+								float pdf = D * 0.25f;
+								float sampleSolidAngle = 1.0f / (g_SampleCount * pdf + 0.0001f);
+								float mip = 0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f;
+								int source = std::min(std::max((int)(mip + 0.5f), 0), (int)sources.size() - 1);
+
+								color += SampleCube(sources[source].texels, sources[source].size, light) * NdotL;
+								totalWeight += NdotL;
+							}
+							if (totalWeight > 0.0f)
+							{
+								color /= totalWeight;
+							}
+
+							float* texel = level.texels.data() + (((size_t)face * level.size + y) * level.size + x) * 3;
+							texel[0] = color.r;
+							texel[1] = color.g;
+							texel[2] = color.b;
+						}
+					}
+				}));
+		}
+		for (int t = 0; t < threads.size(); t++)
+		{
+			threads[t].join();
+		}
+	}
+
+	std::cout << "INFO: Prefiltered environment probe on " << threadCount << " threads" << std::endl;
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for creating the cubemap from the
+ *  prefiltered levels.
+ ***********************************************************/
+void EnvironmentProbe::Upload(const std::vector<CUBE_LEVEL>& levels)
+{
+	if (m_cubemapID == 0)
+	{
+		glGenTextures(1, &m_cubemapID);
+	}
+	glBindTexture(GL_TEXTURE_CUBE_MAP, m_cubemapID);
+	GL_DEBUG_LABEL(GL_TEXTURE, m_cubemapID, "environment probe");
+
+	for (int levelIndex = 0; levelIndex < levels.size(); levelIndex++)
+	{
+		const CUBE_LEVEL& level = levels[levelIndex];
+		for (int face = 0; face < 6; face++)
+		{
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, levelIndex, GL_RGB16F,
+				level.size, level.size, 0, GL_RGB, GL_FLOAT,
+				level.texels.data() + (size_t)face * level.size * level.size * 3);
+		}
+	}
+
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, (GLint)levels.size() - 1);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+	// filter across face edges so the blurry levels have no seams
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+}
+
+/***********************************************************
+ *  LoadCache()
+ *
+ *  This method is used for reading the levels from the cache
+ *  file.  Returns false when the file is missing, or was
+ *  captured from another position or with other settings.
+ ***********************************************************/
+bool EnvironmentProbe::LoadCache(const char* cacheFile, std::vector<CUBE_LEVEL>& levels)
+{
+	std::ifstream file(cacheFile, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	char magic[4];
+	int header[4] = { 0, 0, 0, 0 };
+	float position[3] = { 0.0f, 0.0f, 0.0f };
+	file.read(magic, sizeof(magic));
+	file.read((char*)header, sizeof(header));
+	file.read((char*)position, sizeof(position));
+	if ((!file) ||
+		(std::memcmp(magic, g_CacheMagic, sizeof(magic)) != 0) ||
+		(header[0] != g_CacheVersion) ||
+		(header[1] != g_CaptureSize) ||
+		(header[2] != g_LevelCount) ||
+		(header[3] != g_SampleCount) ||
+		(glm::vec3(position[0], position[1], position[2]) != m_position))
+	{
+		return false;
+	}
+
+	levels.resize(g_LevelCount);
+	for (int i = 0; i < g_LevelCount; i++)
+	{
+		levels[i].size = std::max(1, g_CaptureSize >> i);
+		levels[i].texels.resize((size_t)6 * levels[i].size * levels[i].size * 3);
+		file.read((char*)levels[i].texels.data(), levels[i].texels.size() * sizeof(float));
+	}
+	return(file.good());
+}
+
+/***********************************************************
+ *  SaveCache()
+ *
+ *  This method is used for writing the levels to the cache
+ *  file, behind a header that identifies how they were made.
+ ***********************************************************/
+bool EnvironmentProbe::SaveCache(const char* cacheFile, const std::vector<CUBE_LEVEL>& levels)
+{
+	std::ofstream file(cacheFile, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	int header[4] = { g_CacheVersion, g_CaptureSize, g_LevelCount, g_SampleCount };
+	float position[3] = { m_position.x, m_position.y, m_position.z };
+	file.write(g_CacheMagic, sizeof(g_CacheMagic));
+	file.write((const char*)header, sizeof(header));
+	file.write((const char*)position, sizeof(position));
+	for (int i = 0; i < levels.size(); i++)
+	{
+		file.write((const char*)levels[i].texels.data(), levels[i].texels.size() * sizeof(float));
+	}
+	return(file.good());
+}
@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// environmentprobe.h
+// ============
+// manage the environment cubemap captured from a probe in the room and
+// prefiltered into roughness levels for image based reflections
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "PipelineState.h"
+
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <vector>
+
+/***********************************************************
+ *  EnvironmentProbe
+ *
+ *  This class contains the code for capturing the scene into
+ *  a cubemap from one position.  Each mip level of the cubemap
+ *  holds the room as a surface of increasing roughness sees
+ *  it, so a fragment gets its whole reflection from a single
+ *  cubemap read.  The prefiltering is done on the CPU across
+ *  all cores, and the result is cached on disk.
+ ***********************************************************/
+class EnvironmentProbe
+{
+public:
+	// constructor
+	EnvironmentProbe(ShaderManager* pShaderManager);
+	// destructor
+	~EnvironmentProbe();
+
+	// load the cubemap from the cache file, or capture the scene
+	// drawn by renderScene, prefilter it and write the cache
+	bool Create(glm::vec3 position, const char* cacheFile,
+		std::function<void()> renderScene);
+	// free the cubemap
+	void Destroy();
+
+	// give the cube sampler of the bound scene shader its unit, which
+	// must happen before the shader draws anything - two sampler
+	// types can never share a unit
+	static void SetSamplerUnit(ShaderManager* pShaderManager);
+
+private:
+	// one level of the prefiltered cubemap - six faces of RGB floats
+	struct CUBE_LEVEL
+	{
+		int size;
+		std::vector<float> texels;
+	};
+
+	// pointer to the scene shader that samples the cubemap
+	ShaderManager* m_pShaderManager;
+	// opaque scene drawing like the main view, for the faces
+	PipelineState m_captureState;
+	// the prefiltered cubemap
+	GLuint m_cubemapID;
+	// position the room was captured from
+	glm::vec3 m_position;
+
+	// draw the scene into the six faces and read them back
+	void Capture(std::function<void()> renderScene, CUBE_LEVEL& level);
+	// fill the rougher levels from the captured level
+	void Prefilter(std::vector<CUBE_LEVEL>& levels);
+	// upload every level into the cubemap
+	void Upload(const std::vector<CUBE_LEVEL>& levels);
+	// read the levels from the cache, false if missing or stale
+	bool LoadCache(const char* cacheFile, std::vector<CUBE_LEVEL>& levels);
+	// write the levels to the cache
+	bool SaveCache(const char* cacheFile, const std::vector<CUBE_LEVEL>& levels);
+};
@@ -0,0 +1,493 @@
+///////////////////////////////////////////////////////////////////////////////
+// framegraph.cpp
+// ============
+// manage the render passes of a frame - passes declare the targets they read
+// and write, and the graph culls, schedules and allocates around them
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameGraph.h"
+#include "PipelineState.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  FrameGraph()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameGraph::FrameGraph(RenderTargetPool* pRenderTargetPool)
+{
+	m_pRenderTargetPool = pRenderTargetPool;
+	m_culledPasses = 0;
+}
+
+/***********************************************************
+ *  ~FrameGraph()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameGraph::~FrameGraph()
+{
+	for (int i = 0; i < m_passFramebuffers.size(); i++)
+	{
+		if (m_passFramebuffers[i] != 0)
+		{
+			glDeleteFramebuffers(1, &m_passFramebuffers[i]);
+		}
+	}
+	m_passFramebuffers.clear();
+	m_pRenderTargetPool = NULL;
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for clearing the passes and the
+ *  resources of the previous frame so a new frame can be
+ *  declared.
+ ***********************************************************/
+void FrameGraph::Reset()
+{
+	m_resources.clear();
+	m_passes.clear();
+	m_culledPasses = 0;
+}
+
+/***********************************************************
+ *  CreateTarget()
+ *
+ *  This method is used for declaring a target that only
+ *  lives while the frame is drawn.  Its memory comes from
+ *  the render target pool once Compile() knows which passes
+ *  use it.  Returns the resource index.
+ ***********************************************************/
+int FrameGraph::CreateTarget(const std::string& name, int width, int height,
+	GLenum internalFormat, int samples, bool bClear, glm::vec4 clearColor)
+{
+	RESOURCE resource;
+	resource.name = name;
+	resource.width = width;
+	resource.height = height;
+	resource.samples = samples;
+	resource.internalFormat = internalFormat;
+	resource.bClear = bClear;
+	resource.clearColor = clearColor;
+	resource.bImported = false;
+	resource.importedFramebuffer = 0;
+	resource.importedTexture = 0;
+	resource.transient = -1;
+	resource.firstPass = -1;
+	resource.lastPass = -1;
+	resource.lastWriter = -1;
+
+	m_resources.push_back(resource);
+	return(m_resources.size() - 1);
+}
+
+/***********************************************************
+ *  ImportTarget()
+ *
+ *  This method is used for declaring a target that is owned
+ *  outside the graph, such as the window's back buffer.
+ *  Passes that write an imported target are never culled.
+ ***********************************************************/
+int FrameGraph::ImportTarget(const std::string& name, GLuint framebufferID,
+	GLuint textureID, int width, int height)
+{
+	int resource = CreateTarget(name, width, height, GL_RGBA8);
+	m_resources[resource].bImported = true;
+	m_resources[resource].importedFramebuffer = framebufferID;
+	m_resources[resource].importedTexture = textureID;
+	return(resource);
+}
+
+/***********************************************************
+ *  AddPass()
+ *
+ *  This method is used for adding a render pass.  Passes run
+ *  in the order they are added, so a pass may only read the
+ *  targets written by passes added before it.  Returns the
+ *  pass index.
+ ***********************************************************/
+int FrameGraph::AddPass(const std::string& name,
+	const std::vector<int>& inputs,
+	const std::vector<int>& outputs,
+	std::function<void()> execute,
+	bool bShaderWrites)
+{
+	PASS pass;
+	pass.name = name;
+	pass.inputs = inputs;
+	pass.outputs = outputs;
+	pass.execute = execute;
+	pass.bShaderWrites = bShaderWrites;
+	pass.bCulled = false;
+
+	m_passes.push_back(pass);
+	return(m_passes.size() - 1);
+}
+
+/***********************************************************
+ *  Compile()
+ *
+ *  This method is used for preparing the declared passes:
+ *    1. passes reading a target nobody wrote are dropped
+ *    2. walking backwards from the imported targets, passes
+ *       whose outputs are never read are culled
+ *    3. the first and last pass using each target give its
+ *       lifetime, and the pool assigns memory, aliasing
+ *       targets whose lifetimes do not overlap
+ ***********************************************************/
+void FrameGraph::Compile()
+{
+	std::vector<bool> bWritten(m_resources.size(), false);
+	std::vector<bool> bNeeded(m_resources.size(), false);
+
+	m_culledPasses = 0;
+
+	// a pass can only read what an earlier pass has written
+	for (int i = 0; i < m_passes.size(); i++)
+	{
+		PASS& pass = m_passes[i];
+		for (int j = 0; j < pass.inputs.size(); j++)
+		{
+			int input = pass.inputs[j];
+			if ((m_resources[input].bImported == false) && (bWritten[input] == false))
+			{
+				std::cout << "Frame graph pass " << pass.name << " reads "
+					<< m_resources[input].name << " before it is written" << std::endl;
+				pass.bCulled = true;
+			}
+		}
+		if (pass.bCulled == false)
+		{
+			for (int j = 0; j < pass.outputs.size(); j++)
+			{
+				bWritten[pass.outputs[j]] = true;
+			}
+		}
+	}
+
+	// keep a pass only if it writes an imported target or
+	// something a later kept pass reads
+	for (int i = m_passes.size() - 1; i >= 0; i--)
+	{
+		PASS& pass = m_passes[i];
+		bool bKeep = false;
+		if (pass.bCulled == false)
+		{
+			for (int j = 0; j < pass.outputs.size(); j++)
+			{
+				int output = pass.outputs[j];
+				if ((m_resources[output].bImported == true) || (bNeeded[output] == true))
+				{
+					bKeep = true;
+				}
+			}
+		}
+
+		if (bKeep == true)
+		{
+			for (int j = 0; j < pass.inputs.size(); j++)
+			{
+				bNeeded[pass.inputs[j]] = true;
+			}
+		}
+		else
+		{
+			pass.bCulled = true;
+			m_culledPasses++;
+		}
+	}
+
+	// lifetime of every target across the kept passes
+	for (int i = 0; i < m_passes.size(); i++)
+	{
+		if (m_passes[i].bCulled == true)
+		{
+			continue;
+		}
+
+		std::vector<int> used = m_passes[i].inputs;
+		used.insert(used.end(), m_passes[i].outputs.begin(), m_passes[i].outputs.end());
+		for (int j = 0; j < used.size(); j++)
+		{
+			RESOURCE& resource = m_resources[used[j]];
+			if (resource.firstPass < 0)
+			{
+				resource.firstPass = i;
+			}
+			resource.lastPass = i;
+		}
+	}
+
+	// only the targets a kept pass touches get memory
+	for (int i = 0; i < m_resources.size(); i++)
+	{
+		RESOURCE& resource = m_resources[i];
+		if ((resource.bImported == false) && (resource.firstPass >= 0))
+		{
+			resource.transient = m_pRenderTargetPool->DeclareTransient(
+				resource.width, resource.height, resource.internalFormat,
+				resource.firstPass, resource.lastPass, resource.samples);
+		}
+	}
+	m_pRenderTargetPool->AllocateTransients();
+}
+
+/***********************************************************
+ *  Execute()
+ *
+ *  This method is used for running the kept passes.  Before
+ *  each pass a memory barrier is issued if one of its inputs
+ *  was written with image stores, then its outputs are bound
+ *  and cleared on first use.  The pooled targets are handed
+ *  back once the frame is done.
+ ***********************************************************/
+void FrameGraph::Execute()
+{
+	for (int i = 0; i < m_passes.size(); i++)
+	{
+		PASS& pass = m_passes[i];
+		if (pass.bCulled == true)
+		{
+			continue;
+		}
+
+		// rendering to a texture is made visible by the driver, but
+		// image stores need an explicit barrier before they are read
+		bool bBarrier = false;
+		for (int j = 0; j < pass.inputs.size(); j++)
+		{
+			int writer = m_resources[pass.inputs[j]].lastWriter;
+			if ((writer >= 0) && (m_passes[writer].bShaderWrites == true))
+			{
+				bBarrier = true;
+			}
+		}
+		if ((bBarrier == true) && (glMemoryBarrier != NULL))
+		{
+			glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
+				GL_FRAMEBUFFER_BARRIER_BIT);
+		}
+
+		BeginPass(i);
+		if (pass.execute)
+		{
+			pass.execute();
+		}
+
+		for (int j = 0; j < pass.outputs.size(); j++)
+		{
+			m_resources[pass.outputs[j]].lastWriter = i;
+		}
+	}
+
+	m_pRenderTargetPool->ReleaseTransients();
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/***********************************************************
+ *  GetTexture()
+ *
+ *  This method is used for getting the texture behind a
+ *  resource while the passes are executing.
+ ***********************************************************/
+GLuint FrameGraph::GetTexture(int resource) const
+{
+	if ((resource < 0) || (resource >= m_resources.size()))
+	{
+		return(0);
+	}
+	if (m_resources[resource].bImported == true)
+	{
+		return(m_resources[resource].importedTexture);
+	}
+	return(m_pRenderTargetPool->GetTexture(
+		m_pRenderTargetPool->GetTransientTarget(m_resources[resource].transient)));
+}
+
+/***********************************************************
+ *  GetFramebuffer()
+ *
+ *  This method is used for getting a framebuffer that has
+ *  only the passed in resource attached.
+ ***********************************************************/
+GLuint FrameGraph::GetFramebuffer(int resource) const
+{
+	if ((resource < 0) || (resource >= m_resources.size()))
+	{
+		return(0);
+	}
+	if (m_resources[resource].bImported == true)
+	{
+		return(m_resources[resource].importedFramebuffer);
+	}
+	return(m_pRenderTargetPool->GetFramebuffer(
+		m_pRenderTargetPool->GetTransientTarget(m_resources[resource].transient)));
+}
+
+/***********************************************************
+ *  GetWidth()
+ *
+ *  This method is used for getting the width of a resource.
+ ***********************************************************/
+int FrameGraph::GetWidth(int resource) const
+{
+	if ((resource < 0) || (resource >= m_resources.size()))
+	{
+		return(0);
+	}
+	return(m_resources[resource].width);
+}
+
+/***********************************************************
+ *  GetHeight()
+ *
+ *  This method is used for getting the height of a resource.
+ ***********************************************************/
+int FrameGraph::GetHeight(int resource) const
+{
+	if ((resource < 0) || (resource >= m_resources.size()))
+	{
+		return(0);
+	}
+	return(m_resources[resource].height);
+}
+
+/***********************************************************
+ *  GetCulledPassCount()
+ *
+ *  This method is used for getting the number of passes the
+ *  last Compile() culled.
+ ***********************************************************/
+int FrameGraph::GetCulledPassCount() const
+{
+	return(m_culledPasses);
+}
+
+/***********************************************************
+ *  BeginPass()
+ *
+ *  This method is used for binding the targets written by a
+ *  pass and setting the viewport to their size.  A target is
+ *  only cleared by the first pass that writes it, and only if
+ *  it asked for a clear - fullscreen passes overwrite every
+ *  pixel and never need one.
+ ***********************************************************/
+void FrameGraph::BeginPass(int passIndex)
+{
+	PASS& pass = m_passes[passIndex];
+
+	if (pass.outputs.size() == 0)
+	{
+		return;
+	}
+
+	if (pass.outputs.size() == 1)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, GetFramebuffer(pass.outputs[0]));
+	}
+	else
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, GetPassFramebuffer(passIndex));
+	}
+	glViewport(0, 0, m_resources[pass.outputs[0]].width, m_resources[pass.outputs[0]].height);
+
+	int colorIndex = 0;
+	for (int i = 0; i < pass.outputs.size(); i++)
+	{
+		RESOURCE& resource = m_resources[pass.outputs[i]];
+		bool bDepth = RenderTargetPool::IsDepthFormat(resource.internalFormat);
+		bool bFirstWrite = (resource.lastWriter < 0);
+
+		if ((resource.bClear == true) && (bFirstWrite == true))
+		{
+			// clears obey the write masks of the bound state
+			PipelineState::EnableWrites();
+			if (bDepth == true)
+			{
+				if (resource.internalFormat == GL_DEPTH24_STENCIL8)
+				{
+					glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
+				}
+				else
+				{
+					const GLfloat clearDepth = 1.0f;
+					glClearBufferfv(GL_DEPTH, 0, &clearDepth);
+				}
+			}
+			else
+			{
+				glClearBufferfv(GL_COLOR, colorIndex, &resource.clearColor[0]);
+			}
+		}
+
+		if (bDepth == false)
+		{
+			colorIndex++;
+		}
+	}
+}
+
+/***********************************************************
+ *  GetPassFramebuffer()
+ *
+ *  This method is used for getting a framebuffer with every
+ *  output of the pass attached, in the order they were
+ *  declared.  Pooled targets can change between frames, so
+ *  the attachments are refreshed each time.
+ ***********************************************************/
+GLuint FrameGraph::GetPassFramebuffer(int passIndex)
+{
+	while (m_passFramebuffers.size() <= passIndex)
+	{
+		m_passFramebuffers.push_back(0);
+	}
+	if (m_passFramebuffers[passIndex] == 0)
+	{
+		glGenFramebuffers(1, &m_passFramebuffers[passIndex]);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, m_passFramebuffers[passIndex]);
+
+	PASS& pass = m_passes[passIndex];
+	std::vector<GLenum> drawBuffers;
+	for (int i = 0; i < pass.outputs.size(); i++)
+	{
+		int output = pass.outputs[i];
+		if (RenderTargetPool::IsDepthFormat(m_resources[output].internalFormat) == true)
+		{
+			AttachResource(output, -1);
+		}
+		else
+		{
+			AttachResource(output, drawBuffers.size());
+			drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + drawBuffers.size());
+		}
+	}
+	glDrawBuffers(drawBuffers.size(), drawBuffers.data());
+
+	return(m_passFramebuffers[passIndex]);
+}
+
+/***********************************************************
+ *  AttachResource()
+ *
+ *  This method is used for attaching a resource to the bound
+ *  framebuffer, as a color attachment or (with a colorIndex
+ *  of -1) as the depth attachment.
+ ***********************************************************/
+void FrameGraph::AttachResource(int resource, int colorIndex)
+{
+	const RESOURCE& desc = m_resources[resource];
+	GLenum textureTarget = (desc.samples > 1) ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+	GLenum attachment = GL_COLOR_ATTACHMENT0 + colorIndex;
+
+	if (colorIndex < 0)
+	{
+		attachment = (desc.internalFormat == GL_DEPTH24_STENCIL8) ?
+			GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+	}
+
+	glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, textureTarget, GetTexture(resource), 0);
+}
@@ -0,0 +1,122 @@
+///////////////////////////////////////////////////////////////////////////////
+// framegraph.h
+// ============
+// manage the render passes of a frame - passes declare the targets they read
+// and write, and the graph culls, schedules and allocates around them
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "RenderTargetPool.h"
+
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  FrameGraph
+ *
+ *  This class contains the code for building the list of
+ *  render passes each frame.  After all passes are added,
+ *  Compile() removes passes whose results are never used,
+ *  works out how long each target lives and assigns pooled
+ *  memory, and Execute() runs the remaining passes with the
+ *  right framebuffer bound, clearing each target only once
+ *  and inserting memory barriers where a pass needs them.
+ ***********************************************************/
+class FrameGraph
+{
+public:
+	// constructor
+	FrameGraph(RenderTargetPool* pRenderTargetPool);
+	// destructor
+	~FrameGraph();
+
+	// properties for a target used by the passes
+	struct RESOURCE
+	{
+		std::string name;
+		int width;
+		int height;
+		int samples;
+		GLenum internalFormat;
+		// cleared by the first pass that writes it
+		bool bClear;
+		glm::vec4 clearColor;
+		// owned outside the graph, e.g. the window back buffer
+		bool bImported;
+		GLuint importedFramebuffer;
+		GLuint importedTexture;
+		// filled in by Compile()
+		int transient;
+		int firstPass;
+		int lastPass;
+		// last pass that wrote the resource during Execute()
+		int lastWriter;
+	};
+
+	// properties for a render pass
+	struct PASS
+	{
+		std::string name;
+		std::vector<int> inputs;
+		std::vector<int> outputs;
+		std::function<void()> execute;
+		// writes with image stores or compute, so readers need a barrier
+		bool bShaderWrites;
+		// filled in by Compile()
+		bool bCulled;
+	};
+
+	// start building the passes for a new frame
+	void Reset();
+
+	// declare a target that only lives while the frame is drawn
+	int CreateTarget(const std::string& name, int width, int height,
+		GLenum internalFormat, int samples = 1, bool bClear = false,
+		glm::vec4 clearColor = glm::vec4(0.0f));
+	// declare a target that is owned outside the graph
+	int ImportTarget(const std::string& name, GLuint framebufferID,
+		GLuint textureID, int width, int height);
+
+	// add a pass that reads the inputs and writes the outputs
+	int AddPass(const std::string& name,
+		const std::vector<int>& inputs,
+		const std::vector<int>& outputs,
+		std::function<void()> execute,
+		bool bShaderWrites = false);
+
+	// cull, schedule and allocate the passes that were added
+	void Compile();
+	// run the passes that survived Compile()
+	void Execute();
+
+	// access the OpenGL objects behind a resource during Execute()
+	GLuint GetTexture(int resource) const;
+	GLuint GetFramebuffer(int resource) const;
+	int GetWidth(int resource) const;
+	int GetHeight(int resource) const;
+
+	// number of passes that were culled by the last Compile()
+	int GetCulledPassCount() const;
+
+private:
+	// pointer to the shared render target pool
+	RenderTargetPool* m_pRenderTargetPool;
+	// resources and passes declared for the current frame
+	std::vector<RESOURCE> m_resources;
+	std::vector<PASS> m_passes;
+	// framebuffer for passes that write more than one target
+	std::vector<GLuint> m_passFramebuffers;
+	// number of passes culled by the last Compile()
+	int m_culledPasses;
+
+	// bind the targets written by a pass and clear first writes
+	void BeginPass(int passIndex);
+	// get the framebuffer for a pass with several outputs
+	GLuint GetPassFramebuffer(int passIndex);
+	// attach one resource to the currently bound framebuffer
+	void AttachResource(int resource, int colorIndex);
+};
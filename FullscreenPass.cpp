@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+// fullscreenpass.cpp
+// ============
+// shared helpers for the passes that draw one fullscreen triangle - shader
+// loading, texture binding above the scene texture units, and the draw call
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FullscreenPass.h"
+#include "GLDebug.h"
+
+#include <string>
+
+// declare the global variables
+namespace
+{
+	// folder that holds the GLSL files
+	const std::string g_ShaderFolder = "../../Utilities/shaders/";
+
+	// the scene textures occupy units 0-15, so the fullscreen passes
+	// bind their inputs above them and never disturb the scene - up
+	// to 8 inputs, units 24 and up hold more scene lookups
+	const int g_PassTextureUnit = 16;
+}
+
+GLuint FullscreenPass::m_fullscreenVAO = 0;
+
+/***********************************************************
+ *  LoadShader()
+ *
+ *  This method is used for creating a shader program from the
+ *  shared fullscreen vertex shader and the passed in fragment
+ *  shader file.
+ ***********************************************************/
+ShaderManager* FullscreenPass::LoadShader(const char* fragmentShaderFile)
+{
+	ShaderManager* pShader = new ShaderManager();
+	std::string vertexPath = g_ShaderFolder + "postVertexShader.glsl";
+	std::string fragmentPath = g_ShaderFolder + fragmentShaderFile;
+	pShader->LoadShaders(vertexPath.c_str(), fragmentPath.c_str());
+	GL_DEBUG_LABEL_SHADER(pShader, fragmentShaderFile);
+	return(pShader);
+}
+
+/***********************************************************
+ *  BindTexture()
+ *
+ *  This method is used for binding a texture to one of the
+ *  texture units reserved for the fullscreen passes and
+ *  setting the passed in sampler of the (bound) shader to it.
+ ***********************************************************/
+void FullscreenPass::BindTexture(ShaderManager* pShader, const char* samplerName,
+	int unit, GLuint textureID)
+{
+	pShader->setSampler2DValue(samplerName, g_PassTextureUnit + unit);
+	glActiveTexture(GL_TEXTURE0 + g_PassTextureUnit + unit);
+	glBindTexture(GL_TEXTURE_2D, textureID);
+}
+
+/***********************************************************
+ *  GetState()
+ *
+ *  This method is used for getting the state a pass draws
+ *  with - fullscreen passes never need depth testing, and
+ *  only the passes that add to their target blend.
+ ***********************************************************/
+PipelineState FullscreenPass::GetState(ShaderManager* pShader, PipelineState::BLEND_MODE blend)
+{
+	return(PipelineState(PipelineState::GetProgram(pShader), blend, PipelineState::DEPTH_OFF, true));
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used for drawing the fullscreen triangle
+ *  with the current shader into the target the frame graph
+ *  bound for the pass.
+ ***********************************************************/
+void FullscreenPass::Draw()
+{
+	// the fullscreen triangle is generated from gl_VertexID, but the
+	// core profile still requires a vertex array to be bound
+	if (m_fullscreenVAO == 0)
+	{
+		glGenVertexArrays(1, &m_fullscreenVAO);
+	}
+
+	glBindVertexArray(m_fullscreenVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shared vertex array.
+ ***********************************************************/
+void FullscreenPass::Destroy()
+{
+	if (m_fullscreenVAO != 0)
+	{
+		glDeleteVertexArrays(1, &m_fullscreenVAO);
+		m_fullscreenVAO = 0;
+	}
+}
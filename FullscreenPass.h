@@ -0,0 +1,43 @@
+///////////////////////////////////////////////////////////////////////////////
+// fullscreenpass.h
+// ============
+// shared helpers for the passes that draw one fullscreen triangle - shader
+// loading, texture binding above the scene texture units, and the draw call
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "PipelineState.h"
+
+/***********************************************************
+ *  FullscreenPass
+ *
+ *  This class contains the code shared by every fullscreen
+ *  pass (post effects, reflections and so on).  All of the
+ *  methods are static since the passes share one empty
+ *  vertex array.
+ ***********************************************************/
+class FullscreenPass
+{
+public:
+	// load the fullscreen vertex shader with the passed in fragment shader
+	static ShaderManager* LoadShader(const char* fragmentShaderFile);
+	// bind a texture to one of the units reserved for fullscreen
+	// passes and point the named sampler of the shader at it
+	static void BindTexture(ShaderManager* pShader, const char* samplerName,
+		int unit, GLuint textureID);
+	// the state of a fullscreen pass with the shader - no depth test
+	// and the passed in blending
+	static PipelineState GetState(ShaderManager* pShader,
+		PipelineState::BLEND_MODE blend = PipelineState::BLEND_NONE);
+	// draw the fullscreen triangle into the bound framebuffer, with
+	// the state that was bound for the pass
+	static void Draw();
+	// free the shared vertex array
+	static void Destroy();
+
+private:
+	// empty vertex array for drawing the fullscreen triangle
+	static GLuint m_fullscreenVAO;
+};
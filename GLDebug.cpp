@@ -0,0 +1,234 @@
+///////////////////////////////////////////////////////////////////////////////
+// gldebug.cpp
+// ============
+// manage the OpenGL debug output of debug builds - driver messages filtered
+// by severity, names on the OpenGL objects and a summary of the performance
+// warnings of every frame
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GLDebug.h"
+#include "PipelineState.h"
+
+#ifdef GL_DEBUG_ENABLED
+
+#include <iostream>
+#include <sstream>
+
+// declare the global variables and helper functions
+namespace
+{
+	// the driver truncates longer labels
+	const GLsizei g_MaxLabelLength = 256;
+
+	/***********************************************************
+	 *  GetSeverityRank()
+	 *
+	 *  Returns the passed in GL_DEBUG_SEVERITY_* as a number
+	 *  that grows with the severity.
+	 ***********************************************************/
+	int GetSeverityRank(GLenum severity)
+	{
+		switch (severity)
+		{
+		case GL_DEBUG_SEVERITY_HIGH:
+			return(3);
+		case GL_DEBUG_SEVERITY_MEDIUM:
+			return(2);
+		case GL_DEBUG_SEVERITY_LOW:
+			return(1);
+		default:
+			return(0);
+		}
+	}
+
+	/***********************************************************
+	 *  GetTypeName()
+	 *
+	 *  Returns the printed name of a GL_DEBUG_TYPE_*.
+	 ***********************************************************/
+	const char* GetTypeName(GLenum type)
+	{
+		switch (type)
+		{
+		case GL_DEBUG_TYPE_ERROR:
+			return("error");
+		case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+			return("deprecated");
+		case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+			return("undefined behavior");
+		case GL_DEBUG_TYPE_PORTABILITY:
+			return("portability");
+		case GL_DEBUG_TYPE_PERFORMANCE:
+			return("performance");
+		default:
+			return("other");
+		}
+	}
+}
+
+bool GLDebug::m_bOutputStarted = false;
+GLenum GLDebug::m_minimumSeverity = GL_DEBUG_SEVERITY_MEDIUM;
+std::map<GLuint, std::pair<int, std::string>> GLDebug::m_frameWarnings;
+std::string GLDebug::m_lastSummary;
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for installing the message callback.
+ *  The messages are synchronous, so a breakpoint in the
+ *  callback stops in the call that caused the message.  The
+ *  notifications are switched off in the driver unless they
+ *  were asked for, there are many of them every frame.
+ ***********************************************************/
+bool GLDebug::Start(GLenum minimumSeverity)
+{
+	m_minimumSeverity = minimumSeverity;
+
+	if ((GLEW_KHR_debug == false) && (GLEW_VERSION_4_3 == false))
+	{
+		std::cout << "INFO: No KHR_debug, OpenGL errors are polled" << std::endl;
+		return false;
+	}
+
+	glEnable(GL_DEBUG_OUTPUT);
+	glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	glDebugMessageCallback(MessageCallback, NULL);
+	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_TRUE);
+	if (GetSeverityRank(minimumSeverity) > 0)
+	{
+		glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, NULL, GL_FALSE);
+	}
+	m_bOutputStarted = true;
+
+	std::cout << "INFO: OpenGL debug output started" << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  Label()
+ *
+ *  This method is used for naming an OpenGL object.  The
+ *  object must have been bound once, a name that was only
+ *  generated is not an object yet.
+ ***********************************************************/
+void GLDebug::Label(GLenum identifier, GLuint name, const std::string& label)
+{
+	if ((m_bOutputStarted == false) || (name == 0))
+	{
+		return;
+	}
+
+	GLsizei length = (GLsizei)label.size();
+	if (length > g_MaxLabelLength)
+	{
+		length = g_MaxLabelLength;
+	}
+	glObjectLabel(identifier, name, length, label.c_str());
+}
+
+/***********************************************************
+ *  LabelShader()
+ *
+ *  This method is used for naming the program of a shader
+ *  manager.
+ ***********************************************************/
+void GLDebug::LabelShader(ShaderManager* pShader, const std::string& label)
+{
+	if ((m_bOutputStarted == false) || (NULL == pShader))
+	{
+		return;
+	}
+
+	Label(GL_PROGRAM, PipelineState::GetProgram(pShader), label);
+}
+
+/***********************************************************
+ *  CheckError()
+ *
+ *  This method is used for printing the errors raised since
+ *  the last check.  With the debug output running the driver
+ *  has already reported them, so nothing is polled.
+ ***********************************************************/
+void GLDebug::CheckError(const char* where)
+{
+	if (m_bOutputStarted == true)
+	{
+		return;
+	}
+
+	GLenum error = glGetError();
+	while (error != GL_NO_ERROR)
+	{
+		std::cout << "OpenGL error 0x" << std::hex << error << std::dec
+			<< " in " << where << std::endl;
+		error = glGetError();
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for printing the performance warnings
+ *  of the frame - shader recompiles, stalls on buffers in use
+ *  and so on - with the number of times each was reported.
+ *  A frame with the same warnings as the last one printed is
+ *  not printed again.
+ ***********************************************************/
+void GLDebug::EndFrame()
+{
+	CheckError("the frame");
+
+	if (m_frameWarnings.empty() == true)
+	{
+		m_lastSummary.clear();
+		return;
+	}
+
+	std::ostringstream summary;
+	std::map<GLuint, std::pair<int, std::string>>::iterator warning;
+	for (warning = m_frameWarnings.begin(); warning != m_frameWarnings.end(); warning++)
+	{
+		summary << "  " << warning->second.first << "x [" << warning->first << "] "
+			<< warning->second.second << std::endl;
+	}
+	m_frameWarnings.clear();
+
+	if (summary.str() != m_lastSummary)
+	{
+		m_lastSummary = summary.str();
+		std::cout << "INFO: OpenGL performance warnings this frame:" << std::endl << m_lastSummary;
+	}
+}
+
+/***********************************************************
+ *  MessageCallback()
+ *
+ *  This method is used for receiving the driver's messages.
+ *  Performance warnings are kept for the frame summary at
+ *  any severity, everything else is printed when it is at
+ *  least as severe as the minimum.
+ ***********************************************************/
+void GLAPIENTRY GLDebug::MessageCallback(GLenum source, GLenum type, GLuint id,
+	GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
+{
+	if (type == GL_DEBUG_TYPE_PERFORMANCE)
+	{
+		std::pair<int, std::string>& warning = m_frameWarnings[id];
+		if (warning.first == 0)
+		{
+			warning.second = std::string(message);
+		}
+		warning.first++;
+		return;
+	}
+
+	if (GetSeverityRank(severity) < GetSeverityRank(m_minimumSeverity))
+	{
+		return;
+	}
+
+	std::cout << "OpenGL " << GetTypeName(type) << " [" << id << "]: "
+		<< std::string(message) << std::endl;
+}
+
+#endif
@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+// gldebug.h
+// ============
+// manage the OpenGL debug output of debug builds - driver messages filtered
+// by severity, names on the OpenGL objects and a summary of the performance
+// warnings of every frame
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include "ShaderManager.h"
+
+#include <map>
+#include <string>
+
+// the debug output is only built into debug builds.  In release
+// builds the macros below expand to nothing, so not even the label
+// strings are put together.
+#ifndef NDEBUG
+#define GL_DEBUG_ENABLED
+#endif
+
+#ifdef GL_DEBUG_ENABLED
+#define GL_DEBUG_START(minimumSeverity) GLDebug::Start(minimumSeverity)
+#define GL_DEBUG_LABEL(identifier, name, label) GLDebug::Label(identifier, name, label)
+#define GL_DEBUG_LABEL_SHADER(pShader, label) GLDebug::LabelShader(pShader, label)
+#define GL_DEBUG_CHECK(where) GLDebug::CheckError(where)
+#define GL_DEBUG_END_FRAME() GLDebug::EndFrame()
+#else
+#define GL_DEBUG_START(minimumSeverity) ((void)0)
+#define GL_DEBUG_LABEL(identifier, name, label) ((void)0)
+#define GL_DEBUG_LABEL_SHADER(pShader, label) ((void)0)
+#define GL_DEBUG_CHECK(where) ((void)0)
+#define GL_DEBUG_END_FRAME() ((void)0)
+#endif
+
+#ifdef GL_DEBUG_ENABLED
+
+/***********************************************************
+ *  GLDebug
+ *
+ *  This class contains the code for the KHR_debug output.
+ *  The driver reports errors and warnings through a callback
+ *  as they happen, so the call that caused them is on the
+ *  stack, and the OpenGL objects carry the names they are
+ *  reported with.  Without KHR_debug (the 3.3 context on
+ *  Apple) the errors are polled with glGetError() instead.
+ *  All of the methods are static since there is one context.
+ *  Use the macros above, never the class directly.
+ ***********************************************************/
+class GLDebug
+{
+public:
+	// install the message callback, messages less severe than the
+	// passed in GL_DEBUG_SEVERITY_* are not printed
+	static bool Start(GLenum minimumSeverity);
+	// name an OpenGL object in the driver's messages and in tools
+	static void Label(GLenum identifier, GLuint name, const std::string& label);
+	// name the program of a shader manager
+	static void LabelShader(ShaderManager* pShader, const std::string& label);
+	// print the errors since the last check, when the driver does
+	// not report them itself
+	static void CheckError(const char* where);
+	// print the performance warnings of the frame that just ended
+	static void EndFrame();
+
+private:
+	// receives every message of the driver
+	static void GLAPIENTRY MessageCallback(GLenum source, GLenum type, GLuint id,
+		GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
+
+	// true when the callback is installed
+	static bool m_bOutputStarted;
+	// least severe message that is printed
+	static GLenum m_minimumSeverity;
+	// performance warnings of this frame by message id, with the
+	// times each was reported
+	static std::map<GLuint, std::pair<int, std::string>> m_frameWarnings;
+	// last summary printed, so a warning every frame prints once
+	static std::string m_lastSummary;
+};
+
+#endif
@@ -0,0 +1,337 @@
+///////////////////////////////////////////////////////////////////////////////
+// impostors.cpp
+// ============
+// manage the impostors of the composite objects - views baked into an atlas
+// at load, drawn as one instanced billboard each when an object is small
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Impostors.h"
+#include "GLDebug.h"
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <iostream>
+
+// declare the global variables and helper functions
+namespace
+{
+	const char* g_BillboardVertexShader = "../../Utilities/shaders/impostorVertexShader.glsl";
+	const char* g_BillboardFragmentShader = "../../Utilities/shaders/impostorFragmentShader.glsl";
+
+	// the atlas is bound on a unit no scene or fullscreen sampler uses
+	const int g_AtlasTextureUnit = 26;
+	// each layer is a grid of views - a ring around the object per
+	// row, the rows rising from the horizon in steps
+	const int g_CellSize = 128;
+	const int g_AzimuthCount = 8;
+	const int g_ElevationCount = 3;
+	const float g_ElevationStep = 30.0f;
+	// HDR like the scene color, so the highlights survive the bake
+	const GLenum g_AtlasFormat = GL_RGBA16F;
+
+	/***********************************************************
+	 *  GetViewDirection()
+	 *
+	 *  Returns the direction from the object to the camera of
+	 *  the view in the passed in cell.  The billboard shader
+	 *  picks the cell with the inverse of this.
+	 ***********************************************************/
+	glm::vec3 GetViewDirection(int column, int row)
+	{
+		float azimuth = glm::two_pi<float>() * column / g_AzimuthCount;
+		float elevation = glm::radians(g_ElevationStep * row);
+		return(glm::vec3(
+			std::sin(azimuth) * std::cos(elevation),
+			std::sin(elevation),
+			std::cos(azimuth) * std::cos(elevation)));
+	}
+}
+
+/***********************************************************
+ *  Impostors()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Impostors::Impostors(ShaderManager* pSceneShader)
+{
+	m_pSceneShader = pSceneShader;
+	m_pBillboardShader = NULL;
+	m_billboardProgram = 0;
+	m_atlasID = 0;
+	m_layerCount = 0;
+	m_framebufferID = 0;
+	m_depthID = 0;
+	m_billboardVAO = 0;
+	m_instanceVBO = 0;
+
+	// a few dozen draws become one quad below this height
+	m_settings.bEnabled = true;
+	m_settings.switchSize = 48.0f;
+}
+
+/***********************************************************
+ *  ~Impostors()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+Impostors::~Impostors()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for loading the billboard shader and
+ *  creating the empty atlas, the baking framebuffer and the
+ *  instance buffer.
+ ***********************************************************/
+bool Impostors::Create(int layerCount)
+{
+	if (layerCount <= 0)
+	{
+		return false;
+	}
+	m_layerCount = layerCount;
+
+	m_pBillboardShader = new ShaderManager();
+	m_pBillboardShader->LoadShaders(g_BillboardVertexShader, g_BillboardFragmentShader);
+	GL_DEBUG_LABEL_SHADER(m_pBillboardShader, "impostor billboards");
+	m_billboardProgram = PipelineState::GetProgram(m_pBillboardShader);
+	m_bakeState = PipelineState(PipelineState::GetProgram(m_pSceneShader),
+		PipelineState::BLEND_NONE, PipelineState::DEPTH_LESS, true, PipelineState::CULL_BACK);
+
+	int atlasWidth = g_CellSize * g_AzimuthCount;
+	int atlasHeight = g_CellSize * g_ElevationCount;
+
+	glGenTextures(1, &m_atlasID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_atlasID);
+	GL_DEBUG_LABEL(GL_TEXTURE, m_atlasID, "impostor atlas");
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, g_AtlasFormat, atlasWidth, atlasHeight,
+		m_layerCount, 0, GL_RGBA, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	glGenRenderbuffers(1, &m_depthID);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, atlasWidth, atlasHeight);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glGenFramebuffers(1, &m_framebufferID);
+
+	// the center and radius take one attribute and the layer the
+	// next - both advance once per billboard
+	glGenVertexArrays(1, &m_billboardVAO);
+	glGenBuffers(1, &m_instanceVBO);
+	glBindVertexArray(m_billboardVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	GL_DEBUG_LABEL(GL_BUFFER, m_instanceVBO, "impostor instances");
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(IMPOSTOR_INSTANCE), (void*)0);
+	glVertexAttribDivisor(0, 1);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(IMPOSTOR_INSTANCE), (void*)sizeof(glm::vec4));
+	glVertexAttribDivisor(1, 1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	std::cout << "INFO: Impostor atlas " << atlasWidth << "x" << atlasHeight
+		<< " with " << m_layerCount << " layers" << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shader program, the
+ *  atlas and the buffers.
+ ***********************************************************/
+void Impostors::Destroy()
+{
+	if (NULL != m_pBillboardShader)
+	{
+		delete m_pBillboardShader;
+		m_pBillboardShader = NULL;
+	}
+	if (m_atlasID != 0)
+	{
+		glDeleteTextures(1, &m_atlasID);
+		m_atlasID = 0;
+	}
+	if (m_framebufferID != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebufferID);
+		m_framebufferID = 0;
+	}
+	if (m_depthID != 0)
+	{
+		glDeleteRenderbuffers(1, &m_depthID);
+		m_depthID = 0;
+	}
+	if (m_billboardVAO != 0)
+	{
+		glDeleteVertexArrays(1, &m_billboardVAO);
+		m_billboardVAO = 0;
+	}
+	if (m_instanceVBO != 0)
+	{
+		glDeleteBuffers(1, &m_instanceVBO);
+		m_instanceVBO = 0;
+	}
+	m_instances.clear();
+	m_layerCount = 0;
+}
+
+/***********************************************************
+ *  Bake()
+ *
+ *  This method is used for drawing the object into its layer
+ *  once per cell, with an orthographic camera around the
+ *  bounding sphere.  The object keeps its place in the room,
+ *  so the baked views are lit by the scene lights.  Pixels
+ *  the object does not cover keep an alpha of 0, which the
+ *  billboards test against.
+ ***********************************************************/
+void Impostors::Bake(int layer, glm::vec3 center, float radius, std::function<void()> drawObject)
+{
+	if ((m_framebufferID == 0) || (layer < 0) || (layer >= m_layerCount) || (!drawObject))
+	{
+		return;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_atlasID, 0, layer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthID);
+	glViewport(0, 0, g_CellSize * g_AzimuthCount, g_CellSize * g_ElevationCount);
+	PipelineState::Bind(m_bakeState);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// the camera sits two radii out, so the sphere fits between the
+	// near and far planes with room to spare
+	glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, 0.5f * radius, 3.5f * radius);
+	for (int row = 0; row < g_ElevationCount; row++)
+	{
+		for (int column = 0; column < g_AzimuthCount; column++)
+		{
+			glm::vec3 eye = center + GetViewDirection(column, row) * (2.0f * radius);
+			glm::mat4 view = glm::lookAt(eye, center, glm::vec3(0.0f, 1.0f, 0.0f));
+
+			glViewport(column * g_CellSize, row * g_CellSize, g_CellSize, g_CellSize);
+			m_pSceneShader->setMat4Value("view", view);
+			m_pSceneShader->setMat4Value("projection", projection);
+			m_pSceneShader->setMat4Value("currentViewProjection", projection * view);
+			m_pSceneShader->setMat4Value("previousViewProjection", projection * view);
+			m_pSceneShader->setVec3Value("viewPosition", eye);
+			drawObject();
+		}
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_atlasID);
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+/***********************************************************
+ *  IsSmall()
+ *
+ *  This method is used for testing the projected height of
+ *  the bounding sphere against the switch size.  A camera
+ *  inside the sphere always gets the full object.
+ ***********************************************************/
+bool Impostors::IsSmall(glm::vec3 center, float radius, ViewManager* pViewManager, int viewportHeight) const
+{
+	if ((m_settings.bEnabled == false) || (m_atlasID == 0) || (NULL == pViewManager))
+	{
+		return false;
+	}
+
+	glm::mat4 inverseView = glm::inverse(pViewManager->GetViewMatrix());
+	glm::vec3 cameraPosition = glm::vec3(inverseView[3].x, inverseView[3].y, inverseView[3].z);
+	float distance = glm::length(center - cameraPosition);
+	if (distance <= radius)
+	{
+		return false;
+	}
+
+	// [1][1] of the projection is the screen height over the height
+	// of the view one unit in front of the camera
+	float screenSize = radius / distance * pViewManager->GetProjectionMatrix()[1][1] * viewportHeight;
+	return(screenSize < m_settings.switchSize);
+}
+
+/***********************************************************
+ *  AddInstance()
+ *
+ *  This method is used for adding the billboard of a baked
+ *  object to the ones drawn by the next DrawInstances().
+ ***********************************************************/
+void Impostors::AddInstance(int layer, glm::vec3 center, float radius)
+{
+	IMPOSTOR_INSTANCE instance;
+	instance.centerRadius = glm::vec4(center.x, center.y, center.z, radius);
+	instance.layer = (float)layer;
+	m_instances.push_back(instance);
+}
+
+/***********************************************************
+ *  DrawInstances()
+ *
+ *  This method is used for drawing the billboards added this
+ *  frame with one instanced draw.  They are jittered like the
+ *  scene, so the anti-aliasing treats them the same, and the
+ *  scene shader is made current again afterwards.
+ ***********************************************************/
+void Impostors::DrawInstances(ViewManager* pViewManager)
+{
+	if ((m_instances.empty() == true) || (NULL == m_pBillboardShader) || (NULL == pViewManager))
+	{
+		m_instances.clear();
+		return;
+	}
+
+	glm::mat4 view = pViewManager->GetViewMatrix();
+	glm::mat4 projection = pViewManager->GetProjectionMatrix();
+	glm::vec2 jitter = pViewManager->GetProjectionJitter();
+	glm::mat4 jitteredProjection = projection;
+	jitteredProjection[2][0] -= jitter.x;
+	jitteredProjection[2][1] -= jitter.y;
+	glm::mat4 inverseView = glm::inverse(view);
+
+	// a handful of billboards, so the buffer is refilled every frame
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, m_instances.size() * sizeof(IMPOSTOR_INSTANCE),
+		m_instances.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// the billboards are drawn in the middle of the opaque pass, with
+	// its state and their own program.  The quads turn to face the
+	// camera, so they are not culled.
+	PipelineState saved = PipelineState::GetCurrent();
+	PipelineState::Bind(saved.WithProgram(m_billboardProgram).WithCull(PipelineState::CULL_NONE));
+	m_pBillboardShader->setMat4Value("view", view);
+	m_pBillboardShader->setMat4Value("projection", jitteredProjection);
+	m_pBillboardShader->setMat4Value("currentViewProjection", projection * view);
+	m_pBillboardShader->setMat4Value("previousViewProjection", pViewManager->GetPreviousViewProjection());
+	m_pBillboardShader->setVec3Value("viewPosition", glm::vec3(inverseView[3].x, inverseView[3].y, inverseView[3].z));
+	m_pBillboardShader->setIntValue("azimuthCount", g_AzimuthCount);
+	m_pBillboardShader->setIntValue("elevationCount", g_ElevationCount);
+	m_pBillboardShader->setFloatValue("elevationStep", glm::radians(g_ElevationStep));
+	glActiveTexture(GL_TEXTURE0 + g_AtlasTextureUnit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_atlasID);
+	m_pBillboardShader->setSampler2DValue("impostorTexture", g_AtlasTextureUnit);
+
+	glBindVertexArray(m_billboardVAO);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)m_instances.size());
+	glBindVertexArray(0);
+
+	m_instances.clear();
+	PipelineState::Bind(saved);
+}
@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////////////
+// impostors.h
+// ============
+// manage the impostors of the composite objects - views baked into an atlas
+// at load, drawn as one instanced billboard each when an object is small
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "PipelineState.h"
+#include "ViewManager.h"
+
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <vector>
+
+/***********************************************************
+ *  Impostors
+ *
+ *  This class contains the code for replacing an object built
+ *  from many meshes by a single textured quad.  At load, each
+ *  object is drawn with the scene shader from a ring of
+ *  directions around it into one layer of a texture array.
+ *  When the object covers only a few pixels, the billboard
+ *  facing the camera shows the baked view closest to the
+ *  camera direction, and all the billboards of the frame are
+ *  drawn with one instanced draw.
+ ***********************************************************/
+class Impostors
+{
+public:
+	// constructor
+	Impostors(ShaderManager* pSceneShader);
+	// destructor
+	~Impostors();
+
+	// adjustable settings for the impostors
+	struct IMPOSTOR_SETTINGS
+	{
+		bool bEnabled;
+		// objects shorter than this on screen, in pixels, are drawn
+		// as billboards
+		float switchSize;
+	};
+
+	// load the billboard shader and create the atlas with one layer
+	// per object
+	bool Create(int layerCount);
+	// free the shader and OpenGL objects
+	void Destroy();
+
+	// draw every view of an object into its layer, drawObject draws
+	// the object with the scene shader
+	void Bake(int layer, glm::vec3 center, float radius, std::function<void()> drawObject);
+
+	// true when the object is small enough on screen for its billboard
+	bool IsSmall(glm::vec3 center, float radius, ViewManager* pViewManager, int viewportHeight) const;
+
+	// add the billboard of a baked object to this frame's instances
+	void AddInstance(int layer, glm::vec3 center, float radius);
+	// draw this frame's billboards with one draw and clear them
+	void DrawInstances(ViewManager* pViewManager);
+
+	// settings used by the next call to IsSmall()
+	IMPOSTOR_SETTINGS m_settings;
+
+private:
+	// one billboard - bounding sphere and atlas layer
+	struct IMPOSTOR_INSTANCE
+	{
+		glm::vec4 centerRadius;
+		float layer;
+	};
+
+	// scene shader the views are baked with
+	ShaderManager* m_pSceneShader;
+	// shader program for the billboards
+	ShaderManager* m_pBillboardShader;
+	GLuint m_billboardProgram;
+	// opaque scene drawing into the atlas
+	PipelineState m_bakeState;
+	// baked views, one layer per object
+	GLuint m_atlasID;
+	int m_layerCount;
+	// framebuffer and depth buffer for the baking
+	GLuint m_framebufferID;
+	GLuint m_depthID;
+	// instance buffer for the billboards, the corners come from the
+	// vertex index
+	GLuint m_billboardVAO;
+	GLuint m_instanceVBO;
+	std::vector<IMPOSTOR_INSTANCE> m_instances;
+};
@@ -22,6 +22,20 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "RenderTargetPool.h"
+#include "FrameGraph.h"
+#include "PostProcessor.h"
+#include "ScreenSpaceReflections.h"
+#include "FullscreenPass.h"
+#include "EnvironmentProbe.h"
+#include "DeferredDecals.h"
+#include "Skybox.h"
+#include "VolumetricLight.h"
+#include "AmbientOcclusion.h"
+#include "TemporalAntiAliasing.h"
+#include "DebugViews.h"
+#include "GLDebug.h"
+#include "PipelineState.h"
 
 // Namespace for declaring global variables
 namespace
@@ -38,12 +52,59 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// pool of offscreen render targets shared by all passes
+	RenderTargetPool* g_RenderTargetPool = nullptr;
+	// frame graph that schedules the render passes of each frame
+	FrameGraph* g_FrameGraph = nullptr;
+	// post-processing chain from the HDR scene to the window
+	PostProcessor* g_PostProcessor = nullptr;
+	// screen space reflections of the reflective materials
+	ScreenSpaceReflections* g_Reflections = nullptr;
+	// box projected decals drawn over the lit scene
+	DeferredDecals* g_Decals = nullptr;
+	// prefiltered cubemap of the room for the ambient reflections
+	EnvironmentProbe* g_EnvironmentProbe = nullptr;
+	// sky seen through the window
+	Skybox* g_Skybox = nullptr;
+	// light shafts of the window light
+	VolumetricLight* g_VolumetricLight = nullptr;
+	// contact shading of creases and objects resting on surfaces
+	AmbientOcclusion* g_AmbientOcclusion = nullptr;
+	// jittered samples accumulated over frames
+	TemporalAntiAliasing* g_AntiAliasing = nullptr;
+	// heat maps of where the fill rate goes
+	DebugViews* g_DebugViews = nullptr;
+
+	// the window light outside the room, pointLights[0] of the scene,
+	// and the middle of the window it shines through
+	const glm::vec3 WINDOW_LIGHT_POSITION = glm::vec3(-110.0f, 50.0f, 20.0f);
+	const glm::vec3 WINDOW_CENTER = glm::vec3(-70.0f, 30.0f, -2.5f);
+
+	// number of MSAA samples requested for the scene targets
+	const int MSAA_SAMPLES = 4;
+
+	// size of the window's back buffer in pixels
+	int g_FramebufferWidth = 0;
+	int g_FramebufferHeight = 0;
+	// MSAA samples the driver can actually provide
+	int g_SceneSamples = 1;
+	// state of the opaque pass - the transparent textures use
+	// alpha-to-coverage, so blending stays off, and back faces are
+	// culled for every mesh the scene does not draw double sided
+	PipelineState g_OpaqueState;
+	// state of the toggle keys last frame, so a held key toggles once
+	bool g_bOcclusionKeyDown = false;
+	bool g_bAntiAliasingKeyDown = false;
+	bool g_bDebugViewKeyDown = false;
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
 bool InitializeGLEW();
+void BuildFrameGraph();
+void ProcessToggleKeys();
+int AddResolvePass(const char* passName, int source, GLenum internalFormat, GLbitfield mask);
 
 
 /***********************************************************
@@ -75,33 +136,80 @@ int main(int argc, char* argv[])
 		return(EXIT_FAILURE);
 	}
 
+	// debug builds print the driver's errors and warnings
+	GL_DEBUG_START(GL_DEBUG_SEVERITY_MEDIUM);
+
 	// load the shader code from the external GLSL files
 	g_ShaderManager->LoadShaders(
 		"../../Utilities/shaders/vertexShader.glsl",
 		"../../Utilities/shaders/fragmentShader.glsl");
-	g_ShaderManager->use();
+	g_OpaqueState = PipelineState(PipelineState::GetProgram(g_ShaderManager),
+		PipelineState::BLEND_NONE, PipelineState::DEPTH_LESS, true, PipelineState::CULL_BACK);
+	PipelineState::Bind(g_OpaqueState);
+	GL_DEBUG_LABEL_SHADER(g_ShaderManager, "scene");
+
+	// render targets are sized to the window's pixels, and never
+	// ask for more MSAA samples than the driver can provide
+	GLint maxSamples = 1;
+	glfwGetFramebufferSize(g_Window, &g_FramebufferWidth, &g_FramebufferHeight);
+	glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+	g_SceneSamples = (MSAA_SAMPLES < maxSamples) ? MSAA_SAMPLES : maxSamples;
+	std::cout << "INFO: Scene targets " << g_FramebufferWidth << "x" << g_FramebufferHeight
+		<< " using " << g_SceneSamples << "x MSAA" << std::endl;
+
+	// create the render target pool, frame graph and post chain
+	g_RenderTargetPool = new RenderTargetPool();
+	g_FrameGraph = new FrameGraph(g_RenderTargetPool);
+	g_PostProcessor = new PostProcessor();
+	g_PostProcessor->Create(g_FramebufferWidth, g_FramebufferHeight);
+	g_Reflections = new ScreenSpaceReflections(g_ViewManager);
+	g_Reflections->Create(g_FramebufferWidth, g_FramebufferHeight, g_RenderTargetPool);
+	g_Decals = new DeferredDecals(g_ViewManager);
+	g_Decals->Create();
+	g_AmbientOcclusion = new AmbientOcclusion(g_ViewManager);
+	g_AmbientOcclusion->Create(g_FramebufferWidth, g_FramebufferHeight, g_RenderTargetPool);
+	g_AntiAliasing = new TemporalAntiAliasing(g_ViewManager);
+	g_AntiAliasing->Create(g_FramebufferWidth, g_FramebufferHeight, g_RenderTargetPool);
+	g_DebugViews = new DebugViews(g_ViewManager, g_ShaderManager);
+	g_DebugViews->Create();
+	// the generated sky puts its sun behind the window light
+	g_Skybox = new Skybox();
+	g_Skybox->Create("../5-2_Assignment/textures/skybox/", WINDOW_LIGHT_POSITION);
 
 	// try to create a new scene manager object and prepare the 3D scene
 	g_SceneManager = new SceneManager(g_ShaderManager);
 	g_SceneManager->PrepareScene();
+	g_SceneManager->DefineSceneDecals(g_Decals);
+
+	// capture the room from the middle of it, or load the last capture
+	g_EnvironmentProbe = new EnvironmentProbe(g_ShaderManager);
+	g_EnvironmentProbe->Create(glm::vec3(0.0f, 8.0f, 5.0f), "environmentProbe.cache",
+		[]() { g_SceneManager->RenderScene(); });
+
+	// the window light's depth map is rendered once the scene exists
+	g_VolumetricLight = new VolumetricLight(g_ViewManager, g_ShaderManager);
+	g_VolumetricLight->Create(g_FramebufferWidth, g_FramebufferHeight, g_RenderTargetPool,
+		WINDOW_LIGHT_POSITION, WINDOW_CENTER, []() { g_SceneManager->RenderScene(); });
+
+	// the far away views of the composite objects are lit by the
+	// environment, so they are baked last
+	g_SceneManager->BakeImpostors();
 
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
 	while (!glfwWindowShouldClose(g_Window))
 	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
-
-		// Clear the frame and z buffers
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		// switch the optional passes on and off
+		ProcessToggleKeys();
 
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
-
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
+		// recycle render targets that no pass has used lately
+		g_RenderTargetPool->BeginFrame();
 
+		// declare this frame's passes, then cull, allocate and run them
+		BuildFrameGraph();
+		g_FrameGraph->Compile();
+		g_FrameGraph->Execute();
+		GL_DEBUG_END_FRAME();
 
 		// Flips the the back buffer with the front buffer every frame.
 		glfwSwapBuffers(g_Window);
@@ -111,6 +219,16 @@ int main(int argc, char* argv[])
 	}
 
 	// clear the allocated manager objects from memory
+	if (NULL != g_EnvironmentProbe)
+	{
+		delete g_EnvironmentProbe;
+		g_EnvironmentProbe = NULL;
+	}
+	if (NULL != g_VolumetricLight)
+	{
+		delete g_VolumetricLight;
+		g_VolumetricLight = NULL;
+	}
 	if (NULL != g_SceneManager)
 	{
 		delete g_SceneManager;
@@ -121,6 +239,52 @@ int main(int argc, char* argv[])
 		delete g_ViewManager;
 		g_ViewManager = NULL;
 	}
+	if (NULL != g_PostProcessor)
+	{
+		delete g_PostProcessor;
+		g_PostProcessor = NULL;
+	}
+	if (NULL != g_Reflections)
+	{
+		delete g_Reflections;
+		g_Reflections = NULL;
+	}
+	if (NULL != g_Decals)
+	{
+		delete g_Decals;
+		g_Decals = NULL;
+	}
+	if (NULL != g_Skybox)
+	{
+		delete g_Skybox;
+		g_Skybox = NULL;
+	}
+	if (NULL != g_AmbientOcclusion)
+	{
+		delete g_AmbientOcclusion;
+		g_AmbientOcclusion = NULL;
+	}
+	if (NULL != g_AntiAliasing)
+	{
+		delete g_AntiAliasing;
+		g_AntiAliasing = NULL;
+	}
+	if (NULL != g_DebugViews)
+	{
+		delete g_DebugViews;
+		g_DebugViews = NULL;
+	}
+	FullscreenPass::Destroy();
+	if (NULL != g_FrameGraph)
+	{
+		delete g_FrameGraph;
+		g_FrameGraph = NULL;
+	}
+	if (NULL != g_RenderTargetPool)
+	{
+		delete g_RenderTargetPool;
+		g_RenderTargetPool = NULL;
+	}
 	if (NULL != g_ShaderManager)
 	{
 		delete g_ShaderManager;
@@ -131,6 +295,167 @@ int main(int argc, char* argv[])
 	exit(EXIT_SUCCESS); 
 }
 
+/***********************************************************
+ *	BuildFrameGraph()
+ *
+ *  This function is used to declare the render passes of the
+ *  current frame and the targets they read and write.  The
+ *  frame graph decides which passes run, when each target is
+ *  cleared and which targets share memory.
+ ***********************************************************/
+void BuildFrameGraph()
+{
+	g_FrameGraph->Reset();
+
+	// the window's back buffer is owned by GLFW
+	int backBuffer = g_FrameGraph->ImportTarget("backBuffer", 0, 0,
+		g_FramebufferWidth, g_FramebufferHeight);
+
+	// multisampled HDR scene color, surface, lighting, velocity and
+	// depth, cleared on first use - the surface holds the view space
+	// normal and the reflectivity for the screen space passes, the
+	// lighting holds the diffuse light the decals are lit with, and
+	// the velocity the screen motion the anti-aliasing follows
+	int sceneColor = g_FrameGraph->CreateTarget("sceneColor",
+		g_FramebufferWidth, g_FramebufferHeight, GL_RGBA16F, g_SceneSamples,
+		true, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	int sceneSurface = g_FrameGraph->CreateTarget("sceneSurface",
+		g_FramebufferWidth, g_FramebufferHeight, GL_RGBA16F, g_SceneSamples,
+		true);
+	int sceneLighting = g_FrameGraph->CreateTarget("sceneLighting",
+		g_FramebufferWidth, g_FramebufferHeight, GL_R11F_G11F_B10F, g_SceneSamples,
+		true);
+	int sceneVelocity = g_FrameGraph->CreateTarget("sceneVelocity",
+		g_FramebufferWidth, g_FramebufferHeight, GL_RG16F, g_SceneSamples,
+		true);
+	int sceneDepth = g_FrameGraph->CreateTarget("sceneDepth",
+		g_FramebufferWidth, g_FramebufferHeight, GL_DEPTH24_STENCIL8, g_SceneSamples,
+		true);
+
+	// opaque and alpha-to-coverage geometry
+	g_FrameGraph->AddPass("opaque", {}, { sceneColor, sceneSurface, sceneLighting, sceneVelocity, sceneDepth },
+		[]()
+		{
+			// the post passes use their own shaders, so switch back
+			// to the scene shader before any scene uniforms are set
+			PipelineState::Bind(g_OpaqueState);
+
+			// convert from 3D object space to 2D view
+			g_ViewManager->PrepareSceneView();
+
+			// refresh the 3D scene, with billboards for the objects
+			// that are small from this camera
+			g_DebugViews->RenderScene([]()
+				{
+					g_SceneManager->SetLevelOfDetailView(g_ViewManager, g_FramebufferHeight);
+					g_SceneManager->RenderScene();
+				});
+
+			// the sky last, so it only shades what the room left
+			// at the far plane - the debug views leave it out
+			if (g_DebugViews->IsActive() == false)
+			{
+				g_Skybox->Draw(g_ViewManager->GetViewMatrix(), g_ViewManager->GetProjectionMatrix());
+			}
+		});
+
+	// resolve the MSAA samples into single-sampled targets - the
+	// surface, lighting, velocity and depth resolves are culled when
+	// nothing reads them
+	int hdrColor = AddResolvePass("resolveColor", sceneColor, GL_RGBA16F, GL_COLOR_BUFFER_BIT);
+	int resolvedSurface = AddResolvePass("resolveSurface", sceneSurface, GL_RGBA16F, GL_COLOR_BUFFER_BIT);
+	int resolvedLighting = AddResolvePass("resolveLighting", sceneLighting, GL_R11F_G11F_B10F, GL_COLOR_BUFFER_BIT);
+	int resolvedVelocity = AddResolvePass("resolveVelocity", sceneVelocity, GL_RG16F, GL_COLOR_BUFFER_BIT);
+	int resolvedDepth = AddResolvePass("resolveDepth", sceneDepth, GL_DEPTH24_STENCIL8, GL_DEPTH_BUFFER_BIT);
+
+	// a debug view goes straight to the back buffer - the resolves
+	// nothing reads are culled with the passes that were left out
+	if (g_DebugViews->IsActive() == true)
+	{
+		g_DebugViews->AddPasses(g_FrameGraph, hdrColor, backBuffer);
+		return;
+	}
+
+	// decals change the color and the surface the reflections read
+	g_Decals->AddPasses(g_FrameGraph, hdrColor, resolvedSurface, resolvedDepth, resolvedLighting);
+
+	// occlusion darkens the decals too, but not the reflections
+	g_AmbientOcclusion->AddPasses(g_FrameGraph, hdrColor, resolvedDepth, resolvedSurface);
+
+	// reflections are blended into the HDR color before the post chain
+	g_Reflections->AddPasses(g_FrameGraph, hdrColor, resolvedDepth, resolvedSurface);
+
+	// light shafts are in front of every surface, reflections included
+	g_VolumetricLight->AddPasses(g_FrameGraph, hdrColor, resolvedDepth);
+
+	// accumulate the jittered frames, the post chain reads the result
+	int antiAliasedColor = g_AntiAliasing->AddPasses(g_FrameGraph, hdrColor, resolvedVelocity, resolvedDepth);
+
+	// bloom, tonemap and FXAA into the back buffer
+	g_PostProcessor->AddPasses(g_FrameGraph, antiAliasedColor, backBuffer);
+}
+
+/***********************************************************
+ *	ProcessToggleKeys()
+ *
+ *  This function is used to switch the optional passes on
+ *  and off when their key is pressed:
+ *    O - ambient occlusion, printing its last average cost
+ *    T - temporal anti-aliasing
+ *    V - next debug view, see DebugViews.h
+ ***********************************************************/
+void ProcessToggleKeys()
+{
+	bool bOcclusionKey = (glfwGetKey(g_Window, GLFW_KEY_O) == GLFW_PRESS);
+	if ((bOcclusionKey == true) && (g_bOcclusionKeyDown == false))
+	{
+		g_AmbientOcclusion->m_settings.bEnabled = !g_AmbientOcclusion->m_settings.bEnabled;
+		std::cout << "INFO: Ambient occlusion " << ((g_AmbientOcclusion->m_settings.bEnabled == true) ? "on" : "off")
+			<< ", last average " << g_AmbientOcclusion->GetAverageTime() << " ms" << std::endl;
+	}
+	g_bOcclusionKeyDown = bOcclusionKey;
+
+	bool bAntiAliasingKey = (glfwGetKey(g_Window, GLFW_KEY_T) == GLFW_PRESS);
+	if ((bAntiAliasingKey == true) && (g_bAntiAliasingKeyDown == false))
+	{
+		g_AntiAliasing->m_settings.bEnabled = !g_AntiAliasing->m_settings.bEnabled;
+		std::cout << "INFO: Temporal anti-aliasing " << ((g_AntiAliasing->m_settings.bEnabled == true) ? "on" : "off") << std::endl;
+	}
+	g_bAntiAliasingKeyDown = bAntiAliasingKey;
+
+	bool bDebugViewKey = (glfwGetKey(g_Window, GLFW_KEY_V) == GLFW_PRESS);
+	if ((bDebugViewKey == true) && (g_bDebugViewKeyDown == false))
+	{
+		g_DebugViews->NextView();
+	}
+	g_bDebugViewKeyDown = bDebugViewKey;
+}
+
+/***********************************************************
+ *	AddResolvePass()
+ *
+ *  This function is used to add a pass that resolves a
+ *  multisampled scene target into a new single-sampled
+ *  target of the passed in format.  Returns the new target.
+ ***********************************************************/
+int AddResolvePass(const char* passName, int source, GLenum internalFormat, GLbitfield mask)
+{
+	int target = g_FrameGraph->CreateTarget(passName, g_FramebufferWidth, g_FramebufferHeight,
+		internalFormat);
+
+	g_FrameGraph->AddPass(passName, { source }, { target },
+		[source, mask]()
+		{
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, g_FrameGraph->GetFramebuffer(source));
+			glBlitFramebuffer(
+				0, 0, g_FramebufferWidth, g_FramebufferHeight,
+				0, 0, g_FramebufferWidth, g_FramebufferHeight,
+				mask, GL_NEAREST);
+		});
+
+	return(target);
+}
+
 /***********************************************************
  *	InitializeGLFW()
  * 
@@ -152,6 +477,10 @@ bool InitializeGLFW()
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#endif
+#ifdef GL_DEBUG_ENABLED
+	// the driver only reports everything to a debug context
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
 #endif
 	// GLFW: end -------------------------------
 
@@ -0,0 +1,378 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshdeformer.cpp
+// ============
+// manage the deformed copies of the basic meshes - bend, twist, taper and
+// wave deformers evaluated on the GPU and cached until they change
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshDeformer.h"
+#include "GLDebug.h"
+#include "PipelineState.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// declare the global variables
+namespace
+{
+	const char* g_DeformVertexShader = "../../Utilities/shaders/deformVertexShader.glsl";
+
+	// the deformers are unrolled in the shader up to this count
+	const int g_MaxDeformers = 4;
+	// position, normal and texture coordinate of a captured vertex
+	const int g_FloatsPerVertex = 8;
+	// first guess for the buffer size, grown when a mesh is larger
+	const int g_InitialCapacity = 4096;
+}
+
+/***********************************************************
+ *  MeshDeformer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshDeformer::MeshDeformer()
+{
+	m_programID = 0;
+	m_primitivesQuery = 0;
+}
+
+/***********************************************************
+ *  ~MeshDeformer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MeshDeformer::~MeshDeformer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for building the deform program.  It
+ *  has no fragment stage and its outputs are captured, so the
+ *  captured names are set before the program is linked.
+ ***********************************************************/
+bool MeshDeformer::Create()
+{
+	std::ifstream file(g_DeformVertexShader);
+	if (!file)
+	{
+		std::cout << "Could not open " << g_DeformVertexShader << std::endl;
+		return false;
+	}
+	std::stringstream source;
+	source << file.rdbuf();
+	std::string code = source.str();
+	const char* codeText = code.c_str();
+
+	GLuint shaderID = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(shaderID, 1, &codeText, NULL);
+	glCompileShader(shaderID);
+	GLint status = 0;
+	glGetShaderiv(shaderID, GL_COMPILE_STATUS, &status);
+	if (status == GL_FALSE)
+	{
+		char infoLog[1024];
+		glGetShaderInfoLog(shaderID, sizeof(infoLog), NULL, infoLog);
+		std::cout << "ERROR: deform shader compile failed\n" << infoLog << std::endl;
+		glDeleteShader(shaderID);
+		return false;
+	}
+
+	m_programID = glCreateProgram();
+	glAttachShader(m_programID, shaderID);
+	const char* varyings[] = { "deformedPosition", "deformedNormal", "deformedTextureCoordinate" };
+	glTransformFeedbackVaryings(m_programID, 3, varyings, GL_INTERLEAVED_ATTRIBS);
+	glLinkProgram(m_programID);
+	glDeleteShader(shaderID);
+	GL_DEBUG_LABEL(GL_PROGRAM, m_programID, "mesh deformer");
+	glGetProgramiv(m_programID, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE)
+	{
+		char infoLog[1024];
+		glGetProgramInfoLog(m_programID, sizeof(infoLog), NULL, infoLog);
+		std::cout << "ERROR: deform program link failed\n" << infoLog << std::endl;
+		glDeleteProgram(m_programID);
+		m_programID = 0;
+		return false;
+	}
+
+	glGenQueries(1, &m_primitivesQuery);
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the deform program and
+ *  the buffers of the deformed meshes.
+ ***********************************************************/
+void MeshDeformer::Destroy()
+{
+	std::map<std::string, DEFORMED_MESH>::iterator it;
+	for (it = m_meshes.begin(); it != m_meshes.end(); it++)
+	{
+		glDeleteVertexArrays(1, &it->second.VAO);
+		glDeleteBuffers(1, &it->second.VBO);
+	}
+	m_meshes.clear();
+
+	if (m_programID != 0)
+	{
+		glDeleteProgram(m_programID);
+		m_programID = 0;
+	}
+	if (m_primitivesQuery != 0)
+	{
+		glDeleteQueries(1, &m_primitivesQuery);
+		m_primitivesQuery = 0;
+	}
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used for drawing a deformed mesh with the
+ *  current shader.  The deformed copy is captured the first
+ *  time and whenever the deformers change; otherwise the
+ *  cached copy is drawn as is.  Without the deform program
+ *  the mesh is drawn undeformed.
+ ***********************************************************/
+void MeshDeformer::Draw(const std::string& objectTag, const std::vector<DEFORMER>& deformers,
+	std::function<void()> drawMesh)
+{
+	if ((m_programID == 0) || (deformers.size() == 0))
+	{
+		drawMesh();
+		return;
+	}
+
+	bool bCapture = false;
+	std::map<std::string, DEFORMED_MESH>::iterator it = m_meshes.find(objectTag);
+	if (it == m_meshes.end())
+	{
+		DEFORMED_MESH mesh;
+		mesh.VAO = 0;
+		mesh.VBO = 0;
+		mesh.capacity = 0;
+		mesh.vertexCount = 0;
+		AllocateMesh(mesh, g_InitialCapacity);
+		it = m_meshes.insert(std::make_pair(objectTag, mesh)).first;
+		bCapture = true;
+	}
+	else if (it->second.deformers.size() != deformers.size())
+	{
+		bCapture = true;
+	}
+	else
+	{
+		for (int i = 0; i < deformers.size(); i++)
+		{
+			const DEFORMER& cached = it->second.deformers[i];
+			if ((cached.type != deformers[i].type) ||
+				(cached.axis != deformers[i].axis) ||
+				(cached.amount != deformers[i].amount) ||
+				(cached.frequency != deformers[i].frequency) ||
+				(cached.phase != deformers[i].phase))
+			{
+				bCapture = true;
+			}
+		}
+	}
+
+	DEFORMED_MESH& mesh = it->second;
+	if (bCapture == true)
+	{
+		mesh.deformers = deformers;
+		if (Capture(mesh, drawMesh) == false)
+		{
+			drawMesh();
+			return;
+		}
+	}
+
+	glBindVertexArray(mesh.VAO);
+	glDrawArrays(GL_TRIANGLES, 0, mesh.vertexCount);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  ReadTriangles()
+ *
+ *  This method is used for reading back the triangles of a
+ *  mesh.  The mesh is captured through the passed in
+ *  deformers, none by default, and the object space positions
+ *  and normals come back as the mesh draws them, three
+ *  vertices per triangle in their winding order.
+ ***********************************************************/
+bool MeshDeformer::ReadTriangles(std::function<void()> drawMesh, std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals, const std::vector<DEFORMER>& deformers)
+{
+	positions.clear();
+	normals.clear();
+	if (m_programID == 0)
+	{
+		return false;
+	}
+
+	DEFORMED_MESH mesh;
+	mesh.deformers = deformers;
+	mesh.VAO = 0;
+	mesh.VBO = 0;
+	mesh.capacity = 0;
+	mesh.vertexCount = 0;
+	AllocateMesh(mesh, g_InitialCapacity);
+
+	bool bRead = Capture(mesh, drawMesh);
+	if (bRead == true)
+	{
+		std::vector<float> vertices((size_t)mesh.vertexCount * g_FloatsPerVertex);
+		glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+		glGetBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(float), vertices.data());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		for (int i = 0; i < mesh.vertexCount; i++)
+		{
+			const float* vertex = &vertices[(size_t)i * g_FloatsPerVertex];
+			positions.push_back(glm::vec3(vertex[0], vertex[1], vertex[2]));
+			normals.push_back(glm::vec3(vertex[3], vertex[4], vertex[5]));
+		}
+	}
+
+	glDeleteVertexArrays(1, &mesh.VAO);
+	glDeleteBuffers(1, &mesh.VBO);
+
+	return(bRead);
+}
+
+/***********************************************************
+ *  CountInvertedTriangles()
+ *
+ *  This method is used for checking the winding of a mesh.
+ *  A triangle whose counterclockwise face normal points away
+ *  from its vertex normals is counted as inverted - culling
+ *  would remove its outside.  Triangles with no area, like
+ *  the ones at the poles of a sphere, are not counted.
+ ***********************************************************/
+int MeshDeformer::CountInvertedTriangles(std::function<void()> drawMesh, int& triangleCount)
+{
+	triangleCount = 0;
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	if (ReadTriangles(drawMesh, positions, normals) == false)
+	{
+		return(0);
+	}
+
+	int inverted = 0;
+	for (int i = 0; i + 2 < (int)positions.size(); i += 3)
+	{
+		glm::vec3 faceNormal = glm::cross(positions[i + 1] - positions[i], positions[i + 2] - positions[i]);
+		glm::vec3 normal = normals[i] + normals[i + 1] + normals[i + 2];
+		if ((glm::length(faceNormal) < 1.0e-8f) || (glm::length(normal) < 1.0e-4f))
+		{
+			continue;
+		}
+		triangleCount++;
+		if (glm::dot(faceNormal, normal) < 0.0f)
+		{
+			inverted++;
+		}
+	}
+
+	return(inverted);
+}
+
+/***********************************************************
+ *  Capture()
+ *
+ *  This method is used for drawing the mesh with the deform
+ *  program into the mesh buffer, with rasterization off.  The
+ *  triangles written are counted, and a mesh that filled the
+ *  buffer is captured again into a larger one.  Only happens
+ *  when the deformers change, so waiting for the count is ok.
+ ***********************************************************/
+bool MeshDeformer::Capture(DEFORMED_MESH& mesh, std::function<void()> drawMesh)
+{
+	// no fragments, the vertices only go into the buffer
+	PipelineState saved = PipelineState::GetCurrent();
+	PipelineState::Bind(PipelineState(m_programID, PipelineState::BLEND_NONE, PipelineState::DEPTH_OFF,
+		true, PipelineState::CULL_NONE, PipelineState::RASTER_DISCARD));
+	int count = (mesh.deformers.size() < g_MaxDeformers) ? (int)mesh.deformers.size() : g_MaxDeformers;
+	glUniform1i(glGetUniformLocation(m_programID, "deformerCount"), count);
+	for (int i = 0; i < count; i++)
+	{
+		std::string index = "[" + std::to_string(i) + "]";
+		const DEFORMER& deformer = mesh.deformers[i];
+		glUniform1i(glGetUniformLocation(m_programID, ("deformerTypes" + index).c_str()), (int)deformer.type);
+		glUniform1i(glGetUniformLocation(m_programID, ("deformerAxes" + index).c_str()), deformer.axis);
+		glUniform3f(glGetUniformLocation(m_programID, ("deformerParams" + index).c_str()),
+			deformer.amount, deformer.frequency, deformer.phase);
+	}
+
+	bool bCaptured = false;
+	while (bCaptured == false)
+	{
+		glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, mesh.VBO);
+		glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, m_primitivesQuery);
+		glBeginTransformFeedback(GL_TRIANGLES);
+		drawMesh();
+		glEndTransformFeedback();
+		glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+		glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+
+		GLuint primitives = 0;
+		glGetQueryObjectuiv(m_primitivesQuery, GL_QUERY_RESULT, &primitives);
+		mesh.vertexCount = (int)primitives * 3;
+
+		// a full buffer may have dropped triangles
+		if (mesh.vertexCount + 3 > mesh.capacity)
+		{
+			AllocateMesh(mesh, mesh.capacity * 2);
+		}
+		else
+		{
+			bCaptured = true;
+		}
+	}
+
+	PipelineState::Bind(saved);
+
+	return(mesh.vertexCount > 0);
+}
+
+/***********************************************************
+ *  AllocateMesh()
+ *
+ *  This method is used for creating the buffer of a deformed
+ *  mesh with room for the passed in number of vertices, and
+ *  the vertex array that draws it with the scene shader's
+ *  position, normal and texture coordinate attributes.
+ ***********************************************************/
+void MeshDeformer::AllocateMesh(DEFORMED_MESH& mesh, int capacity)
+{
+	if (mesh.VAO == 0)
+	{
+		glGenVertexArrays(1, &mesh.VAO);
+		glGenBuffers(1, &mesh.VBO);
+	}
+	mesh.capacity = capacity;
+
+	glBindVertexArray(mesh.VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+	GL_DEBUG_LABEL(GL_BUFFER, mesh.VBO, "deformed mesh");
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)capacity * g_FloatsPerVertex * sizeof(float), NULL, GL_STATIC_DRAW);
+	GLsizei stride = g_FloatsPerVertex * sizeof(float);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
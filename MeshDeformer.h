@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshdeformer.h
+// ============
+// manage the deformed copies of the basic meshes - bend, twist, taper and
+// wave deformers evaluated on the GPU and cached until they change
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  MeshDeformer
+ *
+ *  This class contains the code for drawing a basic mesh
+ *  through a stack of deformers.  The mesh is drawn once with
+ *  the deform program and transform feedback captures the
+ *  deformed object space vertices into a buffer kept for the
+ *  object.  Later frames draw that buffer with the scene
+ *  shader, until the object's deformers change.
+ ***********************************************************/
+class MeshDeformer
+{
+public:
+	// constructor
+	MeshDeformer();
+	// destructor
+	~MeshDeformer();
+
+	// the kinds of deformation, each varies along one mesh axis
+	enum DEFORMER_TYPE
+	{
+		// curve the mesh around the axis, amount is the curvature
+		DEFORM_BEND = 0,
+		// rotate around the axis, amount is radians per unit
+		DEFORM_TWIST = 1,
+		// scale across the axis, amount is the change per unit
+		DEFORM_TAPER = 2,
+		// sine offset across the axis, amount is the height
+		DEFORM_WAVE = 3
+	};
+
+	// properties for one deformer
+	struct DEFORMER
+	{
+		DEFORMER_TYPE type;
+		// 0, 1 or 2 for the mesh X, Y or Z axis
+		int axis;
+		float amount;
+		// only used by the wave
+		float frequency;
+		float phase;
+	};
+
+	// build the deform program
+	bool Create();
+	// free the program and every cached mesh
+	void Destroy();
+
+	// draw the mesh that drawMesh draws, deformed by up to four
+	// deformers.  The deformed copy is cached under the object tag
+	// and only captured again when the deformers differ.
+	void Draw(const std::string& objectTag, const std::vector<DEFORMER>& deformers,
+		std::function<void()> drawMesh);
+	// capture the mesh that drawMesh draws, through the deformers
+	// if any, and read back the object space corners of its
+	// triangles
+	bool ReadTriangles(std::function<void()> drawMesh, std::vector<glm::vec3>& positions,
+		std::vector<glm::vec3>& normals, const std::vector<DEFORMER>& deformers = std::vector<DEFORMER>());
+	// count the triangles wound against their normals, for the
+	// culling checks
+	int CountInvertedTriangles(std::function<void()> drawMesh, int& triangleCount);
+
+private:
+	// deformed copy of one object's mesh
+	struct DEFORMED_MESH
+	{
+		std::vector<DEFORMER> deformers;
+		GLuint VAO;
+		GLuint VBO;
+		// capacity of the buffer and the vertices captured into it
+		int capacity;
+		int vertexCount;
+	};
+
+	// transform feedback program that applies the deformers
+	GLuint m_programID;
+	// query for the number of captured triangles
+	GLuint m_primitivesQuery;
+	// deformed meshes by object tag
+	std::map<std::string, DEFORMED_MESH> m_meshes;
+
+	// capture the deformed mesh into the object's buffer
+	bool Capture(DEFORMED_MESH& mesh, std::function<void()> drawMesh);
+	// create or grow the buffer of a deformed mesh
+	void AllocateMesh(DEFORMED_MESH& mesh, int capacity);
+};
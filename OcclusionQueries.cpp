@@ -0,0 +1,264 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionqueries.cpp
+// ============
+// manage the occlusion tests of the composite objects - bounding boxes tested
+// against the depth each frame, and the next frame's draws made conditional
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OcclusionQueries.h"
+#include "GLDebug.h"
+
+#include <iostream>
+
+// declare the global variables
+namespace
+{
+	const char* g_BoxVertexShader = "../../Utilities/shaders/occlusionBoxVertexShader.glsl";
+	const char* g_BoxFragmentShader = "../../Utilities/shaders/occlusionBoxFragmentShader.glsl";
+
+	// unit cube, counter-clockwise from the outside - 6 faces of
+	// 2 triangles
+	const float g_CubeVertices[] = {
+		// +Z
+		-0.5f, -0.5f, 0.5f,  0.5f, -0.5f, 0.5f,  0.5f, 0.5f, 0.5f,
+		-0.5f, -0.5f, 0.5f,  0.5f, 0.5f, 0.5f,  -0.5f, 0.5f, 0.5f,
+		// -Z
+		0.5f, -0.5f, -0.5f,  -0.5f, -0.5f, -0.5f,  -0.5f, 0.5f, -0.5f,
+		0.5f, -0.5f, -0.5f,  -0.5f, 0.5f, -0.5f,  0.5f, 0.5f, -0.5f,
+		// +X
+		0.5f, -0.5f, 0.5f,  0.5f, -0.5f, -0.5f,  0.5f, 0.5f, -0.5f,
+		0.5f, -0.5f, 0.5f,  0.5f, 0.5f, -0.5f,  0.5f, 0.5f, 0.5f,
+		// -X
+		-0.5f, -0.5f, -0.5f,  -0.5f, -0.5f, 0.5f,  -0.5f, 0.5f, 0.5f,
+		-0.5f, -0.5f, -0.5f,  -0.5f, 0.5f, 0.5f,  -0.5f, 0.5f, -0.5f,
+		// +Y
+		-0.5f, 0.5f, 0.5f,  0.5f, 0.5f, 0.5f,  0.5f, 0.5f, -0.5f,
+		-0.5f, 0.5f, 0.5f,  0.5f, 0.5f, -0.5f,  -0.5f, 0.5f, -0.5f,
+		// -Y
+		-0.5f, -0.5f, -0.5f,  0.5f, -0.5f, -0.5f,  0.5f, -0.5f, 0.5f,
+		-0.5f, -0.5f, -0.5f,  0.5f, -0.5f, 0.5f,  -0.5f, -0.5f, 0.5f };
+	const int g_CubeVertexCount = 36;
+
+	// a camera this close to a box could have its near plane cut
+	// the box, which would hide an object that is in plain view
+	const float g_InsideMargin = 0.5f;
+}
+
+/***********************************************************
+ *  OcclusionQueries()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OcclusionQueries::OcclusionQueries()
+{
+	m_pBoxShader = NULL;
+	m_boxVAO = 0;
+	m_boxVBO = 0;
+
+	m_settings.bEnabled = true;
+}
+
+/***********************************************************
+ *  ~OcclusionQueries()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+OcclusionQueries::~OcclusionQueries()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for loading the box shader, creating
+ *  the unit cube and one query for every object.
+ ***********************************************************/
+bool OcclusionQueries::Create(int objectCount)
+{
+	if (objectCount <= 0)
+	{
+		return false;
+	}
+
+	m_pBoxShader = new ShaderManager();
+	m_pBoxShader->LoadShaders(g_BoxVertexShader, g_BoxFragmentShader);
+	GL_DEBUG_LABEL_SHADER(m_pBoxShader, "occlusion boxes");
+	m_boxState = PipelineState(PipelineState::GetProgram(m_pBoxShader), PipelineState::BLEND_NONE,
+		PipelineState::DEPTH_LESS, false, PipelineState::CULL_NONE, PipelineState::RASTER_FILL, false);
+
+	glGenVertexArrays(1, &m_boxVAO);
+	glGenBuffers(1, &m_boxVBO);
+	glBindVertexArray(m_boxVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_boxVBO);
+	GL_DEBUG_LABEL(GL_BUFFER, m_boxVBO, "occlusion box");
+	glBufferData(GL_ARRAY_BUFFER, sizeof(g_CubeVertices), g_CubeVertices, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	m_objects.resize(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		glGenQueries(1, &m_objects[i].query);
+		m_objects[i].bTested = false;
+		m_objects[i].bQueued = false;
+		m_objects[i].bConditional = false;
+		m_objects[i].center = glm::vec3(0.0f);
+		m_objects[i].halfSize = glm::vec3(0.0f);
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shader program, the
+ *  queries and the cube.
+ ***********************************************************/
+void OcclusionQueries::Destroy()
+{
+	if (NULL != m_pBoxShader)
+	{
+		delete m_pBoxShader;
+		m_pBoxShader = NULL;
+	}
+	for (int i = 0; i < (int)m_objects.size(); i++)
+	{
+		glDeleteQueries(1, &m_objects[i].query);
+	}
+	m_objects.clear();
+	if (m_boxVAO != 0)
+	{
+		glDeleteVertexArrays(1, &m_boxVAO);
+		m_boxVAO = 0;
+	}
+	if (m_boxVBO != 0)
+	{
+		glDeleteBuffers(1, &m_boxVBO);
+		m_boxVBO = 0;
+	}
+}
+
+/***********************************************************
+ *  BeginConditionalDraw()
+ *
+ *  This method is used for starting the conditional render
+ *  of an object on its test from the last frame.  An object
+ *  that was not tested, such as one drawn as a billboard or
+ *  one the camera is inside of, is drawn as usual.
+ ***********************************************************/
+void OcclusionQueries::BeginConditionalDraw(int index)
+{
+	if ((index < 0) || (index >= (int)m_objects.size()))
+	{
+		return;
+	}
+
+	OCCLUSION_OBJECT& object = m_objects[index];
+	object.bConditional = ((m_settings.bEnabled == true) && (object.bTested == true));
+	if (object.bConditional == true)
+	{
+		glBeginConditionalRender(object.query, GL_QUERY_NO_WAIT);
+	}
+}
+
+/***********************************************************
+ *  EndConditionalDraw()
+ *
+ *  This method is used for ending the conditional render
+ *  started for an object.
+ ***********************************************************/
+void OcclusionQueries::EndConditionalDraw(int index)
+{
+	if ((index < 0) || (index >= (int)m_objects.size()))
+	{
+		return;
+	}
+
+	if (m_objects[index].bConditional == true)
+	{
+		glEndConditionalRender();
+		m_objects[index].bConditional = false;
+	}
+}
+
+/***********************************************************
+ *  AddBox()
+ *
+ *  This method is used for queueing the bounding box of an
+ *  object for the test at the end of the frame.
+ ***********************************************************/
+void OcclusionQueries::AddBox(int index, glm::vec3 center, glm::vec3 halfSize)
+{
+	if ((index < 0) || (index >= (int)m_objects.size()))
+	{
+		return;
+	}
+
+	m_objects[index].bQueued = true;
+	m_objects[index].center = center;
+	m_objects[index].halfSize = halfSize;
+}
+
+/***********************************************************
+ *  TestBoxes()
+ *
+ *  This method is used for drawing the queued boxes against
+ *  the depth of the whole frame, each inside its occlusion
+ *  query.  The boxes use the jittered projection of the
+ *  scene, so they line up with the depth they are tested
+ *  against.  Objects that were not queued are not tested and
+ *  are drawn in full the next frame.
+ ***********************************************************/
+void OcclusionQueries::TestBoxes(ViewManager* pViewManager)
+{
+	if ((NULL == m_pBoxShader) || (NULL == pViewManager))
+	{
+		return;
+	}
+
+	glm::mat4 view = pViewManager->GetViewMatrix();
+	glm::mat4 projection = pViewManager->GetProjectionMatrix();
+	glm::vec2 jitter = pViewManager->GetProjectionJitter();
+	projection[2][0] -= jitter.x;
+	projection[2][1] -= jitter.y;
+	glm::mat4 inverseView = glm::inverse(view);
+	glm::vec3 cameraPosition = glm::vec3(inverseView[3].x, inverseView[3].y, inverseView[3].z);
+
+	PipelineState saved = PipelineState::GetCurrent();
+	PipelineState::Bind(m_boxState);
+	m_pBoxShader->setMat4Value("viewProjection", projection * view);
+	glBindVertexArray(m_boxVAO);
+
+	for (int i = 0; i < (int)m_objects.size(); i++)
+	{
+		OCCLUSION_OBJECT& object = m_objects[i];
+		bool bQueued = object.bQueued;
+		object.bQueued = false;
+		object.bTested = false;
+		if ((m_settings.bEnabled == false) || (bQueued == false))
+		{
+			continue;
+		}
+
+		glm::vec3 offset = glm::abs(cameraPosition - object.center);
+		glm::vec3 reach = object.halfSize + glm::vec3(g_InsideMargin);
+		if ((offset.x < reach.x) && (offset.y < reach.y) && (offset.z < reach.z))
+		{
+			continue;
+		}
+
+		m_pBoxShader->setVec3Value("boxCenter", object.center);
+		m_pBoxShader->setVec3Value("boxHalfSize", object.halfSize);
+		glBeginQuery(GL_ANY_SAMPLES_PASSED, object.query);
+		glDrawArrays(GL_TRIANGLES, 0, g_CubeVertexCount);
+		glEndQuery(GL_ANY_SAMPLES_PASSED);
+		object.bTested = true;
+	}
+
+	glBindVertexArray(0);
+	PipelineState::Bind(saved);
+}
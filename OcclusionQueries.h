@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionqueries.h
+// ============
+// manage the occlusion tests of the composite objects - bounding boxes tested
+// against the depth each frame, and the next frame's draws made conditional
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "PipelineState.h"
+#include "ViewManager.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  OcclusionQueries
+ *
+ *  This class contains the code for skipping objects that
+ *  are hidden behind others.  After the scene is drawn, the
+ *  bounding box of each object is drawn against the depth
+ *  with an occlusion query and no color or depth writes.
+ *  The next frame draws the object inside a conditional
+ *  render on that query, so the GPU drops all of its draws
+ *  when no sample of the box passed.  The conditional render
+ *  does not wait, so a result that is not ready yet draws the
+ *  object and the CPU never stalls.
+ ***********************************************************/
+class OcclusionQueries
+{
+public:
+	// constructor
+	OcclusionQueries();
+	// destructor
+	~OcclusionQueries();
+
+	// adjustable settings for the occlusion tests
+	struct OCCLUSION_SETTINGS
+	{
+		bool bEnabled;
+	};
+
+	// load the box shader and create one query per object
+	bool Create(int objectCount);
+	// free the shader, the queries and the box
+	void Destroy();
+
+	// start drawing an object under the result of its last test,
+	// and end it again after the object's draws
+	void BeginConditionalDraw(int index);
+	void EndConditionalDraw(int index);
+
+	// queue the bounding box of an object drawn this frame
+	void AddBox(int index, glm::vec3 center, glm::vec3 halfSize);
+	// test the queued boxes against the depth drawn so far
+	void TestBoxes(ViewManager* pViewManager);
+
+	// settings used by the next frame
+	OCCLUSION_SETTINGS m_settings;
+
+private:
+	// test state of one object
+	struct OCCLUSION_OBJECT
+	{
+		GLuint query;
+		// the query holds a test from the last frame
+		bool bTested;
+		// the box is queued for this frame's test
+		bool bQueued;
+		// the conditional render is active for the object's draws
+		bool bConditional;
+		glm::vec3 center;
+		glm::vec3 halfSize;
+	};
+
+	// shader program for the boxes
+	ShaderManager* m_pBoxShader;
+	// depth tested with no writes at all, only the samples count
+	PipelineState m_boxState;
+	// unit cube drawn for every box
+	GLuint m_boxVAO;
+	GLuint m_boxVBO;
+	std::vector<OCCLUSION_OBJECT> m_objects;
+};
@@ -0,0 +1,241 @@
+///////////////////////////////////////////////////////////////////////////////
+// pipelinestate.cpp
+// ============
+// manage the fixed function state of the draws - immutable descriptors of
+// the program, blend, depth, cull and rasterizer state, and a cache that only
+// changes what differs from the bound descriptor
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PipelineState.h"
+
+// declare the global variables and helper functions
+namespace
+{
+	/***********************************************************
+	 *  SetBlendFunction()
+	 *
+	 *  Sets the blend factors of the passed in blend mode.
+	 ***********************************************************/
+	void SetBlendFunction(PipelineState::BLEND_MODE blend)
+	{
+		switch (blend)
+		{
+		case PipelineState::BLEND_ADDITIVE:
+			glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
+			break;
+		case PipelineState::BLEND_MULTIPLY:
+			glBlendFuncSeparate(GL_ZERO, GL_SRC_COLOR, GL_ZERO, GL_SRC_COLOR);
+			break;
+		case PipelineState::BLEND_ALPHA_FADE:
+			glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+			break;
+		default:
+			glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			break;
+		}
+	}
+
+	/***********************************************************
+	 *  SetCapability()
+	 *
+	 *  Enables or disables an OpenGL capability.
+	 ***********************************************************/
+	void SetCapability(GLenum capability, bool bEnable)
+	{
+		if (bEnable == true)
+		{
+			glEnable(capability);
+		}
+		else
+		{
+			glDisable(capability);
+		}
+	}
+}
+
+PipelineState PipelineState::m_current;
+bool PipelineState::m_bCurrentValid = false;
+
+/***********************************************************
+ *  PipelineState()
+ *
+ *  The constructors for the class
+ ***********************************************************/
+PipelineState::PipelineState()
+{
+	m_program = 0;
+	m_blend = BLEND_NONE;
+	m_depthTest = DEPTH_OFF;
+	m_bDepthWrite = true;
+	m_cull = CULL_NONE;
+	m_raster = RASTER_FILL;
+	m_bColorWrite = true;
+}
+
+PipelineState::PipelineState(GLuint program, BLEND_MODE blend, DEPTH_TEST depthTest, bool bDepthWrite,
+	CULL_MODE cull, RASTER_MODE raster, bool bColorWrite)
+{
+	m_program = program;
+	m_blend = blend;
+	m_depthTest = depthTest;
+	m_bDepthWrite = bDepthWrite;
+	m_cull = cull;
+	m_raster = raster;
+	m_bColorWrite = bColorWrite;
+}
+
+/***********************************************************
+ *  WithProgram()
+ *
+ *  This method is used for getting a copy of the descriptor
+ *  that draws with another program.
+ ***********************************************************/
+PipelineState PipelineState::WithProgram(GLuint program) const
+{
+	PipelineState state = *this;
+	state.m_program = program;
+	return(state);
+}
+
+/***********************************************************
+ *  WithCull()
+ *
+ *  This method is used for getting a copy of the descriptor
+ *  that culls other faces.
+ ***********************************************************/
+PipelineState PipelineState::WithCull(CULL_MODE cull) const
+{
+	PipelineState state = *this;
+	state.m_cull = cull;
+	return(state);
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for making the passed in descriptor
+ *  the bound state, with the OpenGL calls for the parts that
+ *  differ from the descriptor bound before.
+ ***********************************************************/
+void PipelineState::Bind(const PipelineState& state)
+{
+	bool bAll = (m_bCurrentValid == false);
+	const PipelineState& current = m_current;
+
+	if ((bAll == true) || (state.m_program != current.m_program))
+	{
+		glUseProgram(state.m_program);
+	}
+
+	if ((bAll == true) || (state.m_blend != current.m_blend))
+	{
+		SetCapability(GL_BLEND, state.m_blend != BLEND_NONE);
+		if (state.m_blend != BLEND_NONE)
+		{
+			SetBlendFunction(state.m_blend);
+		}
+	}
+
+	if ((bAll == true) || (state.m_depthTest != current.m_depthTest))
+	{
+		SetCapability(GL_DEPTH_TEST, state.m_depthTest != DEPTH_OFF);
+		if (state.m_depthTest != DEPTH_OFF)
+		{
+			glDepthFunc((state.m_depthTest == DEPTH_LEQUAL) ? GL_LEQUAL : GL_LESS);
+		}
+	}
+
+	if ((bAll == true) || (state.m_bDepthWrite != current.m_bDepthWrite))
+	{
+		glDepthMask((state.m_bDepthWrite == true) ? GL_TRUE : GL_FALSE);
+	}
+
+	if ((bAll == true) || (state.m_cull != current.m_cull))
+	{
+		SetCapability(GL_CULL_FACE, state.m_cull != CULL_NONE);
+		if (state.m_cull != CULL_NONE)
+		{
+			glCullFace((state.m_cull == CULL_FRONT) ? GL_FRONT : GL_BACK);
+		}
+	}
+
+	if ((bAll == true) || (state.m_raster != current.m_raster))
+	{
+		SetCapability(GL_RASTERIZER_DISCARD, state.m_raster == RASTER_DISCARD);
+		SetCapability(GL_POLYGON_OFFSET_LINE, state.m_raster == RASTER_LINES);
+		glPolygonMode(GL_FRONT_AND_BACK, (state.m_raster == RASTER_LINES) ? GL_LINE : GL_FILL);
+		if (state.m_raster == RASTER_LINES)
+		{
+			glPolygonOffset(-1.0f, -1.0f);
+		}
+	}
+
+	if ((bAll == true) || (state.m_bColorWrite != current.m_bColorWrite))
+	{
+		GLboolean mask = (state.m_bColorWrite == true) ? GL_TRUE : GL_FALSE;
+		glColorMask(mask, mask, mask, mask);
+	}
+
+	m_current = state;
+	m_bCurrentValid = true;
+}
+
+/***********************************************************
+ *  GetCurrent()
+ *
+ *  This method is used for getting the descriptor that was
+ *  bound last.
+ ***********************************************************/
+const PipelineState& PipelineState::GetCurrent()
+{
+	return(m_current);
+}
+
+/***********************************************************
+ *  EnableWrites()
+ *
+ *  This method is used for turning the color and depth
+ *  writes of the bound state on.
+ ***********************************************************/
+void PipelineState::EnableWrites()
+{
+	PipelineState state = m_current;
+	state.m_bDepthWrite = true;
+	state.m_bColorWrite = true;
+	Bind(state);
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for forgetting the bound state, when
+ *  it may have been changed around the cache.
+ ***********************************************************/
+void PipelineState::Invalidate()
+{
+	m_bCurrentValid = false;
+}
+
+/***********************************************************
+ *  GetProgram()
+ *
+ *  This method is used for finding the program of a shader
+ *  manager.  The shader is bound to read the program back,
+ *  then the bound program is set again.
+ ***********************************************************/
+GLuint PipelineState::GetProgram(ShaderManager* pShader)
+{
+	if (NULL == pShader)
+	{
+		return(0);
+	}
+
+	GLint currentProgram = 0;
+	GLint shaderProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+	pShader->use();
+	glGetIntegerv(GL_CURRENT_PROGRAM, &shaderProgram);
+	glUseProgram(currentProgram);
+
+	return((GLuint)shaderProgram);
+}
@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////////
+// pipelinestate.h
+// ============
+// manage the fixed function state of the draws - immutable descriptors of
+// the program, blend, depth, cull and rasterizer state, and a cache that only
+// changes what differs from the bound descriptor
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include "ShaderManager.h"
+
+/***********************************************************
+ *  PipelineState
+ *
+ *  This class contains the state one kind of draw needs.  A
+ *  descriptor is made once, when its program is loaded, and
+ *  is never changed after - the With...() methods return a
+ *  new descriptor.  Bind() compares the descriptor with the
+ *  one bound before and makes only the OpenGL calls for the
+ *  differences, so every draw states all it depends on and
+ *  never inherits state from the draw before it.  Programs
+ *  are bound through Bind() too, the cache would not know
+ *  about a ShaderManager::use() call.
+ ***********************************************************/
+class PipelineState
+{
+public:
+	enum BLEND_MODE
+	{
+		BLEND_NONE = 0,
+		// source alpha over the target
+		BLEND_ALPHA = 1,
+		// source added to the target
+		BLEND_ADDITIVE = 2,
+		// target scaled by the source color
+		BLEND_MULTIPLY = 3,
+		// alpha over the color, the target alpha scaled down by the
+		// source alpha
+		BLEND_ALPHA_FADE = 4
+	};
+
+	enum DEPTH_TEST
+	{
+		DEPTH_OFF = 0,
+		DEPTH_LESS = 1,
+		DEPTH_LEQUAL = 2
+	};
+
+	enum CULL_MODE
+	{
+		CULL_NONE = 0,
+		CULL_BACK = 1,
+		CULL_FRONT = 2
+	};
+
+	enum RASTER_MODE
+	{
+		RASTER_FILL = 0,
+		// triangle edges, pulled towards the camera so they win the
+		// depth test against their own filled triangles
+		RASTER_LINES = 1,
+		// no fragments at all, for transform feedback captures
+		RASTER_DISCARD = 2
+	};
+
+	// the state of a new OpenGL context, with no program
+	PipelineState();
+	PipelineState(GLuint program, BLEND_MODE blend, DEPTH_TEST depthTest, bool bDepthWrite,
+		CULL_MODE cull = CULL_NONE, RASTER_MODE raster = RASTER_FILL, bool bColorWrite = true);
+
+	// copies with one part changed
+	PipelineState WithProgram(GLuint program) const;
+	PipelineState WithCull(CULL_MODE cull) const;
+
+	GLuint GetProgram() const { return(m_program); }
+	CULL_MODE GetCull() const { return(m_cull); }
+
+	// make the passed in descriptor the bound state
+	static void Bind(const PipelineState& state);
+	// the descriptor bound last, to bind again after a draw that
+	// needs its own state in the middle of another
+	static const PipelineState& GetCurrent();
+	// turn the color and depth writes on for a clear, which obeys
+	// the write masks of the bound state
+	static void EnableWrites();
+	// forget the bound state, the next Bind() sets all of it
+	static void Invalidate();
+	// the program of a shader manager, found by binding it once -
+	// call when the shader is loaded, not for every draw
+	static GLuint GetProgram(ShaderManager* pShader);
+
+private:
+	GLuint m_program;
+	BLEND_MODE m_blend;
+	DEPTH_TEST m_depthTest;
+	bool m_bDepthWrite;
+	CULL_MODE m_cull;
+	RASTER_MODE m_raster;
+	bool m_bColorWrite;
+
+	// the descriptor the OpenGL state matches, when it is valid
+	static PipelineState m_current;
+	static bool m_bCurrentValid;
+};
@@ -0,0 +1,244 @@
+///////////////////////////////////////////////////////////////////////////////
+// postprocessor.cpp
+// ============
+// manage the post-processing chain that turns the HDR scene render into the
+// final displayed image - bloom, tonemapping, color grading, FXAA
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PostProcessor.h"
+#include "FullscreenPass.h"
+
+// declare the global variables
+namespace
+{
+	// most bloom mip levels below the half size level
+	const int g_BloomMipCount = 5;
+	// smallest bloom mip edge in pixels
+	const int g_BloomMinSize = 8;
+	// bloom mips only hold light, so a packed float format is enough
+	const GLenum g_BloomFormat = GL_R11F_G11F_B10F;
+
+}
+
+/***********************************************************
+ *  PostProcessor()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+PostProcessor::PostProcessor()
+{
+	m_pFrameGraph = NULL;
+	m_pBloomDownShader = NULL;
+	m_pBloomUpShader = NULL;
+	m_pCompositeShader = NULL;
+	m_pFXAAShader = NULL;
+	m_width = 0;
+	m_height = 0;
+
+	// default settings keep the scene close to its original look
+	m_settings.bBloom = true;
+	m_settings.bloomThreshold = 1.0f;
+	m_settings.bloomIntensity = 0.35f;
+	m_settings.exposure = 1.2f;
+	m_settings.colorFilter = glm::vec3(1.0f, 0.98f, 0.95f);
+	m_settings.saturation = 1.05f;
+	m_settings.contrast = 1.05f;
+	m_settings.bFXAA = true;
+}
+
+/***********************************************************
+ *  ~PostProcessor()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+PostProcessor::~PostProcessor()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for loading the post shaders.
+ ***********************************************************/
+bool PostProcessor::Create(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+
+	m_pBloomDownShader = FullscreenPass::LoadShader("bloomDownFragmentShader.glsl");
+	m_pBloomUpShader = FullscreenPass::LoadShader("bloomUpFragmentShader.glsl");
+	m_pCompositeShader = FullscreenPass::LoadShader("postCompositeFragmentShader.glsl");
+	m_pFXAAShader = FullscreenPass::LoadShader("fxaaFragmentShader.glsl");
+	m_bloomDownState = FullscreenPass::GetState(m_pBloomDownShader);
+	m_bloomUpState = FullscreenPass::GetState(m_pBloomUpShader, PipelineState::BLEND_ADDITIVE);
+	m_compositeState = FullscreenPass::GetState(m_pCompositeShader);
+	m_fxaaState = FullscreenPass::GetState(m_pFXAAShader);
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shader programs.
+ ***********************************************************/
+void PostProcessor::Destroy()
+{
+	if (NULL != m_pBloomDownShader)
+	{
+		delete m_pBloomDownShader;
+		m_pBloomDownShader = NULL;
+	}
+	if (NULL != m_pBloomUpShader)
+	{
+		delete m_pBloomUpShader;
+		m_pBloomUpShader = NULL;
+	}
+	if (NULL != m_pCompositeShader)
+	{
+		delete m_pCompositeShader;
+		m_pCompositeShader = NULL;
+	}
+	if (NULL != m_pFXAAShader)
+	{
+		delete m_pFXAAShader;
+		m_pFXAAShader = NULL;
+	}
+	m_pFrameGraph = NULL;
+}
+
+/***********************************************************
+ *  AddPasses()
+ *
+ *  This method is used for adding the post passes to the
+ *  frame graph, reading the resolved HDR scene color and
+ *  writing the output (usually the imported back buffer).
+ *
+ *  Passes at full resolution:
+ *    1. bloom composite + tonemap + color grading
+ *    2. FXAA (skipped when off - pass 1 then writes the output)
+ *  The bright pass is fused into the first bloom downsample.
+ *  When bloom is off the composite does not read the bloom
+ *  target, so the graph culls the whole bloom chain.
+ ***********************************************************/
+void PostProcessor::AddPasses(FrameGraph* pFrameGraph, int hdrColor, int output)
+{
+	if (NULL == pFrameGraph)
+	{
+		return;
+	}
+	m_pFrameGraph = pFrameGraph;
+
+	int bloomColor = AddBloomPasses(hdrColor);
+
+	// with FXAA off the composite pass writes the output directly
+	int compositeColor = output;
+	if (m_settings.bFXAA == true)
+	{
+		compositeColor = pFrameGraph->CreateTarget("ldrColor", m_width, m_height, GL_RGBA8);
+	}
+
+	std::vector<int> compositeInputs = { hdrColor };
+	if (m_settings.bBloom == true)
+	{
+		compositeInputs.push_back(bloomColor);
+	}
+	pFrameGraph->AddPass("composite", compositeInputs, { compositeColor },
+		[this, hdrColor, bloomColor]()
+		{
+			PipelineState::Bind(m_compositeState);
+			m_pCompositeShader->setBoolValue("bUseBloom", m_settings.bBloom);
+			m_pCompositeShader->setFloatValue("bloomIntensity", m_settings.bloomIntensity);
+			m_pCompositeShader->setFloatValue("exposure", m_settings.exposure);
+			m_pCompositeShader->setVec3Value("colorFilter", m_settings.colorFilter);
+			m_pCompositeShader->setFloatValue("saturation", m_settings.saturation);
+			m_pCompositeShader->setFloatValue("contrast", m_settings.contrast);
+			FullscreenPass::BindTexture(m_pCompositeShader, "sceneTexture", 0, m_pFrameGraph->GetTexture(hdrColor));
+			FullscreenPass::BindTexture(m_pCompositeShader, "bloomTexture", 1, m_pFrameGraph->GetTexture(bloomColor));
+			FullscreenPass::Draw();
+		});
+
+	if (m_settings.bFXAA == true)
+	{
+		pFrameGraph->AddPass("fxaa", { compositeColor }, { output },
+			[this, compositeColor]()
+			{
+				PipelineState::Bind(m_fxaaState);
+				m_pFXAAShader->setVec2Value("sourceTexelSize", glm::vec2(1.0f / m_width, 1.0f / m_height));
+				FullscreenPass::BindTexture(m_pFXAAShader, "sourceTexture", 0, m_pFrameGraph->GetTexture(compositeColor));
+				FullscreenPass::Draw();
+			});
+	}
+}
+
+/***********************************************************
+ *  AddBloomPasses()
+ *
+ *  This method is used for adding the bloom passes.  The HDR
+ *  image is filtered down a chain of half size mips and then
+ *  added back up the chain.  Returns the resource of the half
+ *  size mip that holds the result.
+ ***********************************************************/
+int PostProcessor::AddBloomPasses(int hdrColor)
+{
+	int mipTargets[g_BloomMipCount];
+	int mipCount = 0;
+
+	int sourceTarget = hdrColor;
+	int width = m_width / 2;
+	int height = m_height / 2;
+
+	// downsample - the first level also applies the bright pass
+	while ((mipCount < g_BloomMipCount) && (width >= g_BloomMinSize) && (height >= g_BloomMinSize))
+	{
+		int mipTarget = m_pFrameGraph->CreateTarget("bloomMip", width, height, g_BloomFormat);
+		bool bPrefilter = (mipCount == 0);
+
+		m_pFrameGraph->AddPass("bloomDown", { sourceTarget }, { mipTarget },
+			[this, sourceTarget, bPrefilter]()
+			{
+				PipelineState::Bind(m_bloomDownState);
+				m_pBloomDownShader->setFloatValue("bloomThreshold", m_settings.bloomThreshold);
+				m_pBloomDownShader->setBoolValue("bPrefilter", bPrefilter);
+				m_pBloomDownShader->setVec2Value("sourceTexelSize", glm::vec2(
+					1.0f / m_pFrameGraph->GetWidth(sourceTarget),
+					1.0f / m_pFrameGraph->GetHeight(sourceTarget)));
+				FullscreenPass::BindTexture(m_pBloomDownShader, "sourceTexture", 0, m_pFrameGraph->GetTexture(sourceTarget));
+				FullscreenPass::Draw();
+			});
+
+		mipTargets[mipCount] = mipTarget;
+		sourceTarget = mipTarget;
+		width /= 2;
+		height /= 2;
+		mipCount++;
+	}
+
+	if (mipCount == 0)
+	{
+		return(-1);
+	}
+
+	// upsample - each level is added on top of the next larger one,
+	// so no extra targets are needed on the way back up
+	for (int i = mipCount - 1; i > 0; i--)
+	{
+		int smallerMip = mipTargets[i];
+		int largerMip = mipTargets[i - 1];
+
+		// the larger mip is read back by the additive blend
+		m_pFrameGraph->AddPass("bloomUp", { smallerMip, largerMip }, { largerMip },
+			[this, smallerMip]()
+			{
+				PipelineState::Bind(m_bloomUpState);
+				m_pBloomUpShader->setVec2Value("sourceTexelSize", glm::vec2(
+					1.0f / m_pFrameGraph->GetWidth(smallerMip),
+					1.0f / m_pFrameGraph->GetHeight(smallerMip)));
+				FullscreenPass::BindTexture(m_pBloomUpShader, "sourceTexture", 0, m_pFrameGraph->GetTexture(smallerMip));
+				FullscreenPass::Draw();
+			});
+	}
+
+	return(mipTargets[0]);
+}
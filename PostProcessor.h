@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// postprocessor.h
+// ============
+// manage the post-processing chain that turns the HDR scene render into the
+// final displayed image - bloom, tonemapping, color grading, FXAA
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "PipelineState.h"
+#include "FrameGraph.h"
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  PostProcessor
+ *
+ *  This class contains the code for adding the fullscreen
+ *  post-processing passes to the frame graph.  Adjacent
+ *  effects are fused into as few passes as possible and every
+ *  intermediate image is a transient target of the graph.
+ ***********************************************************/
+class PostProcessor
+{
+public:
+	// constructor
+	PostProcessor();
+	// destructor
+	~PostProcessor();
+
+	// adjustable settings for the post-processing effects
+	struct POST_SETTINGS
+	{
+		bool bBloom;
+		float bloomThreshold;
+		float bloomIntensity;
+		float exposure;
+		glm::vec3 colorFilter;
+		float saturation;
+		float contrast;
+		bool bFXAA;
+	};
+
+	// load the post shaders and size the chain for the output
+	bool Create(int width, int height);
+	// free the shaders and OpenGL objects
+	void Destroy();
+
+	// add the post chain from the HDR color into the output
+	void AddPasses(FrameGraph* pFrameGraph, int hdrColor, int output);
+
+	// settings used by the next call to Render()
+	POST_SETTINGS m_settings;
+
+private:
+	// frame graph the passes were added to
+	FrameGraph* m_pFrameGraph;
+	// one shader program per fullscreen pass
+	ShaderManager* m_pBloomDownShader;
+	ShaderManager* m_pBloomUpShader;
+	ShaderManager* m_pCompositeShader;
+	ShaderManager* m_pFXAAShader;
+	// the state each pass draws with
+	PipelineState m_bloomDownState;
+	PipelineState m_bloomUpState;
+	PipelineState m_compositeState;
+	PipelineState m_fxaaState;
+	// size of the final output in pixels
+	int m_width;
+	int m_height;
+
+	// add the bloom mip chain and return the half size result
+	int AddBloomPasses(int hdrColor);
+};
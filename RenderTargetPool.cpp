@@ -0,0 +1,594 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendertargetpool.cpp
+// ============
+// manage a pool of offscreen render targets that are shared between passes,
+// recycled across frames and aliased when their lifetimes do not overlap
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderTargetPool.h"
+#include "GLDebug.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+// declare the global variables and helper functions
+namespace
+{
+	// targets unused for this many frames are freed, so targets
+	// from disabled passes do not hold memory forever
+	const int g_UnusedFrameLimit = 120;
+
+	/***********************************************************
+	 *  GetBytesPerPixel()
+	 *
+	 *  Returns the approximate storage size of one sample in
+	 *  the passed in internal format.
+	 ***********************************************************/
+	int GetBytesPerPixel(GLenum internalFormat)
+	{
+		switch (internalFormat)
+		{
+		case GL_R8:
+			return(1);
+		case GL_RG8:
+		case GL_R16F:
+			return(2);
+		case GL_RGBA32F:
+			return(16);
+		case GL_RGBA16F:
+			return(8);
+		default:
+			// RGBA8, RG16F, R32F, R11F_G11F_B10F and the depth formats
+			return(4);
+		}
+	}
+
+	/***********************************************************
+	 *  GetTargetMemory()
+	 *
+	 *  Returns the bytes of video memory used by a target with
+	 *  the passed in size, format and sample count.
+	 ***********************************************************/
+	size_t GetTargetMemory(int width, int height, GLenum internalFormat, int samples)
+	{
+		return((size_t)width * height * samples * GetBytesPerPixel(internalFormat));
+	}
+	/***********************************************************
+	 *  GetUploadFormat()
+	 *
+	 *  Returns the pixel format and type that are compatible
+	 *  with the passed in internal format for glTexImage2D.
+	 ***********************************************************/
+	void GetUploadFormat(GLenum internalFormat, GLenum& format, GLenum& type)
+	{
+		switch (internalFormat)
+		{
+		case GL_DEPTH_COMPONENT24:
+		case GL_DEPTH_COMPONENT32F:
+			format = GL_DEPTH_COMPONENT;
+			type = GL_FLOAT;
+			break;
+		case GL_DEPTH24_STENCIL8:
+			format = GL_DEPTH_STENCIL;
+			type = GL_UNSIGNED_INT_24_8;
+			break;
+		case GL_R8:
+		case GL_R16F:
+		case GL_R32F:
+			format = GL_RED;
+			type = GL_FLOAT;
+			break;
+		case GL_RG8:
+		case GL_RG16F:
+			format = GL_RG;
+			type = GL_FLOAT;
+			break;
+		case GL_R11F_G11F_B10F:
+			format = GL_RGB;
+			type = GL_FLOAT;
+			break;
+		case GL_RGBA8:
+			format = GL_RGBA;
+			type = GL_UNSIGNED_BYTE;
+			break;
+		default:
+			format = GL_RGBA;
+			type = GL_FLOAT;
+			break;
+		}
+	}
+}
+
+/***********************************************************
+ *  IsDepthFormat()
+ *
+ *  Returns true when the internal format is a depth format
+ *  that must be attached as a depth attachment.
+ ***********************************************************/
+bool RenderTargetPool::IsDepthFormat(GLenum internalFormat)
+{
+	return((internalFormat == GL_DEPTH_COMPONENT24) ||
+		(internalFormat == GL_DEPTH_COMPONENT32F) ||
+		(internalFormat == GL_DEPTH24_STENCIL8));
+}
+
+/***********************************************************
+ *  RenderTargetPool()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderTargetPool::RenderTargetPool()
+{
+	m_frameIndex = 0;
+	m_transientMemory = 0;
+	m_aliasedMemory = 0;
+}
+
+/***********************************************************
+ *  ~RenderTargetPool()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderTargetPool::~RenderTargetPool()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting a new frame.  Targets
+ *  that no pass has acquired for a while are freed so their
+ *  memory goes back to the driver.
+ ***********************************************************/
+void RenderTargetPool::BeginFrame()
+{
+	bool bFreed = false;
+
+	m_frameIndex++;
+
+	for (int i = 0; i < m_renderTargets.size(); i++)
+	{
+		RENDER_TARGET& target = m_renderTargets[i];
+		if ((target.textureID != 0) &&
+			(target.bInUse == false) &&
+			((m_frameIndex - target.lastUsedFrame) > g_UnusedFrameLimit))
+		{
+			DestroyTarget(target);
+			bFreed = true;
+		}
+	}
+
+	if (bFreed == true)
+	{
+		ReportMemory();
+	}
+}
+
+/***********************************************************
+ *  AcquireTarget()
+ *
+ *  This method is used for getting a render target with the
+ *  passed in size, format and sample count.  A free target
+ *  from an earlier pass or frame is reused when one matches,
+ *  otherwise a new target is created.  Returns -1 on failure.
+ ***********************************************************/
+int RenderTargetPool::AcquireTarget(int width, int height, GLenum internalFormat, int samples)
+{
+	int index = 0;
+	int freeSlot = -1;
+
+	// look for a matching target that nobody is using
+	while (index < m_renderTargets.size())
+	{
+		RENDER_TARGET& target = m_renderTargets[index];
+		if (target.textureID == 0)
+		{
+			// remember an emptied slot so handles stay stable
+			freeSlot = index;
+		}
+		else if ((target.bInUse == false) &&
+			(target.width == width) &&
+			(target.height == height) &&
+			(target.samples == samples) &&
+			(target.internalFormat == internalFormat))
+		{
+			target.bInUse = true;
+			target.lastUsedFrame = m_frameIndex;
+			return(index);
+		}
+		index++;
+	}
+
+	// nothing matched, so create a new target
+	RENDER_TARGET target;
+	target.framebufferID = 0;
+	target.textureID = 0;
+	target.width = width;
+	target.height = height;
+	target.samples = samples;
+	target.internalFormat = internalFormat;
+	target.bInUse = true;
+	target.lastUsedFrame = m_frameIndex;
+	if (CreateTarget(target) == false)
+	{
+		return(-1);
+	}
+
+	if (freeSlot >= 0)
+	{
+		m_renderTargets[freeSlot] = target;
+	}
+	else
+	{
+		m_renderTargets.push_back(target);
+		freeSlot = m_renderTargets.size() - 1;
+	}
+
+	ReportMemory();
+
+	return(freeSlot);
+}
+
+/***********************************************************
+ *  ReleaseTarget()
+ *
+ *  This method is used for giving a render target back to
+ *  the pool so that a later pass can reuse its memory.
+ ***********************************************************/
+void RenderTargetPool::ReleaseTarget(int handle)
+{
+	if ((handle >= 0) && (handle < m_renderTargets.size()))
+	{
+		m_renderTargets[handle].bInUse = false;
+	}
+}
+
+/***********************************************************
+ *  DeclareTransient()
+ *
+ *  This method is used for declaring a target that is first
+ *  written by pass firstPass and last read by pass lastPass.
+ *  No memory is assigned until AllocateTransients() is
+ *  called.  Returns the index of the transient.
+ ***********************************************************/
+int RenderTargetPool::DeclareTransient(int width, int height, GLenum internalFormat,
+	int firstPass, int lastPass, int samples)
+{
+	TRANSIENT_TARGET transient;
+	transient.width = width;
+	transient.height = height;
+	transient.samples = samples;
+	transient.internalFormat = internalFormat;
+	transient.firstPass = firstPass;
+	transient.lastPass = lastPass;
+	transient.handle = -1;
+
+	m_transientTargets.push_back(transient);
+	return(m_transientTargets.size() - 1);
+}
+
+/***********************************************************
+ *  AllocateTransients()
+ *
+ *  This method is used for assigning pooled targets to the
+ *  declared transients.  Transients are visited in the order
+ *  they start, and each one takes over a target of the same
+ *  size and format whose previous transient has already been
+ *  read for the last time.  Only when no such target exists
+ *  is another one acquired from the pool.
+ ***********************************************************/
+void RenderTargetPool::AllocateTransients()
+{
+	std::vector<int> order;
+	// per physical target - the handle and the last pass reading it
+	std::vector<int> physicalHandles;
+	std::vector<int> physicalLastPass;
+
+	m_transientMemory = 0;
+	m_aliasedMemory = 0;
+
+	for (int i = 0; i < m_transientTargets.size(); i++)
+	{
+		order.push_back(i);
+	}
+	std::sort(order.begin(), order.end(), [this](int a, int b)
+		{
+			return(m_transientTargets[a].firstPass < m_transientTargets[b].firstPass);
+		});
+
+	for (int i = 0; i < order.size(); i++)
+	{
+		TRANSIENT_TARGET& transient = m_transientTargets[order[i]];
+		m_transientMemory += GetTargetMemory(transient.width, transient.height,
+			transient.internalFormat, transient.samples);
+
+		// find a compatible target whose lifetime is already over
+		int physical = 0;
+		bool bFound = false;
+		while ((physical < physicalHandles.size()) && (bFound == false))
+		{
+			const RENDER_TARGET& target = m_renderTargets[physicalHandles[physical]];
+			if ((physicalLastPass[physical] < transient.firstPass) &&
+				(target.width == transient.width) &&
+				(target.height == transient.height) &&
+				(target.samples == transient.samples) &&
+				(target.internalFormat == transient.internalFormat))
+			{
+				bFound = true;
+			}
+			else
+			{
+				physical++;
+			}
+		}
+
+		if (bFound == false)
+		{
+			int handle = AcquireTarget(transient.width, transient.height,
+				transient.internalFormat, transient.samples);
+			if (handle < 0)
+			{
+				continue;
+			}
+			physicalHandles.push_back(handle);
+			physicalLastPass.push_back(-1);
+			m_aliasedMemory += GetTargetMemory(transient.width, transient.height,
+				transient.internalFormat, transient.samples);
+		}
+
+		transient.handle = physicalHandles[physical];
+		physicalLastPass[physical] = transient.lastPass;
+	}
+}
+
+/***********************************************************
+ *  GetTransientTarget()
+ *
+ *  This method is used for getting the render target handle
+ *  that AllocateTransients() assigned to a transient.
+ ***********************************************************/
+int RenderTargetPool::GetTransientTarget(int transient) const
+{
+	if ((transient < 0) || (transient >= m_transientTargets.size()))
+	{
+		return(-1);
+	}
+	return(m_transientTargets[transient].handle);
+}
+
+/***********************************************************
+ *  ReleaseTransients()
+ *
+ *  This method is used for giving the targets assigned to
+ *  the transients back to the pool and clearing the list of
+ *  declared transients for the next frame.
+ ***********************************************************/
+void RenderTargetPool::ReleaseTransients()
+{
+	for (int i = 0; i < m_transientTargets.size(); i++)
+	{
+		ReleaseTarget(m_transientTargets[i].handle);
+	}
+	m_transientTargets.clear();
+}
+
+/***********************************************************
+ *  GetTotalMemory()
+ *
+ *  This method is used for getting the bytes of video memory
+ *  held by every target in the pool.
+ ***********************************************************/
+size_t RenderTargetPool::GetTotalMemory() const
+{
+	size_t totalMemory = 0;
+
+	for (int i = 0; i < m_renderTargets.size(); i++)
+	{
+		const RENDER_TARGET& target = m_renderTargets[i];
+		if (target.textureID != 0)
+		{
+			totalMemory += GetTargetMemory(target.width, target.height,
+				target.internalFormat, target.samples);
+		}
+	}
+
+	return(totalMemory);
+}
+
+/***********************************************************
+ *  ReportMemory()
+ *
+ *  This method is used for printing how much video memory
+ *  the pool holds and how much the last set of transients
+ *  saved by aliasing.
+ ***********************************************************/
+void RenderTargetPool::ReportMemory() const
+{
+	int targetCount = 0;
+	for (int i = 0; i < m_renderTargets.size(); i++)
+	{
+		if (m_renderTargets[i].textureID != 0)
+		{
+			targetCount++;
+		}
+	}
+
+	const float megabyte = 1024.0f * 1024.0f;
+	std::cout << "INFO: Render target pool: " << targetCount << " targets, "
+		<< (GetTotalMemory() / megabyte) << " MB";
+	if (m_transientMemory > m_aliasedMemory)
+	{
+		std::cout << " (aliasing saved "
+			<< ((m_transientMemory - m_aliasedMemory) / megabyte) << " MB)";
+	}
+	std::cout << std::endl;
+}
+
+/***********************************************************
+ *  GetFramebuffer()
+ *
+ *  This method is used for getting the framebuffer object of
+ *  an acquired render target.
+ ***********************************************************/
+GLuint RenderTargetPool::GetFramebuffer(int handle) const
+{
+	if ((handle < 0) || (handle >= m_renderTargets.size()))
+	{
+		return(0);
+	}
+	return(m_renderTargets[handle].framebufferID);
+}
+
+/***********************************************************
+ *  GetTexture()
+ *
+ *  This method is used for getting the texture object of an
+ *  acquired render target.
+ ***********************************************************/
+GLuint RenderTargetPool::GetTexture(int handle) const
+{
+	if ((handle < 0) || (handle >= m_renderTargets.size()))
+	{
+		return(0);
+	}
+	return(m_renderTargets[handle].textureID);
+}
+
+/***********************************************************
+ *  GetWidth()
+ *
+ *  This method is used for getting the width in pixels of
+ *  an acquired render target.
+ ***********************************************************/
+int RenderTargetPool::GetWidth(int handle) const
+{
+	if ((handle < 0) || (handle >= m_renderTargets.size()))
+	{
+		return(0);
+	}
+	return(m_renderTargets[handle].width);
+}
+
+/***********************************************************
+ *  GetHeight()
+ *
+ *  This method is used for getting the height in pixels of
+ *  an acquired render target.
+ ***********************************************************/
+int RenderTargetPool::GetHeight(int handle) const
+{
+	if ((handle < 0) || (handle >= m_renderTargets.size()))
+	{
+		return(0);
+	}
+	return(m_renderTargets[handle].height);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the memory of every
+ *  render target in the pool.
+ ***********************************************************/
+void RenderTargetPool::Destroy()
+{
+	for (int i = 0; i < m_renderTargets.size(); i++)
+	{
+		DestroyTarget(m_renderTargets[i]);
+	}
+	m_renderTargets.clear();
+	m_transientTargets.clear();
+}
+
+/***********************************************************
+ *  CreateTarget()
+ *
+ *  This method is used for allocating the texture and the
+ *  framebuffer for a new render target.
+ ***********************************************************/
+bool RenderTargetPool::CreateTarget(RENDER_TARGET& target)
+{
+	GLenum format = GL_RGBA;
+	GLenum type = GL_FLOAT;
+	bool bDepth = IsDepthFormat(target.internalFormat);
+
+	GetUploadFormat(target.internalFormat, format, type);
+
+	// multisampled targets are resolved or fetched per sample, so
+	// they have no filtering state
+	GLenum textureTarget = (target.samples > 1) ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+
+	glGenTextures(1, &target.textureID);
+	glBindTexture(textureTarget, target.textureID);
+	GL_DEBUG_LABEL(GL_TEXTURE, target.textureID, "render target " + std::to_string(target.width) + "x" +
+		std::to_string(target.height) + "x" + std::to_string(target.samples));
+	if (target.samples > 1)
+	{
+		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, target.samples,
+			target.internalFormat, target.width, target.height, GL_TRUE);
+	}
+	else
+	{
+		glTexImage2D(GL_TEXTURE_2D, 0, target.internalFormat,
+			target.width, target.height, 0, format, type, NULL);
+
+		// post passes sample between texels, depth is read point sampled
+		GLint filter = (bDepth == true) ? GL_NEAREST : GL_LINEAR;
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+	glBindTexture(textureTarget, 0);
+
+	glGenFramebuffers(1, &target.framebufferID);
+	glBindFramebuffer(GL_FRAMEBUFFER, target.framebufferID);
+	if (bDepth == true)
+	{
+		GLenum attachment = (target.internalFormat == GL_DEPTH24_STENCIL8) ?
+			GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+		glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, textureTarget, target.textureID, 0);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+	}
+	else
+	{
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureTarget, target.textureID, 0);
+	}
+
+	bool bComplete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (bComplete == false)
+	{
+		std::cout << "Failed to create render target " << target.width << "x" << target.height << std::endl;
+		DestroyTarget(target);
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  DestroyTarget()
+ *
+ *  This method is used for freeing the texture and the
+ *  framebuffer of a render target.  The emptied entry keeps
+ *  its slot so the handles of other targets stay valid.
+ ***********************************************************/
+void RenderTargetPool::DestroyTarget(RENDER_TARGET& target)
+{
+	if (target.framebufferID != 0)
+	{
+		glDeleteFramebuffers(1, &target.framebufferID);
+		target.framebufferID = 0;
+	}
+	if (target.textureID != 0)
+	{
+		glDeleteTextures(1, &target.textureID);
+		target.textureID = 0;
+	}
+	target.bInUse = false;
+}
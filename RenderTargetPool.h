@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendertargetpool.h
+// ============
+// manage a pool of offscreen render targets that are shared between passes,
+// recycled across frames and aliased when their lifetimes do not overlap
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <vector>
+
+/***********************************************************
+ *  RenderTargetPool
+ *
+ *  This class contains the code for handing out offscreen
+ *  render targets (a texture with its framebuffer) keyed by
+ *  size, format and sample count, and for recycling them once
+ *  a pass is done.  Transient targets declared with a pass
+ *  lifetime share memory when their lifetimes do not overlap.
+ ***********************************************************/
+class RenderTargetPool
+{
+public:
+	// constructor
+	RenderTargetPool();
+	// destructor
+	~RenderTargetPool();
+
+	// properties for a pooled render target
+	struct RENDER_TARGET
+	{
+		GLuint framebufferID;
+		GLuint textureID;
+		int width;
+		int height;
+		int samples;
+		GLenum internalFormat;
+		bool bInUse;
+		int lastUsedFrame;
+	};
+
+	// properties for a transient target that only lives between
+	// two passes of the frame
+	struct TRANSIENT_TARGET
+	{
+		int width;
+		int height;
+		int samples;
+		GLenum internalFormat;
+		int firstPass;
+		int lastPass;
+		int handle;
+	};
+
+	// start a new frame and free targets that have gone unused
+	void BeginFrame();
+
+	// get a free render target matching the size and format
+	int AcquireTarget(int width, int height, GLenum internalFormat, int samples = 1);
+	// give a render target back to the pool
+	void ReleaseTarget(int handle);
+
+	// declare a target that is written by firstPass and last read
+	// by lastPass, returning an index for GetTransientTarget()
+	int DeclareTransient(int width, int height, GLenum internalFormat,
+		int firstPass, int lastPass, int samples = 1);
+	// assign pooled targets to the declared transients, aliasing
+	// transients whose lifetimes do not overlap
+	void AllocateTransients();
+	// get the render target handle assigned to a transient
+	int GetTransientTarget(int transient) const;
+	// give every transient target back and clear the declarations
+	void ReleaseTransients();
+
+	// total bytes of video memory held by the pool
+	size_t GetTotalMemory() const;
+	// print the memory held by the pool and saved by aliasing
+	void ReportMemory() const;
+
+	// access the OpenGL objects of an acquired render target
+	GLuint GetFramebuffer(int handle) const;
+	GLuint GetTexture(int handle) const;
+	int GetWidth(int handle) const;
+	int GetHeight(int handle) const;
+
+	// free every render target owned by the pool
+	void Destroy();
+
+	// true when the format has to be attached as a depth attachment
+	static bool IsDepthFormat(GLenum internalFormat);
+
+private:
+	// all of the render targets created so far
+	std::vector<RENDER_TARGET> m_renderTargets;
+	// transients declared for the current frame
+	std::vector<TRANSIENT_TARGET> m_transientTargets;
+	// number of frames started so far
+	int m_frameIndex;
+	// bytes the last transients would have needed without aliasing
+	size_t m_transientMemory;
+	// bytes the last transients actually occupied
+	size_t m_aliasedMemory;
+
+	// allocate the OpenGL objects for a new render target
+	bool CreateTarget(RENDER_TARGET& target);
+	// free the OpenGL objects of a render target
+	void DestroyTarget(RENDER_TARGET& target);
+};
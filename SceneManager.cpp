@@ -8,6 +8,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
+#include "GLDebug.h"
+#include "EnvironmentProbe.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -16,14 +18,63 @@
 
 #include <glm/gtx/transform.hpp>
 
+#include <cmath>
+
 // declare the global variables
 namespace
 {
 	const char* g_ModelName = "model";
+	const char* g_PreviousModelName = "previousModel";
 	const char* g_ColorValueName = "objectColor";
 	const char* g_TextureValueName = "objectTexture";
 	const char* g_UseTextureName = "bUseTexture";
 	const char* g_UseLightingName = "bUseLighting";
+	const char* g_AlphaToCoverageName = "bAlphaToCoverage";
+	const char* g_SharpenAlphaName = "bSharpenAlpha";
+	const char* g_UseNormalMapName = "bUseNormalMap";
+	const char* g_NormalMapValueName = "normalTexture";
+	const char* g_NormalVarianceName = "normalMapVariance";
+	const char* g_NormalLevelCountName = "normalMapLevels";
+	const char* g_OverlayCountName = "overlayCount";
+	const char* g_OverlayReliefLayerName = "overlayReliefLayer";
+	const char* g_OverlayReliefTextureName = "overlayReliefTexture";
+	const char* g_OverlayParallaxDepthName = "overlayParallaxDepth";
+
+	// overlay layers blended in one draw, MAX_OVERLAYS in the shader
+	const int g_MaxOverlays = 4;
+
+	// mip levels with a normal variance, MAX_NORMAL_LEVELS in the
+	// shader - enough for a 4096 texel map
+	const int g_MaxNormalMapLevels = 13;
+
+	// fraction of texels with partial alpha above which a texture
+	// is treated as translucent rather than as a cutout
+	const float g_TranslucentTexelRatio = 0.1f;
+
+	// normal maps are bound above the scene textures and the units
+	// used by the fullscreen passes
+	const int g_NormalMapUnit = 32;
+	// the BRDF lookup sits between the fullscreen units and the
+	// normal maps, bound once like the scene textures
+	const int g_BRDFTextureUnit = 24;
+	const char* g_BRDFValueName = "brdfTexture";
+	const char* g_BRDFCacheFile = "brdfLookup.cache";
+
+	/***********************************************************
+	 *  GetNormalMapFormat()
+	 *
+	 *  Returns the internal format for the two-channel normal
+	 *  maps - BC5 (RGTC2) where the driver supports it, which
+	 *  keeps both channels at a quarter of the RG8 size.
+	 ***********************************************************/
+	GLenum GetNormalMapFormat()
+	{
+		if ((GLEW_VERSION_3_0 == true) || (GLEW_ARB_texture_compression_rgtc == true))
+		{
+			return(GL_COMPRESSED_RG_RGTC2);
+		}
+		return(GL_RG8);
+	}
 }
 
 /***********************************************************
@@ -41,8 +92,25 @@ SceneManager::SceneManager(ShaderManager* pShaderManager)
 	{
 		m_textureIDs[i].tag = "/0";
 		m_textureIDs[i].ID = -1;
+		m_textureIDs[i].bAlphaToCoverage = false;
+		m_textureIDs[i].bSharpenAlpha = false;
+		m_textureIDs[i].normalMapID = 0;
 	}
 	m_loadedTextures = 0;
+	m_bAlphaToCoverage = false;
+	m_bOverlaysSet = false;
+	m_pBRDFLookup = NULL;
+	m_pMeshDeformer = NULL;
+	m_transformIndex = 0;
+	m_pImpostors = NULL;
+	m_pLevelOfDetailView = NULL;
+	m_viewportHeight = 0;
+	m_pTessellatedShapes = NULL;
+	m_currentModel = glm::mat4(1.0f);
+	m_pOcclusionQueries = NULL;
+	m_bCullBackFaces = true;
+	m_pDistanceFields = NULL;
+	m_pDistanceParts = NULL;
 }
 
 /***********************************************************
@@ -56,6 +124,36 @@ SceneManager::~SceneManager()
 	m_pShaderManager = NULL;
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+	if (NULL != m_pBRDFLookup)
+	{
+		delete m_pBRDFLookup;
+		m_pBRDFLookup = NULL;
+	}
+	if (NULL != m_pMeshDeformer)
+	{
+		delete m_pMeshDeformer;
+		m_pMeshDeformer = NULL;
+	}
+	if (NULL != m_pImpostors)
+	{
+		delete m_pImpostors;
+		m_pImpostors = NULL;
+	}
+	if (NULL != m_pTessellatedShapes)
+	{
+		delete m_pTessellatedShapes;
+		m_pTessellatedShapes = NULL;
+	}
+	if (NULL != m_pOcclusionQueries)
+	{
+		delete m_pOcclusionQueries;
+		m_pOcclusionQueries = NULL;
+	}
+	if (NULL != m_pDistanceFields)
+	{
+		delete m_pDistanceFields;
+		m_pDistanceFields = NULL;
+	}
 	// destroy the created OpenGL textures
 	DestroyGLTextures();
 }
@@ -73,6 +171,14 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 	int width = 0, height = 0, colorChannels = 0;
 	GLuint textureID = 0;
 
+	// the slots are a fixed array - a 17th texture would be written
+	// over the members that follow it
+	if (m_loadedTextures >= 16)
+	{
+		std::cout << "No free texture slot for:" << filename << std::endl;
+		return false;
+	}
+
 	// Flip image when loading
 	stbi_set_flip_vertically_on_load(true);
 
@@ -85,6 +191,7 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 
 	glGenTextures(1, &textureID);
 	glBindTexture(GL_TEXTURE_2D, textureID);
+	GL_DEBUG_LABEL(GL_TEXTURE, textureID, "texture " + tag);
 
 	// Apply specific wrapping mode based on texture tag
 	if (tag == "panda" || tag == "thinkpad")  // Ensure
@@ -106,18 +213,185 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 	GLenum format = (colorChannels == 4) ? GL_RGBA : GL_RGB; // needed to load RGBA for transparent textures
 	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, image);
 	glGenerateMipmap(GL_TEXTURE_2D);
+
+	// textures with alpha are drawn with alpha-to-coverage instead of
+	// blending, so count the partially transparent texels to decide
+	// whether the alpha is a cutout edge or real translucency
+	bool bAlphaToCoverage = (colorChannels == 4);
+	bool bSharpenAlpha = false;
+	if (bAlphaToCoverage == true)
+	{
+		int partialTexels = 0;
+		int totalTexels = width * height;
+		for (int i = 0; i < totalTexels; i++)
+		{
+			unsigned char alpha = image[(i * 4) + 3];
+			if ((alpha > 25) && (alpha < 230))
+			{
+				partialTexels++;
+			}
+		}
+		bSharpenAlpha = (partialTexels < (totalTexels * g_TranslucentTexelRatio));
+	}
+
 	// Free image and unbind
 	stbi_image_free(image);
 	glBindTexture(GL_TEXTURE_2D, 0);
+	GL_DEBUG_CHECK("CreateGLTexture");
 
 	// Register texture
 	m_textureIDs[m_loadedTextures].ID = textureID;
 	m_textureIDs[m_loadedTextures].tag = tag;
+	m_textureIDs[m_loadedTextures].bAlphaToCoverage = bAlphaToCoverage;
+	m_textureIDs[m_loadedTextures].bSharpenAlpha = bSharpenAlpha;
 	m_loadedTextures++;
 
 	return true;
 }
 
+/***********************************************************
+ *  CreateGLNormalMap()
+ *
+ *  This method is used for creating a normal map for the
+ *  already loaded texture with the passed in tag.  The image
+ *  is read as a height map (its brightness), the slopes give
+ *  the tangent space normals, and only X and Y are stored -
+ *  the shader rebuilds Z.  Every mip is averaged from the
+ *  level above without renormalizing.  The rebuilt Z makes
+ *  every stored normal unit length again, so the shortening
+ *  of each level is kept as its mean Toksvig variance, which
+ *  the shader adds to the roughness at that level.
+ ***********************************************************/
+bool SceneManager::CreateGLNormalMap(const char* filename, std::string tag, float bumpStrength)
+{
+	int width = 0, height = 0, colorChannels = 0;
+	GLuint textureID = 0;
+
+	int slot = FindTextureSlot(tag);
+	if (slot < 0)
+	{
+		std::cout << "No texture to add the normal map to:" << tag << std::endl;
+		return false;
+	}
+
+	// Flip image when loading, the same as the color textures
+	stbi_set_flip_vertically_on_load(true);
+
+	// Load the brightness as the height
+	unsigned char* image = stbi_load(filename, &width, &height, &colorChannels, 1);
+	if (!image) {
+		std::cout << "Failed to load normal map:" << filename << std::endl;
+		return false;
+	}
+
+	// slopes from a 3x3 Sobel filter, wrapping like the texture does
+	std::vector<float> normals(width * height * 3);
+	for (int y = 0; y < height; y++)
+	{
+		int up = ((y + 1) % height) * width;
+		int row = y * width;
+		int down = ((y + height - 1) % height) * width;
+		for (int x = 0; x < width; x++)
+		{
+			int right = (x + 1) % width;
+			int left = (x + width - 1) % width;
+			float slopeX =
+				(image[up + right] + 2.0f * image[row + right] + image[down + right]) -
+				(image[up + left] + 2.0f * image[row + left] + image[down + left]);
+			float slopeY =
+				(image[up + left] + 2.0f * image[up + x] + image[up + right]) -
+				(image[down + left] + 2.0f * image[down + x] + image[down + right]);
+
+			glm::vec3 normal = glm::normalize(glm::vec3(
+				-slopeX * bumpStrength / (4.0f * 255.0f),
+				-slopeY * bumpStrength / (4.0f * 255.0f),
+				1.0f));
+			normals[(row + x) * 3] = normal.x;
+			normals[(row + x) * 3 + 1] = normal.y;
+			normals[(row + x) * 3 + 2] = normal.z;
+		}
+	}
+	stbi_image_free(image);
+
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D, textureID);
+	GL_DEBUG_LABEL(GL_TEXTURE, textureID, "normal map " + tag);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// compressed formats cannot always be mipmapped by the driver,
+	// so every level is built here and compressed on upload
+	GLenum internalFormat = GetNormalMapFormat();
+	std::vector<unsigned char> packed;
+	std::vector<float> variances;
+	int level = 0;
+	// the rows are packed tightly, and levels with an odd width
+	// have rows that are not a multiple of 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	while (true)
+	{
+		// an averaged normal of length L spreads over (1 - L) / L,
+		// the Toksvig variance
+		packed.resize(width * height * 2);
+		double variance = 0.0;
+		for (int i = 0; i < width * height; i++)
+		{
+			const float* normal = &normals[i * 3];
+			packed[i * 2] = (unsigned char)((normal[0] * 0.5f + 0.5f) * 255.0f + 0.5f);
+			packed[i * 2 + 1] = (unsigned char)((normal[1] * 0.5f + 0.5f) * 255.0f + 0.5f);
+			float length = glm::max(glm::length(glm::vec3(normal[0], normal[1], normal[2])), 0.01f);
+			variance += glm::max((1.0f - length) / length, 0.0f);
+		}
+		if (level < g_MaxNormalMapLevels)
+		{
+			variances.push_back((float)(variance / (width * height)));
+		}
+		glTexImage2D(GL_TEXTURE_2D, level, internalFormat, width, height, 0,
+			GL_RG, GL_UNSIGNED_BYTE, packed.data());
+
+		if ((width == 1) && (height == 1))
+		{
+			break;
+		}
+
+		// average each 2x2 block into the next level
+		int nextWidth = (width > 1) ? width / 2 : 1;
+		int nextHeight = (height > 1) ? height / 2 : 1;
+		std::vector<float> next(nextWidth * nextHeight * 3);
+		for (int y = 0; y < nextHeight; y++)
+		{
+			int y0 = (y * 2) % height;
+			int y1 = (y * 2 + 1) % height;
+			for (int x = 0; x < nextWidth; x++)
+			{
+				int x0 = (x * 2) % width;
+				int x1 = (x * 2 + 1) % width;
+				for (int c = 0; c < 3; c++)
+				{
+					next[(y * nextWidth + x) * 3 + c] = 0.25f * (
+						normals[(y0 * width + x0) * 3 + c] + normals[(y0 * width + x1) * 3 + c] +
+						normals[(y1 * width + x0) * 3 + c] + normals[(y1 * width + x1) * 3 + c]);
+				}
+			}
+		}
+		normals.swap(next);
+		width = nextWidth;
+		height = nextHeight;
+		level++;
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	GL_DEBUG_CHECK("CreateGLNormalMap");
+
+	// Register the normal map with its color texture
+	m_textureIDs[slot].normalMapID = textureID;
+	m_textureIDs[slot].normalVariance = variances;
+
+	return true;
+}
+
 
 /***********************************************************
  *  BindGLTextures()
@@ -132,6 +406,13 @@ void SceneManager::BindGLTextures()
 		// bind textures on corresponding texture units
 		glActiveTexture(GL_TEXTURE0 + i);
 		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
+
+		// normal maps sit on their own units, in the same order
+		if (m_textureIDs[i].normalMapID != 0)
+		{
+			glActiveTexture(GL_TEXTURE0 + g_NormalMapUnit + i);
+			glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].normalMapID);
+		}
 	}
 }
 
@@ -149,6 +430,11 @@ void SceneManager::DestroyGLTextures()
 			glDeleteTextures(1, &m_textureIDs[i].ID);
 			m_textureIDs[i].ID = 0; // Ensure it's reset
 		}
+		if (m_textureIDs[i].normalMapID != 0) {
+			glDeleteTextures(1, &m_textureIDs[i].normalMapID);
+			m_textureIDs[i].normalMapID = 0;
+		}
+		m_textureIDs[i].normalVariance.clear();
 	}
 	m_loadedTextures = 0; // Reset texture count
 }
@@ -228,8 +514,11 @@ bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
 		{
 			bFound = true;
 			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
+			material.metallic = m_objectMaterials[index].metallic;
+			material.roughness = m_objectMaterials[index].roughness;
+			material.reflectivity = m_objectMaterials[index].reflectivity;
+			material.bParallax = m_objectMaterials[index].bParallax;
+			material.parallaxDepth = m_objectMaterials[index].parallaxDepth;
 		}
 		else
 		{
@@ -240,6 +529,34 @@ bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
 	return(true);
 }
 
+/***********************************************************
+ *  FindOverlays()
+ *
+ *  This method is used for getting the overlay layers from the
+ *  previously defined overlays list that are associated with
+ *  the passed in tag.
+ ***********************************************************/
+bool SceneManager::FindOverlays(std::string tag, OBJECT_OVERLAYS& overlays)
+{
+	int index = 0;
+	bool bFound = false;
+	while ((index < m_objectOverlays.size()) && (bFound == false))
+	{
+		if (m_objectOverlays[index].tag.compare(tag) == 0)
+		{
+			bFound = true;
+			overlays.layers = m_objectOverlays[index].layers;
+			overlays.tag = m_objectOverlays[index].tag;
+		}
+		else
+		{
+			index++;
+		}
+	}
+
+	return(bFound);
+}
+
 /***********************************************************
  *  SetTransformations()
  *
@@ -272,10 +589,38 @@ void SceneManager::SetTransformations(
 
 	modelView = translation * rotationZ * rotationY * rotationX * scale;
 
+	// kept for the density of the tessellated shapes
+	m_currentModel = modelView;
+
 	if (NULL != m_pShaderManager)
 	{
 		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+
+		// the scene is drawn in the same order every frame, so the
+		// draw with the same index last frame is the same object -
+		// its model then gives the object's motion vectors
+		glm::mat4 previousModel = modelView;
+		if (m_transformIndex < (int)m_previousModels.size())
+		{
+			previousModel = m_previousModels[m_transformIndex];
+			m_previousModels[m_transformIndex] = modelView;
+		}
+		else
+		{
+			m_previousModels.push_back(modelView);
+		}
+		m_transformIndex++;
+		m_pShaderManager->setMat4Value(g_PreviousModelName, previousModel);
+
+		// overlays belong to the object being placed, so a new
+		// transform clears whatever the previous object used
+		if (m_bOverlaysSet == true)
+		{
+			m_pShaderManager->setIntValue(g_OverlayCountName, 0);
+			m_bOverlaysSet = false;
+		}
 	}
+	GL_DEBUG_CHECK("SetTransformations");
 }
 
 /***********************************************************
@@ -301,8 +646,12 @@ void SceneManager::SetShaderColor(
 	if (NULL != m_pShaderManager)
 	{
 		m_pShaderManager->setIntValue(g_UseTextureName, false);
+		m_pShaderManager->setBoolValue(g_UseNormalMapName, false);
 		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
 	}
+
+	// untextured draws fall back to the regular alpha test
+	SetAlphaToCoverage(false, false);
 }
 
 /***********************************************************
@@ -325,12 +674,166 @@ void SceneManager::SetShaderMaterial(
 		{
 			// pass the material properties into the shader
 			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+			m_pShaderManager->setFloatValue("material.metallic", material.metallic);
+			m_pShaderManager->setFloatValue("material.roughness", material.roughness);
+			m_pShaderManager->setFloatValue("material.reflectivity", material.reflectivity);
+			m_pShaderManager->setBoolValue("material.bParallax", material.bParallax);
+			m_pShaderManager->setFloatValue("material.parallaxDepth", material.parallaxDepth);
+		}
+	}
+}
+
+
+/***********************************************************
+ *  SetShaderOverlays()
+ *
+ *  This method is used for passing the overlay layers into the
+ *  shader, so stickers, logos and legends are blended over the
+ *  object in its own draw instead of drawn as extra coplanar
+ *  geometry on top of it.
+ ***********************************************************/
+void SceneManager::SetShaderOverlays(
+	std::string overlaysTag)
+{
+	OBJECT_OVERLAYS overlays;
+	bool bReturn = false;
+
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
+
+	// find the defined overlays that match the tag
+	bReturn = FindOverlays(overlaysTag, overlays);
+	if (bReturn == false)
+	{
+		std::cout << "ERROR: overlays " << overlaysTag << " are not defined" << std::endl;
+		return;
+	}
+
+	int layerCount = 0;
+	int reliefLayer = -1;
+	for (int i = 0; (i < overlays.layers.size()) && (layerCount < g_MaxOverlays); i++)
+	{
+		const OVERLAY_LAYER& layer = overlays.layers[i];
+		int textureSlot = FindTextureSlot(layer.textureTag);
+		if (textureSlot < 0)
+		{
+			continue;
 		}
+
+		// the layers read the scene texture slots directly
+		std::string index = "[" + std::to_string(layerCount) + "]";
+		m_pShaderManager->setSampler2DValue("overlayTextures" + index, textureSlot);
+		m_pShaderManager->setVec4Value("overlayRects" + index,
+			glm::vec4(layer.center.x, layer.center.y, layer.size.x, layer.size.y));
+		m_pShaderManager->setFloatValue("overlaySides" + index,
+			(layer.bBottom == true) ? -1.0f : 1.0f);
+
+		// the relief of the layer takes the normal map sampler, which
+		// the object itself leaves free when it has no normal map
+		if ((layer.bRelief == true) && (reliefLayer < 0) &&
+			(m_textureIDs[textureSlot].normalMapID != 0))
+		{
+			reliefLayer = layerCount;
+			m_pShaderManager->setSampler2DValue(g_OverlayReliefTextureName, textureSlot);
+			m_pShaderManager->setSampler2DValue(g_NormalMapValueName, g_NormalMapUnit + textureSlot);
+			m_pShaderManager->setFloatValue(g_OverlayParallaxDepthName, layer.parallaxDepth);
+		}
+		layerCount++;
 	}
+
+	m_pShaderManager->setIntValue(g_OverlayCountName, layerCount);
+	m_pShaderManager->setIntValue(g_OverlayReliefLayerName, reliefLayer);
+	m_bOverlaysSet = (layerCount > 0);
 }
 
+/***********************************************************
+ *  DefineObjectOverlays()
+ *
+ *  This method is used for configuring the overlay layers of
+ *  the objects within the 3D scene.  Positions are given on
+ *  the unit box mesh, which spans -0.5 to 0.5.
+ ***********************************************************/
+void SceneManager::DefineObjectOverlays()
+{
+	/*** Laptop Base - keyboard legends and the logo next to the touchpad ***/
+	OBJECT_OVERLAYS laptopBaseOverlays;
+	OVERLAY_LAYER keyboardLayer;
+	keyboardLayer.textureTag = "keyboard";
+	keyboardLayer.center = glm::vec2(0.0f, -0.15f);
+	keyboardLayer.size = glm::vec2(0.909f, 0.538f);
+	keyboardLayer.bBottom = false;
+	keyboardLayer.bRelief = true;
+	keyboardLayer.parallaxDepth = 0.015f;  // Shallow key caps
+	laptopBaseOverlays.layers.push_back(keyboardLayer);
+	OVERLAY_LAYER thinkpadLayer;
+	thinkpadLayer.textureTag = "thinkpad";
+	thinkpadLayer.center = glm::vec2(0.386f, 0.369f);
+	thinkpadLayer.size = glm::vec2(0.182f, 0.231f);
+	thinkpadLayer.bBottom = false;
+	thinkpadLayer.bRelief = false;
+	thinkpadLayer.parallaxDepth = 0.0f;
+	laptopBaseOverlays.layers.push_back(thinkpadLayer);
+	laptopBaseOverlays.tag = "laptopBase";
+	m_objectOverlays.push_back(laptopBaseOverlays);
+
+	/*** Laptop Lid - logo on the back of the screen half ***/
+	OBJECT_OVERLAYS laptopLidOverlays;
+	OVERLAY_LAYER lidLogoLayer;
+	lidLogoLayer.textureTag = "thinkpad";
+	lidLogoLayer.center = glm::vec2(0.364f, -0.356f);
+	lidLogoLayer.size = glm::vec2(0.182f, 0.231f);
+	lidLogoLayer.bBottom = true;
+	lidLogoLayer.bRelief = false;
+	lidLogoLayer.parallaxDepth = 0.0f;
+	laptopLidOverlays.layers.push_back(lidLogoLayer);
+	laptopLidOverlays.tag = "laptopLid";
+	m_objectOverlays.push_back(laptopLidOverlays);
+}
+
+/***********************************************************
+ *  DefineSceneDecals()
+ *
+ *  This method is used for adding the decals of the 3D scene -
+ *  the small printed details that used to be thin planes drawn
+ *  just above the surface they belong to.  Decals are lit with
+ *  the diffuse light of the surface under them, so their colors
+ *  include the hard plastic diffuse color the planes used.
+ ***********************************************************/
+void SceneManager::DefineSceneDecals(DeferredDecals* pDecals)
+{
+	if (NULL == pDecals)
+	{
+		return;
+	}
+
+	DeferredDecals::DECAL decal;
+	decal.XrotationDegrees = 0.0f;
+	decal.YrotationDegrees = 0.0f;
+	decal.ZrotationDegrees = 0.0f;
+
+	/*** i7 sticker next to the touchpad, with a slightly raised print ***/
+	decal.position = glm::vec3(-13.0f, 1.1f, 5.0f);
+	decal.scale = glm::vec3(2.0f, 0.2f, 2.0f);
+	decal.color = glm::vec4(0.1f, 0.1f, 0.1f, 1.0f);
+	decal.textureLayer = pDecals->LoadDecalTexture("../5-2_Assignment/textures/i7logo.jpg");
+	decal.bumpStrength = 0.01f;
+	if (decal.textureLayer >= 0)
+	{
+		pDecals->AddDecal(decal);
+	}
+
+	/*** red lines on the touchpad buttons ***/
+	decal.scale = glm::vec3(3.1f, 0.2f, 0.1f);
+	decal.color = glm::vec4(0.1f, 0.0f, 0.0f, 1.0f);
+	decal.textureLayer = -1;
+	decal.bumpStrength = 0.0f;
+	decal.position = glm::vec3(-6.37f, 1.2f, 2.65f);
+	pDecals->AddDecal(decal);
+	decal.position = glm::vec3(-1.63f, 1.2f, 2.65f);
+	pDecals->AddDecal(decal);
+}
 
 /***********************************************************
  *  DefineObjectMaterials()
@@ -343,64 +846,88 @@ void SceneManager::DefineObjectMaterials()
 	/*** Plastic Material ***/
 	OBJECT_MATERIAL plasticMaterial;
 	plasticMaterial.diffuseColor = glm::vec3(0.6f, 0.6f, 0.6f);  // Light blue
-	plasticMaterial.specularColor = glm::vec3(0.8f, 0.8f, 0.8f);  // Increased reflection
-	plasticMaterial.shininess = 300.0f;  // Shinier surface
+	plasticMaterial.metallic = 0.0f;  // Dielectric
+	plasticMaterial.roughness = 0.1f;  // Shiny surface
+	plasticMaterial.reflectivity = 0.0f;
+	plasticMaterial.bParallax = false;
+	plasticMaterial.parallaxDepth = 0.0f;
 	plasticMaterial.tag = "plastic";
 	m_objectMaterials.push_back(plasticMaterial);
 
 	/*** Hard Plastic Material ***/
 	OBJECT_MATERIAL hardplasticMaterial;
 	hardplasticMaterial.diffuseColor = glm::vec3(0.1f, 0.1f, 0.1f);  // Very dark grey
-	hardplasticMaterial.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);  // Moderate reflectivity
-	hardplasticMaterial.shininess = 150.0f;  // Slightly less than plastic but still semi-glossy
+	hardplasticMaterial.metallic = 0.0f;  // Dielectric
+	hardplasticMaterial.roughness = 0.15f;  // Slightly rougher than plastic but still semi-glossy
+	hardplasticMaterial.reflectivity = 0.0f;
+	hardplasticMaterial.bParallax = false;
+	hardplasticMaterial.parallaxDepth = 0.0f;
 	hardplasticMaterial.tag = "hardplastic";
 	m_objectMaterials.push_back(hardplasticMaterial);
 
 	/*** Wood Material (Matte Finish) ***/
 	OBJECT_MATERIAL woodMaterial;
 	woodMaterial.diffuseColor = glm::vec3(0.55f, 0.27f, 0.07f);  // Warm brown
-	woodMaterial.specularColor = glm::vec3(0.1f, 0.05f, 0.02f);  // Minimal shine
-	woodMaterial.shininess = 20.0f;  // A slight finish
+	woodMaterial.metallic = 0.0f;  // Dielectric
+	woodMaterial.roughness = 0.35f;  // A slight finish
+	woodMaterial.reflectivity = 0.0f;
+	woodMaterial.bParallax = true;
+	woodMaterial.parallaxDepth = 0.02f;  // Raised grain
 	woodMaterial.tag = "wood";
 	m_objectMaterials.push_back(woodMaterial);
 
 	/*** Silicone Material (Matte & Rubber-like) ***/
 	OBJECT_MATERIAL siliconeMaterial;
 	siliconeMaterial.diffuseColor = glm::vec3(0.9f, 0.9f, 0.9f);  // Soft white
-	siliconeMaterial.specularColor = glm::vec3(0.2f, 0.2f, 0.2f);  // Rubber-like sheen
-	siliconeMaterial.shininess = 2.0f;  // Slightly shinier, but still mostly matte
+	siliconeMaterial.metallic = 0.0f;  // Dielectric
+	siliconeMaterial.roughness = 0.7f;  // Rubber-like sheen, mostly matte
+	siliconeMaterial.reflectivity = 0.0f;
+	siliconeMaterial.bParallax = false;
+	siliconeMaterial.parallaxDepth = 0.0f;
 	siliconeMaterial.tag = "silicone";
 	m_objectMaterials.push_back(siliconeMaterial);
 
 	/*** Rug Material (Soft & Matte) ***/
 	OBJECT_MATERIAL rugMaterial;
 	rugMaterial.diffuseColor = glm::vec3(0.65f, 0.45f, 0.3f);  // Warmer brown
-	rugMaterial.specularColor = glm::vec3(0.05f, 0.05f, 0.05f);  // Very low reflectivity
-	rugMaterial.shininess = 1.0f;  // Matte surface
+	rugMaterial.metallic = 0.0f;  // Dielectric
+	rugMaterial.roughness = 0.9f;  // Matte surface
+	rugMaterial.reflectivity = 0.0f;
+	rugMaterial.bParallax = true;
+	rugMaterial.parallaxDepth = 0.04f;  // Deep pile
 	rugMaterial.tag = "rug";
 	m_objectMaterials.push_back(rugMaterial);
 
 	/*** Wall Material (Soft Reflection) ***/
 	OBJECT_MATERIAL wallMaterial;
 	wallMaterial.diffuseColor = glm::vec3(0.55f, 0.55f, 0.55f);  // Light grey
-	wallMaterial.specularColor = glm::vec3(0.2f, 0.2f, 0.2f);  // More subtle but present
-	wallMaterial.shininess = 5.0f;  // Minimal but adds a bit of light interaction
+	wallMaterial.metallic = 0.0f;  // Dielectric
+	wallMaterial.roughness = 0.55f;  // Minimal but adds a bit of light interaction
+	wallMaterial.reflectivity = 0.0f;
+	wallMaterial.bParallax = false;
+	wallMaterial.parallaxDepth = 0.0f;
 	wallMaterial.tag = "wall";
 	m_objectMaterials.push_back(wallMaterial);
 
 	/*** Metal Material (Highly Reflective) ***/
 	OBJECT_MATERIAL metalMaterial;
 	metalMaterial.diffuseColor = glm::vec3(0.7f, 0.7f, 0.7f);  // Neutral grey metal
-	metalMaterial.specularColor = glm::vec3(1.0f, 1.0f, 1.0f);  // Strong reflection
-	metalMaterial.shininess = 300.0f;  // High shine, metallic look
+	metalMaterial.metallic = 1.0f;  // Tinted reflection, no diffuse
+	metalMaterial.roughness = 0.1f;  // High shine, metallic look
+	metalMaterial.reflectivity = 0.6f;  // Mirror-like reflections of the room
+	metalMaterial.bParallax = false;
+	metalMaterial.parallaxDepth = 0.0f;
 	metalMaterial.tag = "metal";
 	m_objectMaterials.push_back(metalMaterial);
 
 	/*** Window Material (Glass-like Reflection) ***/
 	OBJECT_MATERIAL windowMaterial;
 	windowMaterial.diffuseColor = glm::vec3(0.1f, 0.1f, 0.1f);  // Very low diffuse to ensure transparency
-	windowMaterial.specularColor = glm::vec3(0.9f, 0.9f, 0.9f);  // Strong specular highlights
-	windowMaterial.shininess = 500.0f;  // Glass-like effect
+	windowMaterial.metallic = 0.0f;  // Dielectric
+	windowMaterial.roughness = 0.05f;  // Glass-like effect
+	windowMaterial.reflectivity = 0.5f;  // Reflects the room over the view outside
+	windowMaterial.bParallax = false;
+	windowMaterial.parallaxDepth = 0.0f;
 	windowMaterial.tag = "window";
 	m_objectMaterials.push_back(windowMaterial);
 }
@@ -467,6 +994,63 @@ void SceneManager::SetShaderTexture(
 		int textureID = -1;
 		textureID = FindTextureSlot(textureTag);
 		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+
+		// textures with an alpha channel are resolved by the MSAA
+		// coverage mask, so they need neither blending nor sorting
+		if (textureID >= 0)
+		{
+			SetAlphaToCoverage(
+				m_textureIDs[textureID].bAlphaToCoverage,
+				m_textureIDs[textureID].bSharpenAlpha);
+
+			// surface detail comes from the normal map of the texture
+			bool bNormalMap = (m_textureIDs[textureID].normalMapID != 0);
+			m_pShaderManager->setBoolValue(g_UseNormalMapName, bNormalMap);
+			if (bNormalMap == true)
+			{
+				m_pShaderManager->setSampler2DValue(g_NormalMapValueName, g_NormalMapUnit + textureID);
+
+				// the variance of each mip widens the highlights
+				// where the map is sampled from that level
+				const std::vector<float>& variances = m_textureIDs[textureID].normalVariance;
+				m_pShaderManager->setIntValue(g_NormalLevelCountName, (int)variances.size());
+				for (int i = 0; i < (int)variances.size(); i++)
+				{
+					m_pShaderManager->setFloatValue(
+						std::string(g_NormalVarianceName) + "[" + std::to_string(i) + "]", variances[i]);
+				}
+			}
+		}
+	}
+	GL_DEBUG_CHECK("SetShaderTexture");
+}
+
+/***********************************************************
+ *  SetAlphaToCoverage()
+ *
+ *  This method is used for turning alpha-to-coverage on or
+ *  off for the next draw command.  The OpenGL state is only
+ *  touched when it actually changes.
+ ***********************************************************/
+void SceneManager::SetAlphaToCoverage(bool bEnable, bool bSharpen)
+{
+	if (bEnable != m_bAlphaToCoverage)
+	{
+		if (bEnable == true)
+		{
+			glEnable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+		}
+		else
+		{
+			glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+		}
+		m_bAlphaToCoverage = bEnable;
+	}
+
+	if (NULL != m_pShaderManager)
+	{
+		m_pShaderManager->setBoolValue(g_AlphaToCoverageName, bEnable);
+		m_pShaderManager->setBoolValue(g_SharpenAlphaName, bSharpen);
 	}
 }
 
@@ -537,9 +1121,6 @@ void SceneManager::LoadSceneTextures()
 	bReturn = CreateGLTexture(
 		"../5-2_Assignment/textures/laptoptexture.jpg",
 		"pctexture");
-	bReturn = CreateGLTexture(
-		"../5-2_Assignment/textures/i7logo.jpg",
-		"i7");
 	bReturn = CreateGLTexture(
 		"../5-2_Assignment/textures/suitcase.jpg",
 		"suitcase");
@@ -553,6 +1134,21 @@ void SceneManager::LoadSceneTextures()
 		"../5-2_Assignment/textures/whitewood.jpg",
 		"whitewood");
 
+	// normal maps for the surfaces with fine detail, built from the
+	// brightness of their own images - wood grain, fabric weave and
+	// the keyboard keys
+	bReturn = CreateGLNormalMap("../5-2_Assignment/textures/wood1.jpg",
+		"wood1", 2.0f);
+	bReturn = CreateGLNormalMap("../5-2_Assignment/textures/wood2.jpg",
+		"wood2", 2.0f);
+	bReturn = CreateGLNormalMap("../5-2_Assignment/textures/rusticwood.jpg",
+		"rusticwood", 2.0f);
+	bReturn = CreateGLNormalMap("../5-2_Assignment/textures/couch.jpg",
+		"couch", 3.0f);
+	bReturn = CreateGLNormalMap("../5-2_Assignment/textures/rug.jpg",
+		"rug", 3.0f);
+	bReturn = CreateGLNormalMap("../5-2_Assignment/textures/keyboard.png",
+		"keyboard", 4.0f);
 
 	// after the texture image data is loaded into memory, the
 	// loaded textures need to be bound to texture slots - there
@@ -569,15 +1165,27 @@ void SceneManager::LoadSceneTextures()
  ***********************************************************/
 void SceneManager::PrepareScene()
 {
-	// Enable blending for transparency
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
 	// Load the textures for the 3D scene
 	LoadSceneTextures();
 	DefineObjectMaterials();
+	DefineObjectOverlays();
+	DefineSceneComposites();
 	SetupSceneLights();
 
+	// every sampler of the scene shader gets its unit before the
+	// first draw with it, two sampler types can never share a unit
+	PipelineState::Bind(PipelineState::GetCurrent().WithProgram(PipelineState::GetProgram(m_pShaderManager)));
+	EnvironmentProbe::SetSamplerUnit(m_pShaderManager);
+	DistanceFields::SetSamplerUnit(m_pShaderManager);
+
+	// the lighting reads the reflected share of the ambient light
+	// from the split-sum lookup, bound once on its own unit
+	m_pBRDFLookup = new BRDFLookup();
+	m_pBRDFLookup->Create(g_BRDFCacheFile);
+	glActiveTexture(GL_TEXTURE0 + g_BRDFTextureUnit);
+	glBindTexture(GL_TEXTURE_2D, m_pBRDFLookup->GetTexture());
+	m_pShaderManager->setSampler2DValue(g_BRDFValueName, g_BRDFTextureUnit);
+
 	// Load models/meshes
 	m_basicMeshes->LoadBoxMesh();
 	m_basicMeshes->LoadPlaneMesh();
@@ -591,6 +1199,27 @@ void SceneManager::PrepareScene()
 	m_basicMeshes->DrawHalfSphereMesh();
 	m_basicMeshes->DrawHalfTorusMesh();
 	m_basicMeshes->DrawHalfSphereMeshLines();
+
+	// deformed meshes are captured on their first draw
+	m_pMeshDeformer = new MeshDeformer();
+	m_pMeshDeformer->Create();
+
+	// curved shapes are tessellated on their first draw at each
+	// density, where the context has tessellation stages
+	m_pTessellatedShapes = new TessellatedShapes();
+	m_pTessellatedShapes->Create();
+
+	// the solids are drawn with their back faces culled, which needs
+	// every mesh wound counterclockwise seen from outside
+	m_bCullBackFaces = CheckMeshWinding();
+
+	// one occlusion test per composite object
+	m_pOcclusionQueries = new OcclusionQueries();
+	m_pOcclusionQueries->Create((int)m_composites.size());
+
+	// soft shadows and occlusion are traced through the distance
+	// fields of the composite objects
+	BakeDistanceFields();
 }
 /***********************************************************
  *  RenderScene()
@@ -600,6 +1229,23 @@ void SceneManager::PrepareScene()
  ***********************************************************/
 void SceneManager::RenderScene()
 {
+	// the draws are counted from the start for the previous models
+	m_transformIndex = 0;
+
+	// curved shapes first reached inside a conditional draw are
+	// captured here, where no conditional render is active
+	if (NULL != m_pTessellatedShapes)
+	{
+		m_pTessellatedShapes->CapturePending();
+	}
+
+	// the pass states cull back faces, the planes turn it off for
+	// themselves and a failed winding check turns it off for all
+	PipelineState passState = PipelineState::GetCurrent();
+	if (m_bCullBackFaces == false)
+	{
+		PipelineState::Bind(passState.WithCull(PipelineState::CULL_NONE));
+	}
 
 	// declare the variables for the transformations
 	glm::vec3 scaleXYZ;
@@ -636,193 +1282,71 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("wood");
 	SetTextureUVScale(1.0f, 1.0f);
 	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
+	DrawDoubleSided([this]() { m_basicMeshes->DrawPlaneMesh(); });
 
 
-	// Head (Sphere) - Apply Panda Face																							----------------------------------------------------------------------------------
-	scaleXYZ = glm::vec3(1.51f, 1.13f, 1.51f);
-	positionXYZ = glm::vec3(9.0f, 7.8f, -4.0f);
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f);
-	SetShaderMaterial("silicone");
-	m_basicMeshes->DrawHalfSphereMesh();
+	// panda tumbler on the desk
+	DrawComposite("tumbler");
 
-	// Head (Cylinder) //																										
-	scaleXYZ = glm::vec3(1.5f, 1.1f, 1.5f); // Scale for the cylinder body
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 207.5f;
+	//wall in background ---****																						---------------------------------------------------------------
+	scaleXYZ = glm::vec3(70.0f, 1.0f, 45.0f); // Scale for the cylinder body
+	XrotationDegrees = 90.0f;
+	YrotationDegrees = 0.0f;
 	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(9.0f, 6.8f, -4.0f); // Position on the table
+	positionXYZ = glm::vec3(0.0f, 15.0f, -40.0f); // Position on the table
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // White color for the body
-	SetShaderTexture("panda");
-	SetTextureUVScale(3.0f, 1.0f);
-	SetShaderMaterial("silicone");
-	m_basicMeshes->DrawCylinderMesh(false, false);
+	SetShaderColor(0.6f, 0.6f, 0.6f, 1.0f); // Dark grey
+	SetShaderMaterial("wall");
+	DrawDoubleSided([this]() { m_basicMeshes->DrawPlaneMesh(); });
 
-	// Left Ear (Cylinder) // 
-	scaleXYZ = glm::vec3(0.55f, 0.3f, 0.55f); // Scale for the cylinder body																							HEAD SECTION
+	//wall in background behind camera---****																									ENVIRONMENT  OBJECTS 
+	scaleXYZ = glm::vec3(70.0f, 1.0f, 45.0f); // Scale for the cylinder body
 	XrotationDegrees = 90.0f;
 	YrotationDegrees = 0.0f;
 	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(7.8f, 8.7f, -4.0f); // Position on the table
+	positionXYZ = glm::vec3(0.0f, 15.0f, 30.0f); // Position on the table
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); // Black Ears
-	SetShaderMaterial("silicone");
-	m_basicMeshes->DrawSphereMesh();
+	SetShaderColor(0.6f, 0.6f, 0.6f, 1.0f); //
+	SetShaderMaterial("wall");
+	DrawDoubleSided([this]() { m_basicMeshes->DrawPlaneMesh(); });
 
-	// Right Ear (Cylinder) // 
-	scaleXYZ = glm::vec3(0.55f, 0.3f, 0.55f); // Scale for the cylinder body
+
+	// window texture alpha is turned into MSAA coverage, so the window
+	// can be drawn in any order without blending
+	scaleXYZ = glm::vec3(32.5f, 1.0f, 20.0f);
 	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
+	YrotationDegrees = 90.0f;
 	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(10.3f, 8.7f, -4.0f); // Position on the table
+	positionXYZ = glm::vec3(-70.0f, 30.0f, -2.5f); 
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); // Black Ears		
-	SetShaderMaterial("silicone");
-	m_basicMeshes->DrawSphereMesh();
+	SetShaderColor(0.75f, 0.75f, 0.75f, 0.4f);  // Reduce alpha to make it transparent (0.0f = fully transparent, 1.0f = opaque)
+	SetShaderMaterial("window");
+	SetShaderTexture("window");  
+	SetTextureUVScale(1.0f, 1.0f);
+	DrawDoubleSided([this]() { m_basicMeshes->DrawPlaneMesh(); });
 
-	// Neck Zipper (Cylinder) // 
-	scaleXYZ = glm::vec3(1.4f, 1.0f, 1.4f); // Scale for the cylinder body
+
+	//wall above window
+	scaleXYZ = glm::vec3(5.0f, 1.0f, 35.0f); // Scale for the cylinder body
 	XrotationDegrees = 0.0f;
 	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(9.0f, 6.4f, -4.0f); // Position on the table								
+	ZrotationDegrees = 90.0f;
+	positionXYZ = glm::vec3(-70.0f, 55.0f, -5.0f); // Position on the table
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); // Black for the zipper/neck
-	SetShaderTexture("zipper");
-	SetTextureUVScale(3.0, 3.0);
-	SetShaderMaterial("plastic");
-	m_basicMeshes->DrawCylinderMesh();
+	SetShaderColor(0.55f, 0.57f, 0.57f, 1.0f); // Dark grey
+	SetShaderMaterial("wall");
+	DrawDoubleSided([this]() { m_basicMeshes->DrawPlaneMesh(); });
 
-	// Body (Cylinder) // 
-	scaleXYZ = glm::vec3(1.5f, 5.0f, 1.5f); // Scale for the cylinder body
+	//wall under window---****																						---------------------------------------------------------------
+	scaleXYZ = glm::vec3(20.0f, 1.0f, 35.0f); // Scale for the cylinder body
 	XrotationDegrees = 0.0f;
 	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(9.0f, 1.5f, -4.0f); // Position on the table
+	ZrotationDegrees = 90.0f;
+	positionXYZ = glm::vec3(-70.0f, -10.0f, -5.0f); // Position on the table
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // White color for the body
-	SetShaderMaterial("silicone");
-	m_basicMeshes->DrawCylinderMesh();
-
-	// Base Tapered (Cylinder) // 
-	scaleXYZ = glm::vec3(1.5f, 0.7f, 1.5f); // Scale for the cylinder body
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(9.0f, 1.5f, -4.0f); // Position on the table
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // White color for the body
-	SetShaderMaterial("silicone");
-	m_basicMeshes->DrawTaperedCylinderMesh();
-
-	// Body after tapered (Cylinder) // 
-	scaleXYZ = glm::vec3(1.3f, 0.8f, 1.3f); // Scale for the cylinder body
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(9.0f, 1.2f, -4.0f); // Position on the table
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // White color for the body
-	SetShaderMaterial("silicone");
-	m_basicMeshes->DrawCylinderMesh();
-
-	// Base Tapered 2nd (Cylinder) // 
-	scaleXYZ = glm::vec3(1.3f, 1.0f, 1.3f); // Scale for the cylinder body
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(9.0f, 1.2f, -4.0f); // Position on the table
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // White color for the body
-	SetShaderMaterial("silicone");
-	m_basicMeshes->DrawTaperedCylinderMesh();
-
-	// Base (Cylinder) // 
-	scaleXYZ = glm::vec3(1.0f, 0.6f, 1.0f); // Scale for the cylinder body
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(9.0f, 0.3f, -4.0f); // Position on the table
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // White color for the body
-	SetShaderMaterial("silicone");
-	m_basicMeshes->DrawCylinderMesh();
-
-
-	// Base rounded edge (Torus) // 
-	scaleXYZ = glm::vec3(0.83f, 0.83f, 0.83f); // Scale for the cylinder body
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(9.0f, 0.3f, -4.0f); // Position on the table
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // White color for the body
-	SetShaderMaterial("silicone");
-	m_basicMeshes->DrawTorusMesh();
-
-	//wall in background ---****																						---------------------------------------------------------------
-	scaleXYZ = glm::vec3(70.0f, 1.0f, 45.0f); // Scale for the cylinder body
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(0.0f, 15.0f, -40.0f); // Position on the table
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(0.6f, 0.6f, 0.6f, 1.0f); // Dark grey
-	SetShaderMaterial("wall");
-	m_basicMeshes->DrawPlaneMesh();
-
-	//wall in background behind camera---****																									ENVIRONMENT  OBJECTS 
-	scaleXYZ = glm::vec3(70.0f, 1.0f, 45.0f); // Scale for the cylinder body
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(0.0f, 15.0f, 30.0f); // Position on the table
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(0.6f, 0.6f, 0.6f, 1.0f); //
-	SetShaderMaterial("wall");
-	m_basicMeshes->DrawPlaneMesh();
-
-
-	// To enable blending for transparency before drawing the window
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	scaleXYZ = glm::vec3(32.5f, 1.0f, 20.0f);
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 90.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-70.0f, 30.0f, -2.5f); 
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(0.75f, 0.75f, 0.75f, 0.4f);  // Reduce alpha to make it transparent (0.0f = fully transparent, 1.0f = opaque)
-	SetShaderMaterial("window");
-	SetShaderTexture("window");  
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawPlaneMesh();
-	glDisable(GL_BLEND); // Disables the blending after drawing the window
-
-
-	//wall above window
-	scaleXYZ = glm::vec3(5.0f, 1.0f, 35.0f); // Scale for the cylinder body
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 90.0f;
-	positionXYZ = glm::vec3(-70.0f, 55.0f, -5.0f); // Position on the table
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(0.55f, 0.57f, 0.57f, 1.0f); // Dark grey
-	SetShaderMaterial("wall");
-	m_basicMeshes->DrawPlaneMesh();
-
-	//wall under window---****																						---------------------------------------------------------------
-	scaleXYZ = glm::vec3(20.0f, 1.0f, 35.0f); // Scale for the cylinder body
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 90.0f;
-	positionXYZ = glm::vec3(-70.0f, -10.0f, -5.0f); // Position on the table
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(0.63f, 0.63f, 0.63f, 1.0f); // Dark grey
-	SetShaderMaterial("wall");
-	m_basicMeshes->DrawPlaneMesh();
+	SetShaderColor(0.63f, 0.63f, 0.63f, 1.0f); // Dark grey
+	SetShaderMaterial("wall");
+	DrawDoubleSided([this]() { m_basicMeshes->DrawPlaneMesh(); });
 
 	//right wall--****																						---------------------------------------------------------------
 	scaleXYZ = glm::vec3(45.0f, 1.0f, 35.0f); // Scale for the cylinder body
@@ -833,7 +1357,7 @@ void SceneManager::RenderScene()
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	SetShaderColor(0.64f, 0.64f, 0.64f, 1.0f); // Dark grey
 	SetShaderMaterial("wall");
-	m_basicMeshes->DrawPlaneMesh();
+	DrawDoubleSided([this]() { m_basicMeshes->DrawPlaneMesh(); });
 
 	//Ceiling																												BACKGROUND SCENARIO
 	scaleXYZ = glm::vec3(35.0f, 1.0f, 70.0f); // Scale for the cylinder body
@@ -843,7 +1367,7 @@ void SceneManager::RenderScene()
 	positionXYZ = glm::vec3(0.0f, 60.0f, -05.0f); // Position on the table
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	SetShaderColor(0.65f, 0.65f, 0.65f, 1.0f); // Dark grey
-	m_basicMeshes->DrawPlaneMesh();
+	DrawDoubleSided([this]() { m_basicMeshes->DrawPlaneMesh(); });
 
 	//floor rug																													BACKGROUND SCENARIO
 	scaleXYZ = glm::vec3(35.0f, 1.0f, 70.0f); // Scale for the cylinder body
@@ -856,7 +1380,7 @@ void SceneManager::RenderScene()
 	SetShaderTexture("rug");
 	SetShaderMaterial("rug");
 	SetTextureUVScale(1.0, 1.0);
-	m_basicMeshes->DrawPlaneMesh();
+	DrawDoubleSided([this]() { m_basicMeshes->DrawPlaneMesh(); });
 
 	//room wall mouldings																												--------------------------------------------------
 
@@ -974,7 +1498,7 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("wood");
 	SetShaderTexture("wood2");
 	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawPlaneMesh();
+	DrawDoubleSided([this]() { m_basicMeshes->DrawPlaneMesh(); });
 
 
 
@@ -1196,7 +1720,7 @@ void SceneManager::RenderScene()
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); // black color 
 	SetShaderMaterial("plastic");
-	m_basicMeshes->DrawPlaneMesh();
+	DrawDoubleSided([this]() { m_basicMeshes->DrawPlaneMesh(); });
 
 
 	scaleXYZ = glm::vec3(50.0f, 89.8f, 5.1f); //																						ENTERTAINMENT WALL
@@ -1213,76 +1737,221 @@ void SceneManager::RenderScene()
 
 
 
-	// LAPTOP OBJECT
+	// objects on the desk and in the background
+	DrawComposite("laptop");
+	DrawComposite("mouse");
+	DrawComposite("couch");
+	DrawComposite("suitcase");
 
-	scaleXYZ = glm::vec3(22.0f, 0.8f, 12.5f); //																						Scale for base of laptop
+	// the small objects skipped above are drawn as billboards,
+	// all in one draw
+	if ((NULL != m_pImpostors) && (NULL != m_pLevelOfDetailView))
+	{
+		m_pImpostors->DrawInstances(m_pLevelOfDetailView);
+	}
+	// test the boxes of the objects drawn in full against the depth
+	// of the whole frame, for the next frame
+	if ((NULL != m_pOcclusionQueries) && (NULL != m_pLevelOfDetailView))
+	{
+		m_pOcclusionQueries->TestBoxes(m_pLevelOfDetailView);
+	}
+	// the view only applies to this call
+	m_pLevelOfDetailView = NULL;
+	PipelineState::Bind(passState);
+}
+
+/***********************************************************
+ *  RenderTumbler()
+ *
+ *  This method is used for drawing the panda tumbler on
+ *  the desk.
+ ***********************************************************/
+void SceneManager::RenderTumbler()
+{
+	// declare the variables for the transformations
+	glm::vec3 scaleXYZ;
+	float XrotationDegrees = 0.0f;
+	float YrotationDegrees = 0.0f;
+	float ZrotationDegrees = 0.0f;
+	glm::vec3 positionXYZ;
+
+	// Head (Sphere) - Apply Panda Face																							----------------------------------------------------------------------------------
+	scaleXYZ = glm::vec3(1.51f, 1.13f, 1.51f);
+	positionXYZ = glm::vec3(9.0f, 7.8f, -4.0f);
+	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f);
+	SetShaderMaterial("silicone");
+	DrawCurvedMesh(TessellatedShapes::SHAPE_HALF_SPHERE, [this]() { m_basicMeshes->DrawHalfSphereMesh(); });
+	AddDistancePart(DistanceFields::PART_MESH, [this]() { m_basicMeshes->DrawHalfSphereMesh(); });
+
+	// Head (Cylinder) //																										
+	scaleXYZ = glm::vec3(1.5f, 1.1f, 1.5f); // Scale for the cylinder body
 	XrotationDegrees = 0.0f;
+	YrotationDegrees = 207.5f;
+	ZrotationDegrees = 0.0f;
+	positionXYZ = glm::vec3(9.0f, 6.8f, -4.0f); // Position on the table
+	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // White color for the body
+	SetShaderTexture("panda");
+	SetTextureUVScale(3.0f, 1.0f);
+	SetShaderMaterial("silicone");
+	DrawCurvedMesh(TessellatedShapes::SHAPE_CYLINDER_SIDES, [this]() { m_basicMeshes->DrawCylinderMesh(false, false); });
+	AddDistancePart(DistanceFields::PART_CYLINDER);
+
+	// Left Ear (Cylinder) // 
+	scaleXYZ = glm::vec3(0.55f, 0.3f, 0.55f); // Scale for the cylinder body																							HEAD SECTION
+	XrotationDegrees = 90.0f;
 	YrotationDegrees = 0.0f;
 	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-4.0f, 0.5f, 0.8f); // Position on the table
+	positionXYZ = glm::vec3(7.8f, 8.7f, -4.0f); // Position on the table
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); // black color 
-	SetShaderTexture("pctexture");
-	SetShaderMaterial("hardplastic");
-	m_basicMeshes->DrawBoxMesh();
+	SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); // Black Ears
+	SetShaderMaterial("silicone");
+	DrawCurvedMesh(TessellatedShapes::SHAPE_SPHERE, [this]() { m_basicMeshes->DrawSphereMesh(); });
+	AddDistancePart(DistanceFields::PART_SPHERE);
 
-	scaleXYZ = glm::vec3(22.0f, 0.2f, 13.0f); //																			Secondary base for laptop
+	// Right Ear (Cylinder) // 
+	scaleXYZ = glm::vec3(0.55f, 0.3f, 0.55f); // Scale for the cylinder body
+	XrotationDegrees = 90.0f;
+	YrotationDegrees = 0.0f;
+	ZrotationDegrees = 0.0f;
+	positionXYZ = glm::vec3(10.3f, 8.7f, -4.0f); // Position on the table
+	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+	SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); // Black Ears		
+	SetShaderMaterial("silicone");
+	DrawCurvedMesh(TessellatedShapes::SHAPE_SPHERE, [this]() { m_basicMeshes->DrawSphereMesh(); });
+	AddDistancePart(DistanceFields::PART_SPHERE);
+
+	// Neck Zipper (Cylinder) // 
+	scaleXYZ = glm::vec3(1.4f, 1.0f, 1.4f); // Scale for the cylinder body
 	XrotationDegrees = 0.0f;
 	YrotationDegrees = 0.0f;
 	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-4.0f, 1.0f, 0.7f); // Position on the table
+	positionXYZ = glm::vec3(9.0f, 6.4f, -4.0f); // Position on the table								
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(0.0f, 1.0f, 1.0f, 1.0f); // White color for the body
-	SetShaderMaterial("hardplastic");
-	SetShaderTexture("pctexture");
-	m_basicMeshes->DrawBoxMesh();
+	SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); // Black for the zipper/neck
+	SetShaderTexture("zipper");
+	SetTextureUVScale(3.0, 3.0);
+	SetShaderMaterial("plastic");
+	DrawCurvedMesh(TessellatedShapes::SHAPE_CYLINDER, [this]() { m_basicMeshes->DrawCylinderMesh(); });
+	AddDistancePart(DistanceFields::PART_CYLINDER);
 
-	scaleXYZ = glm::vec3(10.0f, 0.15f, 3.5f); //																						Keyboard overlay
+	// Body (Cylinder) // 
+	scaleXYZ = glm::vec3(1.5f, 5.0f, 1.5f); // Scale for the cylinder body
 	XrotationDegrees = 0.0f;
 	YrotationDegrees = 0.0f;
 	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-4.0f, 1.2f, -1.25f); // Position on the table
+	positionXYZ = glm::vec3(9.0f, 1.5f, -4.0f); // Position on the table
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(0.0f, 0.0f, 0.0f, .0f); // White color for the body
-	SetShaderMaterial("hardplastic");
-	SetShaderTexture("keyboard");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawPlaneMesh();
+	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // White color for the body
+	SetShaderMaterial("silicone");
+	DrawCurvedMesh(TessellatedShapes::SHAPE_CYLINDER, [this]() { m_basicMeshes->DrawCylinderMesh(); });
+	AddDistancePart(DistanceFields::PART_CYLINDER);
 
-	scaleXYZ = glm::vec3(1.0f, 0.1f, 1.0f); //																							I7 Logo on laptop
+	// Base Tapered (Cylinder) // 
+	scaleXYZ = glm::vec3(1.5f, 0.7f, 1.5f); // Scale for the cylinder body
+	XrotationDegrees = 180.0f;
+	YrotationDegrees = 0.0f;
+	ZrotationDegrees = 0.0f;
+	positionXYZ = glm::vec3(9.0f, 1.5f, -4.0f); // Position on the table
+	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // White color for the body
+	SetShaderMaterial("silicone");
+	m_basicMeshes->DrawTaperedCylinderMesh();
+	AddDistancePart(DistanceFields::PART_MESH, [this]() { m_basicMeshes->DrawTaperedCylinderMesh(); });
+
+	// Body after tapered (Cylinder) // 
+	scaleXYZ = glm::vec3(1.3f, 0.8f, 1.3f); // Scale for the cylinder body
 	XrotationDegrees = 0.0f;
 	YrotationDegrees = 0.0f;
 	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-13.0f, 1.2f, 5.0f); // Position on the table
+	positionXYZ = glm::vec3(9.0f, 1.2f, -4.0f); // Position on the table
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(1.0f, 0.0f, 0.0f, 1.0f); // black color 
-	SetShaderTexture("i7");
-	SetShaderMaterial("hardplastic");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawPlaneMesh();
+	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // White color for the body
+	SetShaderMaterial("silicone");
+	DrawCurvedMesh(TessellatedShapes::SHAPE_CYLINDER, [this]() { m_basicMeshes->DrawCylinderMesh(); });
+	AddDistancePart(DistanceFields::PART_CYLINDER);
 
-	scaleXYZ = glm::vec3(2.0f, 0.1f, 1.5f); //																							THINKPAD LOGO on laptop
+	// Base Tapered 2nd (Cylinder) // 
+	scaleXYZ = glm::vec3(1.3f, 1.0f, 1.3f); // Scale for the cylinder body
+	XrotationDegrees = 180.0f;
+	YrotationDegrees = 0.0f;
+	ZrotationDegrees = 0.0f;
+	positionXYZ = glm::vec3(9.0f, 1.2f, -4.0f); // Position on the table
+	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // White color for the body
+	SetShaderMaterial("silicone");
+	m_basicMeshes->DrawTaperedCylinderMesh();
+	AddDistancePart(DistanceFields::PART_MESH, [this]() { m_basicMeshes->DrawTaperedCylinderMesh(); });
+
+	// Base (Cylinder) // 
+	scaleXYZ = glm::vec3(1.0f, 0.6f, 1.0f); // Scale for the cylinder body
 	XrotationDegrees = 0.0f;
 	YrotationDegrees = 0.0f;
 	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(4.5f, 1.2f, 5.5f); // Position on the table
+	positionXYZ = glm::vec3(9.0f, 0.3f, -4.0f); // Position on the table
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // black color
-	SetShaderTexture("thinkpad");
+	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // White color for the body
+	SetShaderMaterial("silicone");
+	DrawCurvedMesh(TessellatedShapes::SHAPE_CYLINDER, [this]() { m_basicMeshes->DrawCylinderMesh(); });
+	AddDistancePart(DistanceFields::PART_CYLINDER);
+
+
+	// Base rounded edge (Torus) // 
+	scaleXYZ = glm::vec3(0.83f, 0.83f, 0.83f); // Scale for the cylinder body
+	XrotationDegrees = 90.0f;
+	YrotationDegrees = 0.0f;
+	ZrotationDegrees = 0.0f;
+	positionXYZ = glm::vec3(9.0f, 0.3f, -4.0f); // Position on the table
+	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // White color for the body
+	SetShaderMaterial("silicone");
+	m_basicMeshes->DrawTorusMesh();
+	AddDistancePart(DistanceFields::PART_MESH, [this]() { m_basicMeshes->DrawTorusMesh(); });
+}
+
+/***********************************************************
+ *  RenderLaptop()
+ *
+ *  This method is used for drawing the laptop.  The
+ *  texture scale is set here instead of carried over from
+ *  the object drawn before, so the laptop looks the same
+ *  when it is drawn on its own for the impostor.
+ ***********************************************************/
+void SceneManager::RenderLaptop()
+{
+	// declare the variables for the transformations
+	glm::vec3 scaleXYZ;
+	float XrotationDegrees = 0.0f;
+	float YrotationDegrees = 0.0f;
+	float ZrotationDegrees = 0.0f;
+	glm::vec3 positionXYZ;
+
+	scaleXYZ = glm::vec3(22.0f, 0.8f, 12.5f); //																						Scale for base of laptop
+	XrotationDegrees = 0.0f;
+	YrotationDegrees = 0.0f;
+	ZrotationDegrees = 0.0f;
+	positionXYZ = glm::vec3(-4.0f, 0.5f, 0.8f); // Position on the table
+	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+	SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); // black color 
+	SetShaderTexture("pctexture");
 	SetShaderMaterial("hardplastic");
 	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawPlaneMesh();
+	m_basicMeshes->DrawBoxMesh();
+	AddDistancePart(DistanceFields::PART_BOX);
 
-	scaleXYZ = glm::vec3(2.0f, 0.1f, 1.5f); //																							THINKPAD LOGO on laptop lid
-	XrotationDegrees = 120.0f;
-	YrotationDegrees = 180.0f;
+	scaleXYZ = glm::vec3(22.0f, 0.2f, 13.0f); //																			Secondary base for laptop
+	XrotationDegrees = 0.0f;
+	YrotationDegrees = 0.0f;
 	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(4.0f, 10.6f, -11.5f); // Position on the table
+	positionXYZ = glm::vec3(-4.0f, 1.0f, 0.7f); // Position on the table
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // black color 
-	SetShaderTexture("thinkpad");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawPlaneMesh();
+	SetShaderColor(0.0f, 1.0f, 1.0f, 1.0f); // White color for the body
+	SetShaderMaterial("hardplastic");
+	SetShaderTexture("pctexture");
+	SetShaderOverlays("laptopBase");
+	m_basicMeshes->DrawBoxMesh();
+	AddDistancePart(DistanceFields::PART_BOX);
 
 	scaleXYZ = glm::vec3(22.0f, 0.2f, 13.0f); //																						Laptop Screen Half with angle 
 	XrotationDegrees = 60.0f;
@@ -1293,8 +1962,10 @@ void SceneManager::RenderScene()
 	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // White color for the body
 	SetShaderTexture("pctexture");
 	SetShaderMaterial("hardplastic");
+	SetShaderOverlays("laptopLid");
 	SetTextureUVScale(1.0f, 1.0f);
 	m_basicMeshes->DrawBoxMesh();
+	AddDistancePart(DistanceFields::PART_BOX);
 
 	scaleXYZ = glm::vec3(10.5f, 0.2f, 5.5f); //																						      Laptop Screen itself
 	XrotationDegrees = 60.0f;
@@ -1306,7 +1977,7 @@ void SceneManager::RenderScene()
 	SetShaderTexture("screen");
 	SetShaderMaterial("plastic");
 	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawPlaneMesh();
+	DrawDoubleSided([this]() { m_basicMeshes->DrawPlaneMesh(); });
 
 	scaleXYZ = glm::vec3(0.4f, 1.0f, 0.4f); //																							   Right hinge for laptop
 	XrotationDegrees = 0.0f;
@@ -1317,7 +1988,8 @@ void SceneManager::RenderScene()
 	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // black color 
 	SetShaderTexture("pctexture");
 	SetShaderMaterial("metal");
-	m_basicMeshes->DrawCylinderMesh();
+	DrawCurvedMesh(TessellatedShapes::SHAPE_CYLINDER, [this]() { m_basicMeshes->DrawCylinderMesh(); });
+	AddDistancePart(DistanceFields::PART_CYLINDER);
 
 	scaleXYZ = glm::vec3(0.4f, 1.0f, 0.4f); //																							      Left hinge for laptop
 	XrotationDegrees = 0.0f;
@@ -1328,7 +2000,8 @@ void SceneManager::RenderScene()
 	SetShaderColor(1.0f, 0.0f, 0.0f, 1.0f); // black color 
 	SetShaderMaterial("metal");
 	SetShaderTexture("pctexture");
-	m_basicMeshes->DrawCylinderMesh();
+	DrawCurvedMesh(TessellatedShapes::SHAPE_CYLINDER, [this]() { m_basicMeshes->DrawCylinderMesh(); });
+	AddDistancePart(DistanceFields::PART_CYLINDER);
 
 	scaleXYZ = glm::vec3(4.0f, 0.8f, 2.0f); //																									LAPTOP TOUCHPAD
 	XrotationDegrees = 0.0f;
@@ -1337,7 +2010,7 @@ void SceneManager::RenderScene()
 	positionXYZ = glm::vec3(-4.0f, 1.15f, 4.7f); // Position on the table
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); // black color
-	m_basicMeshes->DrawPlaneMesh();
+	DrawDoubleSided([this]() { m_basicMeshes->DrawPlaneMesh(); });
 
 	scaleXYZ = glm::vec3(3.25f, 0.1, 0.8f); //																									LAPTOP TOUCHPAD LEFT BUTTON
 	XrotationDegrees = 0.0f;
@@ -1349,16 +2022,7 @@ void SceneManager::RenderScene()
 	SetShaderTexture("pctexture");
 	SetShaderMaterial("hardplastic");
 	m_basicMeshes->DrawBoxMesh();
-
-	scaleXYZ = glm::vec3(1.55f, 0.1, 0.05f); //																									LAPTOP TOUCHPAD LEFT BUTTON RED LINE
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-6.37f, 1.21f, 2.65f); // Position on the table
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(1.0f, 0.0f, 0.0f, 1.0f); // black color 
-	SetShaderMaterial("hardplastic");
-	m_basicMeshes->DrawPlaneMesh();
+	AddDistancePart(DistanceFields::PART_BOX);
 
 	scaleXYZ = glm::vec3(3.25f, 0.1, 0.8f); //																									LAPTOP TOUCHPAD RIGHT BUTTON
 	XrotationDegrees = 0.0f;
@@ -1370,15 +2034,7 @@ void SceneManager::RenderScene()
 	SetShaderTexture("pctexture");
 	SetShaderMaterial("hardplastic");
 	m_basicMeshes->DrawBoxMesh();
-
-	scaleXYZ = glm::vec3(1.55f, 0.1, 0.05f); //																									LAPTOP TOUCHPAD RIGHT BUTTON RED LINE
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-1.63f, 1.21f, 2.65f); // Position on the table
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(1.0f, 0.0f, 0.0f, 1.0f); // black color 
-	m_basicMeshes->DrawPlaneMesh();
+	AddDistancePart(DistanceFields::PART_BOX);
 
 	scaleXYZ = glm::vec3(1.5f, 0.1, 0.8f); //																									LAPTOP TOUCHPAD MIDDLE BUTTON
 	XrotationDegrees = 0.0f;
@@ -1390,6 +2046,7 @@ void SceneManager::RenderScene()
 	SetShaderTexture("pctexture");
 	SetShaderMaterial("hardplastic");
 	m_basicMeshes->DrawBoxMesh();
+	AddDistancePart(DistanceFields::PART_BOX);
 
 	scaleXYZ = glm::vec3(0.8f, 0.1, 0.8f); //																									LAPTOP TOUCHPAD MIDDLE BUTTON EXTEND
 	XrotationDegrees = 0.0f;
@@ -1401,6 +2058,7 @@ void SceneManager::RenderScene()
 	SetShaderTexture("pctexture");
 	SetShaderMaterial("hardplastic");
 	m_basicMeshes->DrawPrismMesh();
+	AddDistancePart(DistanceFields::PART_MESH, [this]() { m_basicMeshes->DrawPrismMesh(); });
 
 	scaleXYZ = glm::vec3(0.8f, 0.1, 0.8f); //																									LAPTOP TOUCHPAD MIDDLE BUTTON EXTEND
 	XrotationDegrees = 0.0f;
@@ -1412,10 +2070,24 @@ void SceneManager::RenderScene()
 	SetShaderTexture("pctexture");
 	SetShaderMaterial("hardplastic");
 	m_basicMeshes->DrawPrismMesh();
+	AddDistancePart(DistanceFields::PART_MESH, [this]() { m_basicMeshes->DrawPrismMesh(); });
+}
 
-
-	//MOUSE OBJECT
-
+/***********************************************************
+ *  RenderMouse()
+ *
+ *  This method is used for drawing the mouse.  It used the
+ *  laptop's material, which is now set here so the mouse
+ *  does not depend on the laptop being drawn first.
+ ***********************************************************/
+void SceneManager::RenderMouse()
+{
+	// declare the variables for the transformations
+	glm::vec3 scaleXYZ;
+	float XrotationDegrees = 0.0f;
+	float YrotationDegrees = 0.0f;
+	float ZrotationDegrees = 0.0f;
+	glm::vec3 positionXYZ;
 
 	scaleXYZ = glm::vec3(2.5f, 2.5f, 4.0f); //																											Mouse Body
 	XrotationDegrees = 0.0f;
@@ -1424,7 +2096,17 @@ void SceneManager::RenderScene()
 	positionXYZ = glm::vec3(11.0f, 0.1f, 2.0f); // Position on the table
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); // black color 
-	m_basicMeshes->DrawHalfSphereMesh();
+	SetShaderMaterial("hardplastic");
+	// the body narrows towards the buttons
+	MeshDeformer::DEFORMER mouseTaper;
+	mouseTaper.type = MeshDeformer::DEFORM_TAPER;
+	mouseTaper.axis = 2;
+	mouseTaper.amount = 0.2f;
+	mouseTaper.frequency = 0.0f;
+	mouseTaper.phase = 0.0f;
+	std::function<void()> drawBody = [this]() { m_basicMeshes->DrawHalfSphereMesh(); };
+	m_pMeshDeformer->Draw("mouseBody", { mouseTaper }, drawBody);
+	AddDistancePart(DistanceFields::PART_MESH, drawBody, { mouseTaper });
 
 	scaleXYZ = glm::vec3(1.0f, 0.7f, 1.0f); //																											Mouse Scroll Wheel
 	XrotationDegrees = 0.0f;
@@ -1433,11 +2115,25 @@ void SceneManager::RenderScene()
 	positionXYZ = glm::vec3(11.3f, 1.7f, 0.0f); // Position on the table
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // black color 
-	m_basicMeshes->DrawCylinderMesh();
-
-
+	DrawCurvedMesh(TessellatedShapes::SHAPE_CYLINDER, [this]() { m_basicMeshes->DrawCylinderMesh(); });
+	AddDistancePart(DistanceFields::PART_CYLINDER);
+}
 
-	// COUCH IN BACKGROUND
+/***********************************************************
+ *  RenderCouch()
+ *
+ *  This method is used for drawing the couch in the
+ *  background, with the material it used to inherit from
+ *  the mouse.
+ ***********************************************************/
+void SceneManager::RenderCouch()
+{
+	// declare the variables for the transformations
+	glm::vec3 scaleXYZ;
+	float XrotationDegrees = 0.0f;
+	float YrotationDegrees = 0.0f;
+	float ZrotationDegrees = 0.0f;
+	glm::vec3 positionXYZ;
 
 	scaleXYZ = glm::vec3(50.0f, 3.0f, 20.0f); //																									CUSHION 1
 	XrotationDegrees = 0.0f;
@@ -1447,8 +2143,10 @@ void SceneManager::RenderScene()
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // black color 
 	SetShaderTexture("couch");
+	SetShaderMaterial("hardplastic");
 	SetTextureUVScale(1.0f, 1.0f);
 	m_basicMeshes->DrawBoxMesh();
+	AddDistancePart(DistanceFields::PART_BOX);
 
 	scaleXYZ = glm::vec3(50.0f, 3.0f, 20.0f); //																									CUSHION 2
 	XrotationDegrees = 90.0f;
@@ -1460,6 +2158,7 @@ void SceneManager::RenderScene()
 	SetShaderTexture("couch");
 	SetTextureUVScale(1.0f, 1.0f);
 	m_basicMeshes->DrawBoxMesh();
+	AddDistancePart(DistanceFields::PART_BOX);
 
 	scaleXYZ = glm::vec3(50.0f, 17.5f, 19.5f); //																						COUCH BASE			
 	XrotationDegrees = 0.0f;
@@ -1471,7 +2170,24 @@ void SceneManager::RenderScene()
 	SetShaderTexture("wood2");
 	SetTextureUVScale(1.0f, 1.0f);
 	m_basicMeshes->DrawBoxMesh();
+	AddDistancePart(DistanceFields::PART_BOX);
+}
 
+/***********************************************************
+ *  RenderSuitcase()
+ *
+ *  This method is used for drawing the suitcase in the
+ *  background, with the material it used to inherit from
+ *  the couch.
+ ***********************************************************/
+void SceneManager::RenderSuitcase()
+{
+	// declare the variables for the transformations
+	glm::vec3 scaleXYZ;
+	float XrotationDegrees = 0.0f;
+	float YrotationDegrees = 0.0f;
+	float ZrotationDegrees = 0.0f;
+	glm::vec3 positionXYZ;
 
 	scaleXYZ = glm::vec3(17.0f, 8.0f, 23.0f); //																									
 	XrotationDegrees = 0.0f;
@@ -1481,8 +2197,10 @@ void SceneManager::RenderScene()
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	SetShaderColor(0.0f, 0.0f, 1.0f, 1.0f); // black color 
 	SetShaderTexture("suitcase");
+	SetShaderMaterial("hardplastic");
 	SetTextureUVScale(1.0f, 1.0f);
 	m_basicMeshes->DrawBoxMesh();
+	AddDistancePart(DistanceFields::PART_BOX);
 
 	scaleXYZ = glm::vec3(2.0f, 1.2f, 0.8f); //																									
 	XrotationDegrees = 90.0f;
@@ -1491,7 +2209,8 @@ void SceneManager::RenderScene()
 	positionXYZ = glm::vec3(26.0f, -2.4f, -13.0f); // Position on the table															SUITCASE LEFT NUB
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); // black color 
-	m_basicMeshes->DrawHalfSphereMesh();
+	DrawCurvedMesh(TessellatedShapes::SHAPE_HALF_SPHERE, [this]() { m_basicMeshes->DrawHalfSphereMesh(); });
+	AddDistancePart(DistanceFields::PART_MESH, [this]() { m_basicMeshes->DrawHalfSphereMesh(); });
 
 	scaleXYZ = glm::vec3(2.0f, 1.2f, 0.8f); //																									
 	XrotationDegrees = 90.0f;
@@ -1500,7 +2219,8 @@ void SceneManager::RenderScene()
 	positionXYZ = glm::vec3(34.5f, -2.4f, -13.0f); // Position on the table															SUITCASE RIGHT NUB
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); // black color 
-	m_basicMeshes->DrawHalfSphereMesh();
+	DrawCurvedMesh(TessellatedShapes::SHAPE_HALF_SPHERE, [this]() { m_basicMeshes->DrawHalfSphereMesh(); });
+	AddDistancePart(DistanceFields::PART_MESH, [this]() { m_basicMeshes->DrawHalfSphereMesh(); });
 
 	scaleXYZ = glm::vec3(17.5f, 1.5f, 23.5f); //																									
 	XrotationDegrees = 0.0f;
@@ -1511,4 +2231,403 @@ void SceneManager::RenderScene()
 	SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); // 
 	SetShaderMaterial("silicone");
 	m_basicMeshes->DrawBoxMesh();
+	AddDistancePart(DistanceFields::PART_BOX);
+}
+
+/***********************************************************
+ *  DefineSceneComposites()
+ *
+ *  This method is used for listing the objects built from
+ *  several meshes, with a bounding sphere around each, so
+ *  they can be swapped for a billboard from far away, and a
+ *  bounding box around the same center for the occlusion
+ *  tests.
+ ***********************************************************/
+void SceneManager::DefineSceneComposites()
+{
+	COMPOSITE_OBJECT tumbler;
+	tumbler.tag = "tumbler";
+	tumbler.center = glm::vec3(9.0f, 4.6f, -4.0f);
+	tumbler.radius = 5.25f;
+	tumbler.halfSize = glm::vec3(1.9f, 4.8f, 1.8f);
+	tumbler.draw = [this]() { RenderTumbler(); };
+	tumbler.drawCount = 0;
+	m_composites.push_back(tumbler);
+
+	COMPOSITE_OBJECT laptop;
+	laptop.tag = "laptop";
+	laptop.center = glm::vec3(-4.0f, 6.75f, -2.7f);
+	laptop.radius = 16.2f;
+	laptop.halfSize = glm::vec3(11.2f, 6.8f, 9.9f);
+	laptop.draw = [this]() { RenderLaptop(); };
+	laptop.drawCount = 0;
+	m_composites.push_back(laptop);
+
+	COMPOSITE_OBJECT mouse;
+	mouse.tag = "mouse";
+	mouse.center = glm::vec3(11.0f, 1.3f, 1.5f);
+	mouse.radius = 4.5f;
+	mouse.halfSize = glm::vec3(2.6f, 1.5f, 4.6f);
+	mouse.draw = [this]() { RenderMouse(); };
+	mouse.drawCount = 0;
+	m_composites.push_back(mouse);
+
+	COMPOSITE_OBJECT couch;
+	couch.tag = "couch";
+	couch.center = glm::vec3(15.0f, -9.5f, -29.8f);
+	couch.radius = 33.7f;
+	couch.halfSize = glm::vec3(25.1f, 20.4f, 10.1f);
+	couch.draw = [this]() { RenderCouch(); };
+	couch.drawCount = 0;
+	m_composites.push_back(couch);
+
+	COMPOSITE_OBJECT suitcase;
+	suitcase.tag = "suitcase";
+	suitcase.center = glm::vec3(30.0f, -5.0f, -24.8f);
+	suitcase.radius = 15.5f;
+	suitcase.halfSize = glm::vec3(8.8f, 4.1f, 13.0f);
+	suitcase.draw = [this]() { RenderSuitcase(); };
+	suitcase.drawCount = 0;
+	m_composites.push_back(suitcase);
+}
+
+/***********************************************************
+ *  DrawComposite()
+ *
+ *  This method is used for drawing a composite object from
+ *  its meshes, or queueing its billboard when it is small on
+ *  screen.  A skipped object still advances the draw index by
+ *  its number of draws, so the objects after it keep their
+ *  previous models for the motion vectors.  In the camera
+ *  view, a full draw is conditional on last frame's occlusion
+ *  test and queues the test for this frame.
+ ***********************************************************/
+void SceneManager::DrawComposite(std::string tag)
+{
+	int index = 0;
+	while ((index < (int)m_composites.size()) && (m_composites[index].tag != tag))
+	{
+		index++;
+	}
+	if (index >= (int)m_composites.size())
+	{
+		return;
+	}
+	COMPOSITE_OBJECT& composite = m_composites[index];
+
+	// the atlas layer of each object is its index in the list
+	if ((NULL != m_pImpostors) && (NULL != m_pLevelOfDetailView) && (composite.drawCount > 0) &&
+		(m_pImpostors->IsSmall(composite.center, composite.radius, m_pLevelOfDetailView, m_viewportHeight) == true))
+	{
+		m_pImpostors->AddInstance(index, composite.center, composite.radius);
+		m_transformIndex += composite.drawCount;
+		return;
+	}
+
+	// the draws are still sent, but the GPU drops them when the box
+	// was hidden last frame
+	bool bOcclusionTest = ((NULL != m_pOcclusionQueries) && (NULL != m_pLevelOfDetailView));
+	if (bOcclusionTest == true)
+	{
+		m_pOcclusionQueries->BeginConditionalDraw(index);
+		if (NULL != m_pTessellatedShapes)
+		{
+			m_pTessellatedShapes->DeferCaptures(true);
+		}
+	}
+
+	int firstDraw = m_transformIndex;
+	composite.draw();
+	composite.drawCount = m_transformIndex - firstDraw;
+
+	if (bOcclusionTest == true)
+	{
+		m_pOcclusionQueries->EndConditionalDraw(index);
+		m_pOcclusionQueries->AddBox(index, composite.center, composite.halfSize);
+		if (NULL != m_pTessellatedShapes)
+		{
+			m_pTessellatedShapes->DeferCaptures(false);
+		}
+	}
+}
+
+/***********************************************************
+ *  BakeImpostors()
+ *
+ *  This method is used for baking the views of every
+ *  composite object into the impostor atlas.  It is called
+ *  once the lights and the environment are set on the scene
+ *  shader, so the baked views are lit like the room.
+ ***********************************************************/
+void SceneManager::BakeImpostors()
+{
+	if ((NULL != m_pImpostors) || (m_composites.empty() == true))
+	{
+		return;
+	}
+
+	m_pImpostors = new Impostors(m_pShaderManager);
+	if (m_pImpostors->Create((int)m_composites.size()) == false)
+	{
+		delete m_pImpostors;
+		m_pImpostors = NULL;
+		return;
+	}
+
+	for (int i = 0; i < (int)m_composites.size(); i++)
+	{
+		COMPOSITE_OBJECT& composite = m_composites[i];
+		m_pImpostors->Bake(i, composite.center, composite.radius,
+			[this, &composite]()
+			{
+				int firstDraw = m_transformIndex;
+				if (m_bCullBackFaces == true)
+				{
+					composite.draw();
+				}
+				else
+				{
+					DrawDoubleSided(composite.draw);
+				}
+				composite.drawCount = m_transformIndex - firstDraw;
+			});
+	}
+
+	// the baking draws are not part of the scene, so the first frame
+	// starts without previous models
+	m_previousModels.clear();
+	m_transformIndex = 0;
+}
+
+/***********************************************************
+ *  BakeDistanceFields()
+ *
+ *  This method is used for baking the distance field of
+ *  every composite object.  Each object is drawn with no
+ *  fragments while its parts are collected, then baked into
+ *  the atlas, which is set on the scene shader once all are
+ *  in.  It runs once while the scene is prepared.
+ ***********************************************************/
+void SceneManager::BakeDistanceFields()
+{
+	if ((NULL != m_pDistanceFields) || (m_composites.empty() == true))
+	{
+		return;
+	}
+
+	m_pDistanceFields = new DistanceFields();
+	if (m_pDistanceFields->Create() == false)
+	{
+		delete m_pDistanceFields;
+		m_pDistanceFields = NULL;
+		return;
+	}
+
+	// the draws only place the parts, nothing is rasterized
+	PipelineState passState = PipelineState::GetCurrent();
+	PipelineState::Bind(PipelineState(PipelineState::GetProgram(m_pShaderManager),
+		PipelineState::BLEND_NONE, PipelineState::DEPTH_OFF, true,
+		PipelineState::CULL_NONE, PipelineState::RASTER_DISCARD));
+
+	std::vector<DistanceFields::PART> parts;
+	m_pDistanceParts = &parts;
+	for (int i = 0; i < (int)m_composites.size(); i++)
+	{
+		COMPOSITE_OBJECT& composite = m_composites[i];
+		parts.clear();
+		composite.draw();
+		m_pDistanceFields->AddObject(composite.tag, composite.center, composite.halfSize, parts);
+	}
+	m_pDistanceParts = NULL;
+
+	m_pDistanceFields->SetShaderValues(m_pShaderManager);
+	PipelineState::Bind(passState);
+
+	// the baking draws are not part of the scene, so the first frame
+	// starts without previous models
+	m_previousModels.clear();
+	m_transformIndex = 0;
+}
+
+/***********************************************************
+ *  SetLevelOfDetailView()
+ *
+ *  This method is used for setting the camera the next
+ *  RenderScene() measures the objects with.  Captures such as
+ *  the environment probe do not set it and always get every
+ *  object in full.
+ ***********************************************************/
+void SceneManager::SetLevelOfDetailView(ViewManager* pViewManager, int viewportHeight)
+{
+	m_pLevelOfDetailView = pViewManager;
+	m_viewportHeight = viewportHeight;
+}
+
+/***********************************************************
+ *  DrawCurvedMesh()
+ *
+ *  This method is used for drawing a curved shape with the
+ *  transformations set last, tessellated for its size from
+ *  the level of detail camera.  Draws without that camera
+ *  get the default density.
+ ***********************************************************/
+void SceneManager::DrawCurvedMesh(TessellatedShapes::SHAPE_TYPE shape, std::function<void()> drawMesh)
+{
+	if (NULL == m_pTessellatedShapes)
+	{
+		drawMesh();
+		return;
+	}
+
+	float pixelsPerUnit = 0.0f;
+	if (NULL != m_pLevelOfDetailView)
+	{
+		glm::mat4 inverseView = glm::inverse(m_pLevelOfDetailView->GetViewMatrix());
+		glm::vec3 cameraPosition = glm::vec3(inverseView[3].x, inverseView[3].y, inverseView[3].z);
+		glm::vec3 center = glm::vec3(m_currentModel[3].x, m_currentModel[3].y, m_currentModel[3].z);
+
+		// the largest scale of the model, measured from the nearest
+		// point of the shape so close ups get the full density
+		float scale = glm::length(glm::vec3(m_currentModel[0].x, m_currentModel[0].y, m_currentModel[0].z));
+		scale = glm::max(scale, glm::length(glm::vec3(m_currentModel[1].x, m_currentModel[1].y, m_currentModel[1].z)));
+		scale = glm::max(scale, glm::length(glm::vec3(m_currentModel[2].x, m_currentModel[2].y, m_currentModel[2].z)));
+		float distance = glm::max(glm::length(center - cameraPosition) - scale, 0.1f);
+
+		pixelsPerUnit = scale / distance * m_pLevelOfDetailView->GetProjectionMatrix()[1][1] * 0.5f * m_viewportHeight;
+	}
+
+	m_pTessellatedShapes->Draw(shape, pixelsPerUnit, drawMesh);
+}
+
+/***********************************************************
+ *  DrawDoubleSided()
+ *
+ *  This method is used for drawing a mesh that is seen from
+ *  both sides, like the planes of the walls, with culling
+ *  off.  The cull mode of the pass is set again after it.
+ ***********************************************************/
+void SceneManager::DrawDoubleSided(std::function<void()> drawMesh)
+{
+	PipelineState passState = PipelineState::GetCurrent();
+	PipelineState::Bind(passState.WithCull(PipelineState::CULL_NONE));
+	drawMesh();
+	PipelineState::Bind(passState);
+}
+
+/***********************************************************
+ *  AddDistancePart()
+ *
+ *  This method is used for adding the mesh drawn last to the
+ *  object whose distance field is being baked, and does
+ *  nothing the rest of the time.  Boxes, spheres and
+ *  cylinders only need the model matrix; any other shape is
+ *  read back through drawMesh and its deformers, and its
+ *  triangles moved into the world.
+ ***********************************************************/
+void SceneManager::AddDistancePart(DistanceFields::PART_SHAPE shape, std::function<void()> drawMesh,
+	const std::vector<MeshDeformer::DEFORMER>& deformers)
+{
+	if (NULL == m_pDistanceParts)
+	{
+		return;
+	}
+
+	DistanceFields::PART part;
+	part.shape = shape;
+	part.model = m_currentModel;
+	if (shape == DistanceFields::PART_MESH)
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec3> normals;
+		if ((NULL == m_pMeshDeformer) || (drawMesh == nullptr) ||
+			(m_pMeshDeformer->ReadTriangles(drawMesh, positions, normals, deformers) == false))
+		{
+			return;
+		}
+		for (int i = 0; i < (int)positions.size(); i++)
+		{
+			glm::vec4 position = m_currentModel * glm::vec4(positions[i], 1.0f);
+			part.triangles.push_back(glm::vec3(position.x, position.y, position.z));
+		}
+	}
+	m_pDistanceParts->push_back(part);
+}
+
+/***********************************************************
+ *  CheckMeshWinding()
+ *
+ *  This method is used for checking that every mesh drawn
+ *  with its back faces culled winds its triangles the way
+ *  its normals point, basic and tessellated alike.  The
+ *  meshes are captured as they are drawn and read back, so
+ *  it runs once while the scene is prepared.  The plane is
+ *  left out, it is always drawn double sided.  Returns false
+ *  when a mesh would lose part of its outside to culling.
+ ***********************************************************/
+bool SceneManager::CheckMeshWinding()
+{
+	if (NULL == m_pMeshDeformer)
+	{
+		return(true);
+	}
+
+	std::vector<std::pair<std::string, std::function<void()>>> meshes = {
+		{ "box", [this]() { m_basicMeshes->DrawBoxMesh(); } },
+		{ "cylinder", [this]() { m_basicMeshes->DrawCylinderMesh(); } },
+		{ "cone", [this]() { m_basicMeshes->DrawConeMesh(); } },
+		{ "prism", [this]() { m_basicMeshes->DrawPrismMesh(); } },
+		{ "pyramid", [this]() { m_basicMeshes->DrawPyramid4Mesh(); } },
+		{ "sphere", [this]() { m_basicMeshes->DrawSphereMesh(); } },
+		{ "half sphere", [this]() { m_basicMeshes->DrawHalfSphereMesh(); } },
+		{ "tapered cylinder", [this]() { m_basicMeshes->DrawTaperedCylinderMesh(); } },
+		{ "torus", [this]() { m_basicMeshes->DrawTorusMesh(); } },
+		{ "half torus", [this]() { m_basicMeshes->DrawHalfTorusMesh(); } } };
+
+	if (NULL != m_pTessellatedShapes)
+	{
+		const char* shapeNames[TessellatedShapes::SHAPE_COUNT] = {
+			"tessellated sphere", "tessellated half sphere",
+			"tessellated cylinder", "tessellated cylinder sides" };
+		std::function<void()> drawFallback = [this]() { m_basicMeshes->DrawSphereMesh(); };
+
+		// a tessellated mesh is captured on its first draw, which
+		// cannot happen inside the capture of the check, so each is
+		// drawn once before with no fragments
+		PipelineState passState = PipelineState::GetCurrent();
+		PipelineState::Bind(PipelineState(PipelineState::GetProgram(m_pShaderManager),
+			PipelineState::BLEND_NONE, PipelineState::DEPTH_OFF, true,
+			PipelineState::CULL_NONE, PipelineState::RASTER_DISCARD));
+		for (int shape = 0; shape < TessellatedShapes::SHAPE_COUNT; shape++)
+		{
+			TessellatedShapes::SHAPE_TYPE type = (TessellatedShapes::SHAPE_TYPE)shape;
+			m_pTessellatedShapes->Draw(type, 0.0f, drawFallback);
+			meshes.push_back(std::make_pair(std::string(shapeNames[shape]),
+				[this, type, drawFallback]() { m_pTessellatedShapes->Draw(type, 0.0f, drawFallback); }));
+		}
+		PipelineState::Bind(passState);
+	}
+
+	bool bConsistent = true;
+	for (int i = 0; i < (int)meshes.size(); i++)
+	{
+		int triangleCount = 0;
+		int inverted = m_pMeshDeformer->CountInvertedTriangles(meshes[i].second, triangleCount);
+		if (inverted > 0)
+		{
+			std::cout << "ERROR: " << inverted << " of " << triangleCount << " triangles of the "
+				<< meshes[i].first << " mesh are wound clockwise" << std::endl;
+			bConsistent = false;
+		}
+	}
+
+	if (bConsistent == true)
+	{
+		std::cout << "INFO: Winding checked on " << meshes.size() << " meshes, back faces are culled" << std::endl;
+	}
+	else
+	{
+		std::cout << "INFO: Back faces are not culled" << std::endl;
+	}
+
+	return(bConsistent);
 }
@@ -11,7 +11,17 @@
 
 #include "ShaderManager.h"
 #include "ShapeMeshes.h"
-
+#include "BRDFLookup.h"
+#include "DeferredDecals.h"
+#include "MeshDeformer.h"
+#include "Impostors.h"
+#include "TessellatedShapes.h"
+#include "OcclusionQueries.h"
+#include "DistanceFields.h"
+#include "PipelineState.h"
+#include "ViewManager.h"
+
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -34,17 +44,71 @@ public:
 	{
 		std::string tag;
 		uint32_t ID;
+		// texture has an alpha channel and is drawn with alpha-to-coverage
+		bool bAlphaToCoverage;
+		// alpha is mostly 0 or 1 (a cutout), so coverage edges are sharpened
+		bool bSharpenAlpha;
+		// two-channel tangent space normal map, 0 when there is none
+		uint32_t normalMapID;
+		// mean spread of the normals averaged into each mip level of
+		// the normal map, which widens the highlights
+		std::vector<float> normalVariance;
 	};
 
 	// properties for object materials
 	struct OBJECT_MATERIAL
 	{
 		glm::vec3 diffuseColor;
-		glm::vec3 specularColor;
-		float shininess;
+		// metallic/roughness model - 0 for dielectrics, 1 for metals
+		float metallic;
+		float roughness;
+		// strength of screen space reflections, 0 skips the trace
+		float reflectivity;
+		// parallax occlusion mapping from the texture brightness
+		bool bParallax;
+		float parallaxDepth;
+		std::string tag;
+	};
+
+	// texture layered over an object, projected along the mesh Y axis
+	struct OVERLAY_LAYER
+	{
+		std::string textureTag;
+		// center and size of the layer in mesh XZ coordinates
+		glm::vec2 center;
+		glm::vec2 size;
+		// layer sits on the bottom face instead of the top face
+		bool bBottom;
+		// the normal map of the layer texture bends the surface under
+		// it, and its brightness is marched this deep for parallax -
+		// only the first layer with relief is used
+		bool bRelief;
+		float parallaxDepth;
+	};
+
+	// properties for object overlays - up to 4 layers in one draw
+	struct OBJECT_OVERLAYS
+	{
+		std::vector<OVERLAY_LAYER> layers;
 		std::string tag;
 	};
 
+	// object built from several meshes, drawn as one billboard when
+	// it is small on screen
+	struct COMPOSITE_OBJECT
+	{
+		std::string tag;
+		// bounding sphere around all the meshes, and the bounding box
+		// around the same center
+		glm::vec3 center;
+		float radius;
+		glm::vec3 halfSize;
+		// draws the object from its meshes
+		std::function<void()> draw;
+		// SetTransformations() calls in one draw, 0 until it is drawn
+		int drawCount;
+	};
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
@@ -52,19 +116,55 @@ private:
 	ShapeMeshes *m_basicMeshes;
 	// the number of loaded textures
 	int m_loadedTextures;
+	// current alpha-to-coverage state
+	bool m_bAlphaToCoverage;
 	// loaded textures info
 	TEXTURE_INFO m_textureIDs[16];
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// defined object overlays
+	std::vector<OBJECT_OVERLAYS> m_objectOverlays;
+	// overlay layers are set for the current object
+	bool m_bOverlaysSet;
+	// split-sum lookup for the metallic/roughness lighting
+	BRDFLookup* m_pBRDFLookup;
+	// cached deformed copies of the meshes that use deformers
+	MeshDeformer* m_pMeshDeformer;
+	// model matrix of each draw last frame, by draw order, and the
+	// draws placed so far this frame
+	std::vector<glm::mat4> m_previousModels;
+	int m_transformIndex;
+	// defined composite objects and their baked billboards
+	std::vector<COMPOSITE_OBJECT> m_composites;
+	Impostors* m_pImpostors;
+	// camera and viewport height the next RenderScene() picks the
+	// billboards with, NULL draws every object in full
+	ViewManager* m_pLevelOfDetailView;
+	int m_viewportHeight;
+	// curved shapes refined to their size on screen, and the model
+	// matrix of the draw they are sized for
+	TessellatedShapes* m_pTessellatedShapes;
+	glm::mat4 m_currentModel;
+	// occlusion tests of the composite objects, by composite index
+	OcclusionQueries* m_pOcclusionQueries;
+	// the solids are drawn with their back faces culled, unless a
+	// mesh failed the winding check
+	bool m_bCullBackFaces;
+	// distance fields of the composite objects, and the parts of the
+	// object being baked - NULL outside of the bake
+	DistanceFields* m_pDistanceFields;
+	std::vector<DistanceFields::PART>* m_pDistanceParts;
 
 	// methods for managing OpenGL textures
 	bool CreateGLTexture(const char* filename, std::string tag);
+	bool CreateGLNormalMap(const char* filename, std::string tag, float bumpStrength);
 	void BindGLTextures();
 	void DestroyGLTextures();
 	int FindTextureID(std::string tag);
 	int FindTextureSlot(std::string tag);
 
 	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	bool FindOverlays(std::string tag, OBJECT_OVERLAYS& overlays);
 
 	// set the transformation values 
 	// into the transform buffer
@@ -86,12 +186,49 @@ private:
 
 	void DefineObjectMaterials();
 
+	// set the overlay layers into the shader for the next draw,
+	// cleared again by the next SetTransformations()
+	void SetShaderOverlays(std::string overlaysTag);
+
+	void DefineObjectOverlays();
+
+	void DefineSceneComposites();
+
+	// draw a composite object in full or queue its billboard
+	void DrawComposite(std::string tag);
+
+	// draw a curved shape tessellated for its size on screen, or
+	// with drawMesh when there is no tessellation
+	void DrawCurvedMesh(TessellatedShapes::SHAPE_TYPE shape, std::function<void()> drawMesh);
+	// draw a mesh seen from both sides with culling off
+	void DrawDoubleSided(std::function<void()> drawMesh);
+	// check the winding of the meshes drawn culled, false when a
+	// mesh has triangles wound against its normals
+	bool CheckMeshWinding();
+	// add the mesh drawn last to the distance field being baked,
+	// the basic shapes by their transformations and everything else
+	// by the triangles drawMesh draws
+	void AddDistancePart(DistanceFields::PART_SHAPE shape, std::function<void()> drawMesh = nullptr,
+		const std::vector<MeshDeformer::DEFORMER>& deformers = std::vector<MeshDeformer::DEFORMER>());
+	// bake the distance fields of the composite objects
+	void BakeDistanceFields();
+
+	// draw the composite objects from their meshes
+	void RenderTumbler();
+	void RenderLaptop();
+	void RenderMouse();
+	void RenderCouch();
+	void RenderSuitcase();
+
 	void SetupSceneLights();
 
 	// set the texture data into the shader
 	void SetShaderTexture(
 		std::string textureTag);
 
+	// turn alpha-to-coverage on or off for the next draw command
+	void SetAlphaToCoverage(bool bEnable, bool bSharpen);
+
 	// set the texture UV scale into the shader
 	void SetTextureUVScale(
 		float u, float v);
@@ -102,7 +239,15 @@ public:
 	/*** customize for their own 3D scene              ***/
 	void PrepareScene();
 	void RenderScene();
+	// add the decals of the scene to the decal instances
+	void DefineSceneDecals(DeferredDecals* pDecals);
 
 	// loads textures from image files
 	void LoadSceneTextures();
+
+	// bake the billboards of the composite objects, once the scene
+	// shader has its lights and environment
+	void BakeImpostors();
+	// set the camera the next RenderScene() picks the billboards with
+	void SetLevelOfDetailView(ViewManager* pViewManager, int viewportHeight);
 };
\ No newline at end of file
@@ -0,0 +1,451 @@
+///////////////////////////////////////////////////////////////////////////////
+// screenspacereflections.cpp
+// ============
+// manage the screen space reflections of the reflective materials - a
+// hierarchical depth trace at half resolution with temporal reuse
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ScreenSpaceReflections.h"
+#include "FullscreenPass.h"
+#include "GLDebug.h"
+
+#include <iostream>
+
+// declare the global variables
+namespace
+{
+	// the trace and its history are half the scene size
+	const int g_TraceDivisor = 2;
+	// reflections are HDR, and the alpha holds the confidence
+	const GLenum g_ReflectionFormat = GL_RGBA16F;
+	// near plane of the projection set by the view manager
+	const float g_NearPlane = 0.1f;
+	// iterations added or removed per budget adjustment
+	const int g_IterationStep = 4;
+}
+
+/***********************************************************
+ *  ScreenSpaceReflections()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ScreenSpaceReflections::ScreenSpaceReflections(ViewManager* pViewManager)
+{
+	m_pViewManager = pViewManager;
+	m_pRenderTargetPool = NULL;
+	m_pFrameGraph = NULL;
+	m_pHiZShader = NULL;
+	m_pTraceShader = NULL;
+	m_pTemporalShader = NULL;
+	m_pCompositeShader = NULL;
+	m_hiZTexture = 0;
+	m_hiZLevels = 0;
+	m_historyTargets[0] = -1;
+	m_historyTargets[1] = -1;
+	m_historyIndex = 0;
+	m_bHistoryValid = false;
+	m_traceQuery = 0;
+	m_bTracePending = false;
+	m_width = 0;
+	m_height = 0;
+	m_traceWidth = 0;
+	m_traceHeight = 0;
+
+	// only the metal and window materials are reflective, so the
+	// trace is cheap enough for a millisecond by default
+	m_settings.bEnabled = true;
+	m_settings.maxDistance = 20.0f;
+	m_settings.thickness = 0.5f;
+	m_settings.historyWeight = 0.9f;
+	m_settings.traceBudget = 1.0f;
+	m_settings.minIterations = 8;
+	m_settings.maxIterations = 64;
+	m_iterations = 32;
+}
+
+/***********************************************************
+ *  ~ScreenSpaceReflections()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ScreenSpaceReflections::~ScreenSpaceReflections()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for loading the reflection shaders
+ *  and creating the targets that live across frames - the
+ *  depth pyramid and the two history targets.
+ ***********************************************************/
+bool ScreenSpaceReflections::Create(int width, int height, RenderTargetPool* pRenderTargetPool)
+{
+	if (NULL == pRenderTargetPool)
+	{
+		return false;
+	}
+
+	m_pRenderTargetPool = pRenderTargetPool;
+	m_width = width;
+	m_height = height;
+	m_traceWidth = (width / g_TraceDivisor > 1) ? width / g_TraceDivisor : 1;
+	m_traceHeight = (height / g_TraceDivisor > 1) ? height / g_TraceDivisor : 1;
+
+	m_pHiZShader = FullscreenPass::LoadShader("hiZFragmentShader.glsl");
+	m_pTraceShader = FullscreenPass::LoadShader("ssrTraceFragmentShader.glsl");
+	m_pTemporalShader = FullscreenPass::LoadShader("ssrTemporalFragmentShader.glsl");
+	m_pCompositeShader = FullscreenPass::LoadShader("ssrCompositeFragmentShader.glsl");
+	m_hiZState = FullscreenPass::GetState(m_pHiZShader);
+	m_traceState = FullscreenPass::GetState(m_pTraceShader);
+	m_temporalState = FullscreenPass::GetState(m_pTemporalShader);
+	m_compositeState = FullscreenPass::GetState(m_pCompositeShader, PipelineState::BLEND_ALPHA);
+
+	if (CreateHiZ() == false)
+	{
+		return false;
+	}
+
+	// the history is held for the whole run, so it is acquired once
+	// and never handed back to the pool
+	for (int i = 0; i < 2; i++)
+	{
+		m_historyTargets[i] = m_pRenderTargetPool->AcquireTarget(
+			m_traceWidth, m_traceHeight, g_ReflectionFormat);
+		if (m_historyTargets[i] < 0)
+		{
+			std::cout << "Failed to create the reflection history" << std::endl;
+			return false;
+		}
+	}
+
+	glGenQueries(1, &m_traceQuery);
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shader programs, the
+ *  depth pyramid and the timer query.
+ ***********************************************************/
+void ScreenSpaceReflections::Destroy()
+{
+	if (NULL != m_pHiZShader)
+	{
+		delete m_pHiZShader;
+		m_pHiZShader = NULL;
+	}
+	if (NULL != m_pTraceShader)
+	{
+		delete m_pTraceShader;
+		m_pTraceShader = NULL;
+	}
+	if (NULL != m_pTemporalShader)
+	{
+		delete m_pTemporalShader;
+		m_pTemporalShader = NULL;
+	}
+	if (NULL != m_pCompositeShader)
+	{
+		delete m_pCompositeShader;
+		m_pCompositeShader = NULL;
+	}
+
+	if (m_hiZFramebuffers.size() > 0)
+	{
+		glDeleteFramebuffers(m_hiZFramebuffers.size(), m_hiZFramebuffers.data());
+		m_hiZFramebuffers.clear();
+	}
+	if (m_hiZTexture != 0)
+	{
+		glDeleteTextures(1, &m_hiZTexture);
+		m_hiZTexture = 0;
+	}
+	if (m_traceQuery != 0)
+	{
+		glDeleteQueries(1, &m_traceQuery);
+		m_traceQuery = 0;
+	}
+
+	// the pool frees the history targets when it is destroyed
+	if (NULL != m_pRenderTargetPool)
+	{
+		m_pRenderTargetPool->ReleaseTarget(m_historyTargets[0]);
+		m_pRenderTargetPool->ReleaseTarget(m_historyTargets[1]);
+		m_pRenderTargetPool = NULL;
+	}
+	m_historyTargets[0] = -1;
+	m_historyTargets[1] = -1;
+	m_bHistoryValid = false;
+	m_pFrameGraph = NULL;
+}
+
+/***********************************************************
+ *  AddPasses()
+ *
+ *  This method is used for adding the reflection passes to
+ *  the frame graph:
+ *    1. min depth pyramid from the resolved scene depth
+ *    2. half resolution trace of the reflective pixels
+ *    3. temporal accumulation into the history
+ *    4. fresnel weighted blend over the HDR color
+ ***********************************************************/
+void ScreenSpaceReflections::AddPasses(FrameGraph* pFrameGraph, int hdrColor,
+	int sceneDepth, int sceneSurface)
+{
+	if ((NULL == pFrameGraph) || (m_settings.bEnabled == false) || (m_hiZTexture == 0))
+	{
+		m_bHistoryValid = false;
+		return;
+	}
+	m_pFrameGraph = pFrameGraph;
+
+	UpdateIterationBudget();
+
+	// the persistent targets are imported so the graph orders the
+	// passes around them without allocating them
+	int hiZ = pFrameGraph->ImportTarget("hiZ", m_hiZFramebuffers[0], m_hiZTexture,
+		m_traceWidth, m_traceHeight);
+	int readIndex = m_historyIndex;
+	int writeIndex = 1 - m_historyIndex;
+	m_historyIndex = writeIndex;
+	int historyRead = pFrameGraph->ImportTarget("ssrHistoryRead",
+		m_pRenderTargetPool->GetFramebuffer(m_historyTargets[readIndex]),
+		m_pRenderTargetPool->GetTexture(m_historyTargets[readIndex]),
+		m_traceWidth, m_traceHeight);
+	int historyWrite = pFrameGraph->ImportTarget("ssrHistoryWrite",
+		m_pRenderTargetPool->GetFramebuffer(m_historyTargets[writeIndex]),
+		m_pRenderTargetPool->GetTexture(m_historyTargets[writeIndex]),
+		m_traceWidth, m_traceHeight);
+	int traceColor = pFrameGraph->CreateTarget("ssrTrace", m_traceWidth, m_traceHeight,
+		g_ReflectionFormat);
+
+	pFrameGraph->AddPass("hiZ", { sceneDepth }, { hiZ },
+		[this, sceneDepth]()
+		{
+			BuildHiZ(m_pFrameGraph->GetTexture(sceneDepth));
+		});
+
+	pFrameGraph->AddPass("ssrTrace", { hiZ, sceneSurface, hdrColor }, { traceColor },
+		[this, sceneSurface, hdrColor]()
+		{
+			// the depth was rasterized with the jittered projection
+			glm::mat4 projection = m_pViewManager->GetProjectionMatrix();
+			glm::vec2 jitter = m_pViewManager->GetProjectionJitter();
+			projection[2][0] -= jitter.x;
+			projection[2][1] -= jitter.y;
+
+			PipelineState::Bind(m_traceState);
+			m_pTraceShader->setMat4Value("projection", projection);
+			m_pTraceShader->setMat4Value("inverseProjection", glm::inverse(projection));
+			m_pTraceShader->setVec2Value("hiZSize", glm::vec2(m_traceWidth, m_traceHeight));
+			m_pTraceShader->setIntValue("hiZLevels", m_hiZLevels);
+			m_pTraceShader->setIntValue("maxIterations", m_iterations);
+			m_pTraceShader->setFloatValue("maxDistance", m_settings.maxDistance);
+			m_pTraceShader->setFloatValue("thickness", m_settings.thickness);
+			m_pTraceShader->setFloatValue("nearPlane", g_NearPlane);
+			FullscreenPass::BindTexture(m_pTraceShader, "hiZTexture", 0, m_hiZTexture);
+			FullscreenPass::BindTexture(m_pTraceShader, "surfaceTexture", 1, m_pFrameGraph->GetTexture(sceneSurface));
+			FullscreenPass::BindTexture(m_pTraceShader, "colorTexture", 2, m_pFrameGraph->GetTexture(hdrColor));
+
+			// only one timing is in flight, so reading it back never stalls
+			bool bTimed = (m_bTracePending == false);
+			if (bTimed == true)
+			{
+				glBeginQuery(GL_TIME_ELAPSED, m_traceQuery);
+			}
+			FullscreenPass::Draw();
+			if (bTimed == true)
+			{
+				glEndQuery(GL_TIME_ELAPSED);
+				m_bTracePending = true;
+			}
+		});
+
+	pFrameGraph->AddPass("ssrTemporal", { traceColor, historyRead, hiZ }, { historyWrite },
+		[this, traceColor, historyRead]()
+		{
+			glm::mat4 projection = m_pViewManager->GetProjectionMatrix();
+			glm::vec2 jitter = m_pViewManager->GetProjectionJitter();
+			projection[2][0] -= jitter.x;
+			projection[2][1] -= jitter.y;
+			glm::mat4 viewProjection = projection * m_pViewManager->GetViewMatrix();
+
+			PipelineState::Bind(m_temporalState);
+			m_pTemporalShader->setMat4Value("inverseViewProjection", glm::inverse(viewProjection));
+			m_pTemporalShader->setMat4Value("previousViewProjection", m_pViewManager->GetPreviousViewProjection());
+			m_pTemporalShader->setBoolValue("bHistoryValid", m_bHistoryValid);
+			m_pTemporalShader->setFloatValue("historyWeight", m_settings.historyWeight);
+			FullscreenPass::BindTexture(m_pTemporalShader, "currentTexture", 0, m_pFrameGraph->GetTexture(traceColor));
+			FullscreenPass::BindTexture(m_pTemporalShader, "historyTexture", 1, m_pFrameGraph->GetTexture(historyRead));
+			FullscreenPass::BindTexture(m_pTemporalShader, "depthTexture", 2, m_hiZTexture);
+			FullscreenPass::Draw();
+
+			m_bHistoryValid = true;
+		});
+
+	// the HDR color is read back by the blend
+	pFrameGraph->AddPass("ssrComposite", { historyWrite, sceneSurface, sceneDepth, hdrColor }, { hdrColor },
+		[this, historyWrite, sceneSurface, sceneDepth]()
+		{
+			glm::mat4 projection = m_pViewManager->GetProjectionMatrix();
+			glm::vec2 jitter = m_pViewManager->GetProjectionJitter();
+			projection[2][0] -= jitter.x;
+			projection[2][1] -= jitter.y;
+
+			PipelineState::Bind(m_compositeState);
+			m_pCompositeShader->setMat4Value("inverseProjection", glm::inverse(projection));
+			FullscreenPass::BindTexture(m_pCompositeShader, "reflectionTexture", 0, m_pFrameGraph->GetTexture(historyWrite));
+			FullscreenPass::BindTexture(m_pCompositeShader, "surfaceTexture", 1, m_pFrameGraph->GetTexture(sceneSurface));
+			FullscreenPass::BindTexture(m_pCompositeShader, "depthTexture", 2, m_pFrameGraph->GetTexture(sceneDepth));
+			FullscreenPass::Draw();
+		});
+}
+
+/***********************************************************
+ *  CreateHiZ()
+ *
+ *  This method is used for creating the min depth pyramid at
+ *  the trace resolution, with one framebuffer per mip level
+ *  so each level can be rendered from the one above it.
+ ***********************************************************/
+bool ScreenSpaceReflections::CreateHiZ()
+{
+	int largest = (m_traceWidth > m_traceHeight) ? m_traceWidth : m_traceHeight;
+
+	m_hiZLevels = 1;
+	while ((largest >> m_hiZLevels) > 0)
+	{
+		m_hiZLevels++;
+	}
+
+	glGenTextures(1, &m_hiZTexture);
+	glBindTexture(GL_TEXTURE_2D, m_hiZTexture);
+	GL_DEBUG_LABEL(GL_TEXTURE, m_hiZTexture, "hierarchical depth");
+	for (int level = 0; level < m_hiZLevels; level++)
+	{
+		int width = (m_traceWidth >> level > 1) ? m_traceWidth >> level : 1;
+		int height = (m_traceHeight >> level > 1) ? m_traceHeight >> level : 1;
+		glTexImage2D(GL_TEXTURE_2D, level, GL_R32F, width, height, 0, GL_RED, GL_FLOAT, NULL);
+	}
+	// the trace fetches exact texels of exact levels
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_hiZLevels - 1);
+
+	bool bComplete = true;
+	m_hiZFramebuffers.resize(m_hiZLevels, 0);
+	glGenFramebuffers(m_hiZLevels, m_hiZFramebuffers.data());
+	for (int level = 0; level < m_hiZLevels; level++)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_hiZFramebuffers[level]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_hiZTexture, level);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			bComplete = false;
+		}
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (bComplete == false)
+	{
+		std::cout << "Failed to create the depth pyramid " << m_traceWidth << "x" << m_traceHeight << std::endl;
+		return false;
+	}
+
+	std::cout << "INFO: Reflection trace " << m_traceWidth << "x" << m_traceHeight
+		<< " with " << m_hiZLevels << " depth pyramid levels" << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  BuildHiZ()
+ *
+ *  This method is used for filling the depth pyramid.  Level
+ *  0 takes the nearest depth of each 2x2 block of the scene
+ *  depth, and every further level does the same with the
+ *  level above it.  While a level is written, the texture is
+ *  limited to the level being read so there is no feedback.
+ ***********************************************************/
+void ScreenSpaceReflections::BuildHiZ(GLuint depthTexture)
+{
+	PipelineState::Bind(m_hiZState);
+
+	// the frame graph has bound level 0 for the pass
+	m_pHiZShader->setVec2Value("sourceSize", glm::vec2(m_width, m_height));
+	FullscreenPass::BindTexture(m_pHiZShader, "sourceTexture", 0, depthTexture);
+	FullscreenPass::Draw();
+
+	FullscreenPass::BindTexture(m_pHiZShader, "sourceTexture", 0, m_hiZTexture);
+	for (int level = 1; level < m_hiZLevels; level++)
+	{
+		int sourceWidth = (m_traceWidth >> (level - 1) > 1) ? m_traceWidth >> (level - 1) : 1;
+		int sourceHeight = (m_traceHeight >> (level - 1) > 1) ? m_traceHeight >> (level - 1) : 1;
+		int width = (m_traceWidth >> level > 1) ? m_traceWidth >> level : 1;
+		int height = (m_traceHeight >> level > 1) ? m_traceHeight >> level : 1;
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_hiZFramebuffers[level]);
+		glViewport(0, 0, width, height);
+		m_pHiZShader->setVec2Value("sourceSize", glm::vec2(sourceWidth, sourceHeight));
+		FullscreenPass::Draw();
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_hiZLevels - 1);
+}
+
+/***********************************************************
+ *  UpdateIterationBudget()
+ *
+ *  This method is used for reading back the time of the last
+ *  timed trace, once the GPU has it, and moving the iteration
+ *  count towards the trace budget.  The result is only read
+ *  when available, so the CPU never waits on the GPU.
+ ***********************************************************/
+void ScreenSpaceReflections::UpdateIterationBudget()
+{
+	if ((m_bTracePending == false) || (m_traceQuery == 0))
+	{
+		return;
+	}
+
+	GLint bAvailable = 0;
+	glGetQueryObjectiv(m_traceQuery, GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+	if (bAvailable == 0)
+	{
+		return;
+	}
+
+	GLuint64 elapsed = 0;
+	glGetQueryObjectui64v(m_traceQuery, GL_QUERY_RESULT, &elapsed);
+	m_bTracePending = false;
+
+	float milliseconds = elapsed / 1000000.0f;
+	if (milliseconds > m_settings.traceBudget)
+	{
+		m_iterations -= g_IterationStep;
+	}
+	else if (milliseconds < m_settings.traceBudget * 0.75f)
+	{
+		m_iterations += g_IterationStep;
+	}
+
+	if (m_iterations < m_settings.minIterations)
+	{
+		m_iterations = m_settings.minIterations;
+	}
+	if (m_iterations > m_settings.maxIterations)
+	{
+		m_iterations = m_settings.maxIterations;
+	}
+}
@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////////
+// screenspacereflections.h
+// ============
+// manage the screen space reflections of the reflective materials - a
+// hierarchical depth trace at half resolution with temporal reuse
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "PipelineState.h"
+#include "ViewManager.h"
+#include "FrameGraph.h"
+#include "RenderTargetPool.h"
+
+#include <vector>
+
+/***********************************************************
+ *  ScreenSpaceReflections
+ *
+ *  This class contains the code for adding the reflection
+ *  passes to the frame graph.  Rays are only traced for the
+ *  pixels whose material has a reflectivity, at half
+ *  resolution, through a min depth pyramid.  The result is
+ *  accumulated over frames and blended over the HDR color.
+ *  The trace is timed on the GPU and its iteration count is
+ *  adjusted to stay inside a fixed budget.
+ ***********************************************************/
+class ScreenSpaceReflections
+{
+public:
+	// constructor
+	ScreenSpaceReflections(ViewManager* pViewManager);
+	// destructor
+	~ScreenSpaceReflections();
+
+	// adjustable settings for the reflections
+	struct SSR_SETTINGS
+	{
+		bool bEnabled;
+		// longest reflected ray in world units
+		float maxDistance;
+		// depth a hit may lie behind the surface it hit
+		float thickness;
+		// share of last frame's result kept each frame
+		float historyWeight;
+		// GPU time the trace may take in milliseconds
+		float traceBudget;
+		// range the iteration count is adjusted within
+		int minIterations;
+		int maxIterations;
+	};
+
+	// load the shaders and create the persistent targets
+	bool Create(int width, int height, RenderTargetPool* pRenderTargetPool);
+	// free the shaders and OpenGL objects
+	void Destroy();
+
+	// add the passes that trace the reflections and blend them
+	// over the resolved HDR color
+	void AddPasses(FrameGraph* pFrameGraph, int hdrColor, int sceneDepth, int sceneSurface);
+
+	// settings used by the next call to AddPasses()
+	SSR_SETTINGS m_settings;
+
+private:
+	// pointer to the view manager for the camera matrices
+	ViewManager* m_pViewManager;
+	// pool that owns the history targets
+	RenderTargetPool* m_pRenderTargetPool;
+	// frame graph the passes were added to
+	FrameGraph* m_pFrameGraph;
+	// one shader program per pass
+	ShaderManager* m_pHiZShader;
+	ShaderManager* m_pTraceShader;
+	ShaderManager* m_pTemporalShader;
+	ShaderManager* m_pCompositeShader;
+	// the state each pass draws with
+	PipelineState m_hiZState;
+	PipelineState m_traceState;
+	PipelineState m_temporalState;
+	PipelineState m_compositeState;
+	// min depth pyramid at the trace resolution
+	GLuint m_hiZTexture;
+	std::vector<GLuint> m_hiZFramebuffers;
+	int m_hiZLevels;
+	// reflection history, read and written on alternate frames
+	int m_historyTargets[2];
+	int m_historyIndex;
+	bool m_bHistoryValid;
+	// GPU timer for the trace pass
+	GLuint m_traceQuery;
+	bool m_bTracePending;
+	int m_iterations;
+	// size of the scene and of the trace in pixels
+	int m_width;
+	int m_height;
+	int m_traceWidth;
+	int m_traceHeight;
+
+	// create the depth pyramid texture with a framebuffer per level
+	bool CreateHiZ();
+	// fill the depth pyramid from the resolved scene depth
+	void BuildHiZ(GLuint depthTexture);
+	// read the last trace time and adjust the iteration count
+	void UpdateIterationBudget();
+};
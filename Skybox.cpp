@@ -0,0 +1,283 @@
+///////////////////////////////////////////////////////////////////////////////
+// skybox.cpp
+// ============
+// manage the sky cubemap seen through the window - drawn after the scene at
+// the far plane, so only the uncovered pixels are shaded
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Skybox.h"
+#include "GLDebug.h"
+
+#include "stb_image.h"
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// declare the global variables and helper functions
+namespace
+{
+	const char* g_SkyVertexShader = "../../Utilities/shaders/skyboxVertexShader.glsl";
+	const char* g_SkyFragmentShader = "../../Utilities/shaders/skyboxFragmentShader.glsl";
+
+	// the sky is bound on the first unit of the fullscreen passes,
+	// which no scene sampler uses
+	const int g_SkyTextureUnit = 16;
+	// face images in GL_TEXTURE_CUBE_MAP_POSITIVE_X order
+	const char* g_FaceNames[6] = { "px.jpg", "nx.jpg", "py.jpg", "ny.jpg", "pz.jpg", "nz.jpg" };
+	// edge of a generated face in texels
+	const int g_GeneratedSize = 128;
+
+	/***********************************************************
+	 *  GetSkyFormat()
+	 *
+	 *  Returns the internal format for the sky faces - DXT1
+	 *  where the driver supports it, at an eighth of RGB8.
+	 ***********************************************************/
+	GLenum GetSkyFormat()
+	{
+		if (GLEW_EXT_texture_compression_s3tc == true)
+		{
+			return(GL_COMPRESSED_RGB_S3TC_DXT1_EXT);
+		}
+		return(GL_RGB8);
+	}
+}
+
+/***********************************************************
+ *  Skybox()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Skybox::Skybox()
+{
+	m_pSkyShader = NULL;
+	m_cubemapID = 0;
+	m_skyVAO = 0;
+	m_previousViewProjection = glm::mat4(1.0f);
+	m_bPreviousValid = false;
+}
+
+/***********************************************************
+ *  ~Skybox()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+Skybox::~Skybox()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for loading the sky shader and the
+ *  cubemap.  The six images in the passed in folder are used
+ *  when they all load, otherwise a sky is generated.
+ ***********************************************************/
+bool Skybox::Create(const char* faceFolder, glm::vec3 sunDirection)
+{
+	m_pSkyShader = new ShaderManager();
+	m_pSkyShader->LoadShaders(g_SkyVertexShader, g_SkyFragmentShader);
+	GL_DEBUG_LABEL_SHADER(m_pSkyShader, "sky");
+	// the triangle sits on the far plane, so it passes the depth
+	// test only where the scene left the cleared depth
+	m_skyState = PipelineState(PipelineState::GetProgram(m_pSkyShader), PipelineState::BLEND_NONE,
+		PipelineState::DEPTH_LEQUAL, false);
+
+	glGenVertexArrays(1, &m_skyVAO);
+	glGenTextures(1, &m_cubemapID);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, m_cubemapID);
+	GL_DEBUG_LABEL(GL_TEXTURE, m_cubemapID, "sky");
+
+	if (LoadFaces(faceFolder) == false)
+	{
+		std::cout << "INFO: No sky images in " << faceFolder << ", generating the sky" << std::endl;
+		GenerateSky(glm::normalize(sunDirection));
+	}
+
+	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shader program, the
+ *  cubemap and the vertex array.
+ ***********************************************************/
+void Skybox::Destroy()
+{
+	if (NULL != m_pSkyShader)
+	{
+		delete m_pSkyShader;
+		m_pSkyShader = NULL;
+	}
+	if (m_cubemapID != 0)
+	{
+		glDeleteTextures(1, &m_cubemapID);
+		m_cubemapID = 0;
+	}
+	if (m_skyVAO != 0)
+	{
+		glDeleteVertexArrays(1, &m_skyVAO);
+		m_skyVAO = 0;
+	}
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used for drawing the sky into the pixels
+ *  the scene left at the far plane.  Depth writes are off, so
+ *  the sky never hides anything drawn after it.
+ ***********************************************************/
+void Skybox::Draw(const glm::mat4& view, const glm::mat4& projection)
+{
+	if ((NULL == m_pSkyShader) || (m_cubemapID == 0))
+	{
+		return;
+	}
+
+	// only the rotation of the camera moves the sky
+	glm::mat4 rotation = glm::mat4(glm::mat3(view));
+	glm::mat4 viewProjection = projection * rotation;
+	if (m_bPreviousValid == false)
+	{
+		m_previousViewProjection = viewProjection;
+		m_bPreviousValid = true;
+	}
+
+	PipelineState::Bind(m_skyState);
+	m_pSkyShader->setMat4Value("inverseViewProjection", glm::inverse(viewProjection));
+	m_pSkyShader->setMat4Value("previousViewProjection", m_previousViewProjection);
+	m_previousViewProjection = viewProjection;
+	glActiveTexture(GL_TEXTURE0 + g_SkyTextureUnit);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, m_cubemapID);
+	m_pSkyShader->setSampler2DValue("skyTexture", g_SkyTextureUnit);
+
+	glBindVertexArray(m_skyVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  LoadFaces()
+ *
+ *  This method is used for loading the six face images into
+ *  the cubemap.  Cubemap faces start at the top left, so the
+ *  images are not flipped like the scene textures.
+ ***********************************************************/
+bool Skybox::LoadFaces(const char* faceFolder)
+{
+	bool bLoaded = true;
+
+	stbi_set_flip_vertically_on_load(false);
+	for (int face = 0; (face < 6) && (bLoaded == true); face++)
+	{
+		std::string filename = std::string(faceFolder) + g_FaceNames[face];
+		int width = 0;
+		int height = 0;
+		int colorChannels = 0;
+		unsigned char* image = stbi_load(filename.c_str(), &width, &height, &colorChannels, 3);
+		if ((NULL == image) || (width != height))
+		{
+			bLoaded = false;
+		}
+		else
+		{
+			UploadFace(face, width, image);
+		}
+		if (NULL != image)
+		{
+			stbi_image_free(image);
+		}
+	}
+	stbi_set_flip_vertically_on_load(true);
+
+	return(bLoaded);
+}
+
+/***********************************************************
+ *  GenerateSky()
+ *
+ *  This method is used for filling the cubemap with a clear
+ *  day sky - a gradient from the horizon to the zenith, a
+ *  glow and disc around the sun, and a dim ground below the
+ *  horizon.
+ ***********************************************************/
+void Skybox::GenerateSky(glm::vec3 sunDirection)
+{
+	const glm::vec3 zenithColor(0.25f, 0.45f, 0.85f);
+	const glm::vec3 horizonColor(0.75f, 0.85f, 0.95f);
+	const glm::vec3 groundColor(0.3f, 0.32f, 0.28f);
+	const glm::vec3 sunColor(1.0f, 0.95f, 0.85f);
+
+	std::vector<unsigned char> pixels((size_t)g_GeneratedSize * g_GeneratedSize * 3);
+	for (int face = 0; face < 6; face++)
+	{
+		for (int y = 0; y < g_GeneratedSize; y++)
+		{
+			for (int x = 0; x < g_GeneratedSize; x++)
+			{
+				float u = ((x + 0.5f) / g_GeneratedSize) * 2.0f - 1.0f;
+				float v = ((y + 0.5f) / g_GeneratedSize) * 2.0f - 1.0f;
+				glm::vec3 direction;
+				switch (face)
+				{
+				case 0: direction = glm::vec3(1.0f, -v, -u); break;
+				case 1: direction = glm::vec3(-1.0f, -v, u); break;
+				case 2: direction = glm::vec3(u, 1.0f, v); break;
+				case 3: direction = glm::vec3(u, -1.0f, -v); break;
+				case 4: direction = glm::vec3(u, -v, 1.0f); break;
+				default: direction = glm::vec3(-u, -v, -1.0f); break;
+				}
+				direction = glm::normalize(direction);
+
+				glm::vec3 color;
+				if (direction.y >= 0.0f)
+				{
+					float height = std::pow(direction.y, 0.5f);
+					color = glm::mix(horizonColor, zenithColor, height);
+				}
+				else
+				{
+					float depth = std::fmin(-direction.y * 8.0f, 1.0f);
+					color = glm::mix(horizonColor, groundColor, depth);
+				}
+
+				float sun = std::fmax(glm::dot(direction, sunDirection), 0.0f);
+				color += sunColor * (0.35f * std::pow(sun, 64.0f) + ((sun > 0.9995f) ? 1.0f : 0.0f));
+
+				unsigned char* pixel = &pixels[((size_t)y * g_GeneratedSize + x) * 3];
+				for (int c = 0; c < 3; c++)
+				{
+					pixel[c] = (unsigned char)(std::fmin(color[c], 1.0f) * 255.0f + 0.5f);
+				}
+			}
+		}
+		UploadFace(face, g_GeneratedSize, pixels.data());
+	}
+}
+
+/***********************************************************
+ *  UploadFace()
+ *
+ *  This method is used for uploading an RGB face into the
+ *  bound cubemap.  The driver compresses it on upload.
+ ***********************************************************/
+void Skybox::UploadFace(int face, int size, const unsigned char* pixels)
+{
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GetSkyFormat(),
+		size, size, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
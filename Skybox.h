@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////////////////////////////////
+// skybox.h
+// ============
+// manage the sky cubemap seen through the window - drawn after the scene at
+// the far plane, so only the uncovered pixels are shaded
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "PipelineState.h"
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  Skybox
+ *
+ *  This class contains the code for the outdoor view.  The
+ *  sky is a compressed cubemap loaded from six images, or
+ *  generated from a sky gradient and a sun when the images
+ *  are missing.  It is drawn as one triangle at the far plane
+ *  with a LEQUAL depth test after everything else, so the
+ *  early depth test skips every pixel the room covers.
+ ***********************************************************/
+class Skybox
+{
+public:
+	// constructor
+	Skybox();
+	// destructor
+	~Skybox();
+
+	// load the shader and the cubemap, the sun direction is used
+	// when the sky has to be generated
+	bool Create(const char* faceFolder, glm::vec3 sunDirection);
+	// free the shader and OpenGL objects
+	void Destroy();
+
+	// draw the sky behind the scene in the bound framebuffer
+	void Draw(const glm::mat4& view, const glm::mat4& projection);
+
+private:
+	// shader program for the sky
+	ShaderManager* m_pSkyShader;
+	PipelineState m_skyState;
+	// the sky cubemap
+	GLuint m_cubemapID;
+	// empty vertex array for the far plane triangle
+	GLuint m_skyVAO;
+	// rotation-only view-projection of the last draw, for the motion
+	// vectors, and whether there was a last draw
+	glm::mat4 m_previousViewProjection;
+	bool m_bPreviousValid;
+
+	// load the six face images, false if any is missing
+	bool LoadFaces(const char* faceFolder);
+	// fill the cubemap with a generated sky
+	void GenerateSky(glm::vec3 sunDirection);
+	// upload one face with the compressed format
+	void UploadFace(int face, int size, const unsigned char* pixels);
+};
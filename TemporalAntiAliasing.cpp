@@ -0,0 +1,188 @@
+///////////////////////////////////////////////////////////////////////////////
+// temporalantialiasing.cpp
+// ============
+// manage the temporal anti-aliasing - a jittered projection whose samples
+// are accumulated over frames along the per pixel motion vectors
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TemporalAntiAliasing.h"
+#include "FullscreenPass.h"
+
+#include <iostream>
+
+// declare the global variables and helper functions
+namespace
+{
+	// the history is HDR, before the bloom and the tonemap
+	const GLenum g_HistoryFormat = GL_RGBA16F;
+
+	/***********************************************************
+	 *  Halton()
+	 *
+	 *  Returns the index'th value of the Halton sequence in the
+	 *  passed in base.  Consecutive values of bases 2 and 3 fill
+	 *  the pixel evenly at any count.
+	 ***********************************************************/
+	float Halton(int index, int base)
+	{
+		float result = 0.0f;
+		float fraction = 1.0f / base;
+		while (index > 0)
+		{
+			result += (index % base) * fraction;
+			index /= base;
+			fraction /= base;
+		}
+		return(result);
+	}
+}
+
+/***********************************************************
+ *  TemporalAntiAliasing()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TemporalAntiAliasing::TemporalAntiAliasing(ViewManager* pViewManager)
+{
+	m_pViewManager = pViewManager;
+	m_pRenderTargetPool = NULL;
+	m_pFrameGraph = NULL;
+	m_pResolveShader = NULL;
+	m_historyTargets[0] = -1;
+	m_historyTargets[1] = -1;
+	m_historyIndex = 0;
+	m_bHistoryValid = false;
+	m_frameIndex = 0;
+	m_width = 0;
+	m_height = 0;
+
+	m_settings.bEnabled = true;
+	m_settings.currentWeight = 0.1f;
+	m_settings.jitterPhases = 8;
+}
+
+/***********************************************************
+ *  ~TemporalAntiAliasing()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TemporalAntiAliasing::~TemporalAntiAliasing()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for loading the accumulation shader
+ *  and acquiring the two history targets.
+ ***********************************************************/
+bool TemporalAntiAliasing::Create(int width, int height, RenderTargetPool* pRenderTargetPool)
+{
+	if (NULL == pRenderTargetPool)
+	{
+		return false;
+	}
+
+	m_pRenderTargetPool = pRenderTargetPool;
+	m_width = width;
+	m_height = height;
+
+	m_pResolveShader = FullscreenPass::LoadShader("taaFragmentShader.glsl");
+	m_resolveState = FullscreenPass::GetState(m_pResolveShader);
+
+	// the history is held for the whole run, so it is acquired once
+	// and never handed back to the pool
+	for (int i = 0; i < 2; i++)
+	{
+		m_historyTargets[i] = m_pRenderTargetPool->AcquireTarget(m_width, m_height, g_HistoryFormat);
+		if (m_historyTargets[i] < 0)
+		{
+			std::cout << "Failed to create the anti-aliasing history" << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shader program and
+ *  handing the history targets back.
+ ***********************************************************/
+void TemporalAntiAliasing::Destroy()
+{
+	if (NULL != m_pResolveShader)
+	{
+		delete m_pResolveShader;
+		m_pResolveShader = NULL;
+	}
+
+	// the pool frees the history targets when it is destroyed
+	if (NULL != m_pRenderTargetPool)
+	{
+		m_pRenderTargetPool->ReleaseTarget(m_historyTargets[0]);
+		m_pRenderTargetPool->ReleaseTarget(m_historyTargets[1]);
+		m_pRenderTargetPool = NULL;
+	}
+	m_historyTargets[0] = -1;
+	m_historyTargets[1] = -1;
+	m_bHistoryValid = false;
+	m_pFrameGraph = NULL;
+}
+
+/***********************************************************
+ *  AddPasses()
+ *
+ *  This method is used for setting the jitter of the frame
+ *  and adding the accumulation pass.  The graph is built
+ *  before it runs, so the jitter set here is the one the
+ *  opaque pass renders with.
+ ***********************************************************/
+int TemporalAntiAliasing::AddPasses(FrameGraph* pFrameGraph, int hdrColor, int sceneVelocity, int sceneDepth)
+{
+	if ((NULL == pFrameGraph) || (m_settings.bEnabled == false) || (NULL == m_pResolveShader))
+	{
+		m_pViewManager->SetProjectionJitter(glm::vec2(0.0f));
+		m_bHistoryValid = false;
+		return(hdrColor);
+	}
+	m_pFrameGraph = pFrameGraph;
+
+	// Halton(2, 3) offsets within the pixel, as a shift of the
+	// normalized device coordinates
+	m_frameIndex = (m_frameIndex % m_settings.jitterPhases) + 1;
+	glm::vec2 jitter = glm::vec2(Halton(m_frameIndex, 2) - 0.5f, Halton(m_frameIndex, 3) - 0.5f);
+	m_pViewManager->SetProjectionJitter(glm::vec2(jitter.x * 2.0f / m_width, jitter.y * 2.0f / m_height));
+
+	int readIndex = m_historyIndex;
+	int writeIndex = 1 - m_historyIndex;
+	m_historyIndex = writeIndex;
+	int historyRead = pFrameGraph->ImportTarget("taaHistoryRead",
+		m_pRenderTargetPool->GetFramebuffer(m_historyTargets[readIndex]),
+		m_pRenderTargetPool->GetTexture(m_historyTargets[readIndex]),
+		m_width, m_height);
+	int historyWrite = pFrameGraph->ImportTarget("taaHistoryWrite",
+		m_pRenderTargetPool->GetFramebuffer(m_historyTargets[writeIndex]),
+		m_pRenderTargetPool->GetTexture(m_historyTargets[writeIndex]),
+		m_width, m_height);
+
+	pFrameGraph->AddPass("taa", { hdrColor, sceneVelocity, sceneDepth, historyRead }, { historyWrite },
+		[this, hdrColor, sceneVelocity, sceneDepth, historyRead]()
+		{
+			PipelineState::Bind(m_resolveState);
+			m_pResolveShader->setBoolValue("bHistoryValid", m_bHistoryValid);
+			m_pResolveShader->setFloatValue("currentWeight", m_settings.currentWeight);
+			FullscreenPass::BindTexture(m_pResolveShader, "currentTexture", 0, m_pFrameGraph->GetTexture(hdrColor));
+			FullscreenPass::BindTexture(m_pResolveShader, "historyTexture", 1, m_pFrameGraph->GetTexture(historyRead));
+			FullscreenPass::BindTexture(m_pResolveShader, "velocityTexture", 2, m_pFrameGraph->GetTexture(sceneVelocity));
+			FullscreenPass::BindTexture(m_pResolveShader, "depthTexture", 3, m_pFrameGraph->GetTexture(sceneDepth));
+			FullscreenPass::Draw();
+
+			m_bHistoryValid = true;
+		});
+
+	return(historyWrite);
+}
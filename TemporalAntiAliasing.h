@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////////////
+// temporalantialiasing.h
+// ============
+// manage the temporal anti-aliasing - a jittered projection whose samples
+// are accumulated over frames along the per pixel motion vectors
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "PipelineState.h"
+#include "ViewManager.h"
+#include "FrameGraph.h"
+#include "RenderTargetPool.h"
+
+/***********************************************************
+ *  TemporalAntiAliasing
+ *
+ *  This class contains the code for spreading the pixel
+ *  samples over time.  Every frame the projection is shifted
+ *  by a different sub-pixel offset, and the frame is blended
+ *  into a history that follows the scene through the motion
+ *  vectors of the velocity target.  The history is clipped to
+ *  the colors around the pixel this frame, so it cannot keep
+ *  what is no longer there.
+ ***********************************************************/
+class TemporalAntiAliasing
+{
+public:
+	// constructor
+	TemporalAntiAliasing(ViewManager* pViewManager);
+	// destructor
+	~TemporalAntiAliasing();
+
+	// adjustable settings for the anti-aliasing
+	struct TAA_SETTINGS
+	{
+		bool bEnabled;
+		// share of this frame in the result, the rest is history
+		float currentWeight;
+		// number of jitter offsets before the pattern repeats
+		int jitterPhases;
+	};
+
+	// load the shader and create the history targets
+	bool Create(int width, int height, RenderTargetPool* pRenderTargetPool);
+	// free the shader
+	void Destroy();
+
+	// set this frame's jitter and add the pass that blends the HDR
+	// color into the history.  Returns the anti-aliased target, or
+	// the HDR color when the pass is off.
+	int AddPasses(FrameGraph* pFrameGraph, int hdrColor, int sceneVelocity, int sceneDepth);
+
+	// settings used by the next call to AddPasses()
+	TAA_SETTINGS m_settings;
+
+private:
+	// pointer to the view manager that applies the jitter
+	ViewManager* m_pViewManager;
+	// pool that owns the history targets
+	RenderTargetPool* m_pRenderTargetPool;
+	// frame graph the pass was added to
+	FrameGraph* m_pFrameGraph;
+	// shader program for the accumulation
+	ShaderManager* m_pResolveShader;
+	// the state each pass draws with
+	PipelineState m_resolveState;
+	// accumulated color, read and written on alternate frames
+	int m_historyTargets[2];
+	int m_historyIndex;
+	bool m_bHistoryValid;
+	// position in the jitter pattern
+	int m_frameIndex;
+	// size of the scene in pixels
+	int m_width;
+	int m_height;
+};
@@ -0,0 +1,428 @@
+///////////////////////////////////////////////////////////////////////////////
+// tessellatedshapes.cpp
+// ============
+// manage the tessellated curved shapes - coarse patches refined by the GPU
+// tessellator to a density that follows the size of the object on screen
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TessellatedShapes.h"
+#include "GLDebug.h"
+#include "PipelineState.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// declare the global variables and helper functions
+namespace
+{
+	const char* g_TessellateVertexShader = "../../Utilities/shaders/tessellateVertexShader.glsl";
+	const char* g_TessellateControlShader = "../../Utilities/shaders/tessellateControlShader.glsl";
+	const char* g_TessellateEvaluationShader = "../../Utilities/shaders/tessellateEvaluationShader.glsl";
+
+	// surface a patch lies on, must match the evaluation shader
+	const float g_PartSphere = 0.0f;
+	const float g_PartCylinderSide = 1.0f;
+	const float g_PartCylinderTop = 2.0f;
+	const float g_PartCylinderBottom = 3.0f;
+	// patches around every shape, and the corners of each patch
+	const int g_PatchColumns = 8;
+	const int g_PatchCorners = 4;
+	// position, normal and texture coordinate of a captured vertex
+	const int g_FloatsPerVertex = 8;
+	// the most segments the control shader splits an edge into, and
+	// the longest patch edge of any shape - the unit height and
+	// radius of the cylinder, the other edges are eighths of a circle
+	const float g_MaxSegments = 64.0f;
+	const float g_MaxEdgeLength = 1.0f;
+	// density levels are powers of two of the pixels per unit, so a
+	// shape is captured again only when its size on screen doubles
+	// or halves
+	const int g_MinLevel = 2;
+	const int g_MaxLevel = 10;
+	// density for draws without a camera, such as the captures
+	const int g_DefaultLevel = 6;
+
+	/***********************************************************
+	 *  CompileStage()
+	 *
+	 *  Returns a compiled shader of the passed in stage from the
+	 *  passed in file, or 0 with the error printed.
+	 ***********************************************************/
+	GLuint CompileStage(const char* filename, GLenum stage)
+	{
+		std::ifstream file(filename);
+		if (!file)
+		{
+			std::cout << "Could not open " << filename << std::endl;
+			return(0);
+		}
+		std::stringstream source;
+		source << file.rdbuf();
+		std::string code = source.str();
+		const char* codeText = code.c_str();
+
+		GLuint shaderID = glCreateShader(stage);
+		glShaderSource(shaderID, 1, &codeText, NULL);
+		glCompileShader(shaderID);
+		GLint status = 0;
+		glGetShaderiv(shaderID, GL_COMPILE_STATUS, &status);
+		if (status == GL_FALSE)
+		{
+			char infoLog[1024];
+			glGetShaderInfoLog(shaderID, sizeof(infoLog), NULL, infoLog);
+			std::cout << "ERROR: " << filename << " compile failed\n" << infoLog << std::endl;
+			glDeleteShader(shaderID);
+			return(0);
+		}
+		return(shaderID);
+	}
+
+	/***********************************************************
+	 *  AddPatchRow()
+	 *
+	 *  Adds a ring of patches around the shape between the two
+	 *  passed in v values.  The corners of each patch go around
+	 *  it in the order the control shader expects.
+	 ***********************************************************/
+	void AddPatchRow(std::vector<float>& corners, float v0, float v1, float part)
+	{
+		for (int column = 0; column < g_PatchColumns; column++)
+		{
+			float u0 = (float)column / g_PatchColumns;
+			float u1 = (float)(column + 1) / g_PatchColumns;
+			float patch[12] = {
+				u0, v0, part,
+				u1, v0, part,
+				u1, v1, part,
+				u0, v1, part };
+			corners.insert(corners.end(), patch, patch + 12);
+		}
+	}
+}
+
+/***********************************************************
+ *  TessellatedShapes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TessellatedShapes::TessellatedShapes()
+{
+	m_programID = 0;
+	m_bDeferCaptures = false;
+	m_patchVAO = 0;
+	m_patchVBO = 0;
+	for (int i = 0; i < SHAPE_COUNT; i++)
+	{
+		m_patchFirst[i] = 0;
+		m_patchCount[i] = 0;
+	}
+
+	m_settings.bEnabled = true;
+	m_settings.segmentPixels = 6.0f;
+}
+
+/***********************************************************
+ *  ~TessellatedShapes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TessellatedShapes::~TessellatedShapes()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for building the tessellation program
+ *  and the patches.  The tessellation stages and the draws
+ *  from transform feedback objects need OpenGL 4.0, so on the
+ *  3.3 context of macOS nothing is built and the basic meshes
+ *  are drawn instead.
+ ***********************************************************/
+bool TessellatedShapes::Create()
+{
+	if ((GLEW_VERSION_4_0 == false) &&
+		((GLEW_ARB_tessellation_shader == false) || (GLEW_ARB_transform_feedback2 == false)))
+	{
+		std::cout << "INFO: No tessellation shaders, curved shapes use the basic meshes" << std::endl;
+		return false;
+	}
+
+	GLuint vertexID = CompileStage(g_TessellateVertexShader, GL_VERTEX_SHADER);
+	GLuint controlID = CompileStage(g_TessellateControlShader, GL_TESS_CONTROL_SHADER);
+	GLuint evaluationID = CompileStage(g_TessellateEvaluationShader, GL_TESS_EVALUATION_SHADER);
+	if ((vertexID == 0) || (controlID == 0) || (evaluationID == 0))
+	{
+		glDeleteShader(vertexID);
+		glDeleteShader(controlID);
+		glDeleteShader(evaluationID);
+		return false;
+	}
+
+	m_programID = glCreateProgram();
+	glAttachShader(m_programID, vertexID);
+	glAttachShader(m_programID, controlID);
+	glAttachShader(m_programID, evaluationID);
+	const char* varyings[] = { "tessellatedPosition", "tessellatedNormal", "tessellatedTextureCoordinate" };
+	glTransformFeedbackVaryings(m_programID, 3, varyings, GL_INTERLEAVED_ATTRIBS);
+	glLinkProgram(m_programID);
+	glDeleteShader(vertexID);
+	glDeleteShader(controlID);
+	glDeleteShader(evaluationID);
+	GL_DEBUG_LABEL(GL_PROGRAM, m_programID, "tessellated shapes");
+	GLint status = 0;
+	glGetProgramiv(m_programID, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE)
+	{
+		char infoLog[1024];
+		glGetProgramInfoLog(m_programID, sizeof(infoLog), NULL, infoLog);
+		std::cout << "ERROR: tessellation program link failed\n" << infoLog << std::endl;
+		glDeleteProgram(m_programID);
+		m_programID = 0;
+		return false;
+	}
+
+	CreatePatches();
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the tessellation program,
+ *  the patches and the buffers of the captured meshes.
+ ***********************************************************/
+void TessellatedShapes::Destroy()
+{
+	std::map<int, TESSELLATED_MESH>::iterator it;
+	for (it = m_meshes.begin(); it != m_meshes.end(); it++)
+	{
+		glDeleteVertexArrays(1, &it->second.VAO);
+		glDeleteBuffers(1, &it->second.VBO);
+		glDeleteTransformFeedbacks(1, &it->second.feedbackID);
+	}
+	m_meshes.clear();
+
+	if (m_programID != 0)
+	{
+		glDeleteProgram(m_programID);
+		m_programID = 0;
+	}
+	if (m_patchVAO != 0)
+	{
+		glDeleteVertexArrays(1, &m_patchVAO);
+		m_patchVAO = 0;
+	}
+	if (m_patchVBO != 0)
+	{
+		glDeleteBuffers(1, &m_patchVBO);
+		m_patchVBO = 0;
+	}
+}
+
+/***********************************************************
+ *  CreatePatches()
+ *
+ *  This method is used for filling the patch buffer.  The
+ *  sphere has four rows of patches from pole to pole and the
+ *  half sphere the upper two.  The cylinder sides come before
+ *  its caps, so the sides alone are the start of its range.
+ ***********************************************************/
+void TessellatedShapes::CreatePatches()
+{
+	std::vector<float> corners;
+
+	m_patchFirst[SHAPE_SPHERE] = (int)corners.size() / 3;
+	AddPatchRow(corners, -1.0f, -0.5f, g_PartSphere);
+	AddPatchRow(corners, -0.5f, 0.0f, g_PartSphere);
+	AddPatchRow(corners, 0.0f, 0.5f, g_PartSphere);
+	AddPatchRow(corners, 0.5f, 1.0f, g_PartSphere);
+	m_patchCount[SHAPE_SPHERE] = (int)corners.size() / 3 - m_patchFirst[SHAPE_SPHERE];
+
+	m_patchFirst[SHAPE_HALF_SPHERE] = (int)corners.size() / 3;
+	AddPatchRow(corners, 0.0f, 0.5f, g_PartSphere);
+	AddPatchRow(corners, 0.5f, 1.0f, g_PartSphere);
+	m_patchCount[SHAPE_HALF_SPHERE] = (int)corners.size() / 3 - m_patchFirst[SHAPE_HALF_SPHERE];
+
+	m_patchFirst[SHAPE_CYLINDER] = (int)corners.size() / 3;
+	m_patchFirst[SHAPE_CYLINDER_SIDES] = m_patchFirst[SHAPE_CYLINDER];
+	AddPatchRow(corners, 0.0f, 1.0f, g_PartCylinderSide);
+	m_patchCount[SHAPE_CYLINDER_SIDES] = (int)corners.size() / 3 - m_patchFirst[SHAPE_CYLINDER_SIDES];
+	AddPatchRow(corners, 0.0f, 1.0f, g_PartCylinderTop);
+	AddPatchRow(corners, 0.0f, 1.0f, g_PartCylinderBottom);
+	m_patchCount[SHAPE_CYLINDER] = (int)corners.size() / 3 - m_patchFirst[SHAPE_CYLINDER];
+
+	glGenVertexArrays(1, &m_patchVAO);
+	glGenBuffers(1, &m_patchVBO);
+	glBindVertexArray(m_patchVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_patchVBO);
+	GL_DEBUG_LABEL(GL_BUFFER, m_patchVBO, "tessellation patches");
+	glBufferData(GL_ARRAY_BUFFER, corners.size() * sizeof(float), corners.data(), GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used for drawing a shape with the current
+ *  shader.  The pixels per unit pick a density level, and the
+ *  shape is captured the first time it is drawn at that
+ *  level; otherwise the cached copy is drawn as is.  Without
+ *  the tessellation program, and for a deferred capture until
+ *  CapturePending(), the basic mesh is drawn.
+ ***********************************************************/
+void TessellatedShapes::Draw(SHAPE_TYPE shape, float pixelsPerUnit, std::function<void()> drawMesh)
+{
+	if ((m_programID == 0) || (m_settings.bEnabled == false) ||
+		(shape < 0) || (shape >= SHAPE_COUNT))
+	{
+		drawMesh();
+		return;
+	}
+
+	int level = g_DefaultLevel;
+	if (pixelsPerUnit > 0.0f)
+	{
+		level = (int)std::floor(std::log2(pixelsPerUnit) + 0.5f);
+	}
+	level = (level < g_MinLevel) ? g_MinLevel : ((level > g_MaxLevel) ? g_MaxLevel : level);
+
+	int key = (int)shape * (g_MaxLevel + 1) + level;
+	std::map<int, TESSELLATED_MESH>::iterator it = m_meshes.find(key);
+	if (it == m_meshes.end())
+	{
+		TESSELLATED_MESH mesh;
+		mesh.VAO = 0;
+		mesh.VBO = 0;
+		mesh.feedbackID = 0;
+		mesh.bCaptured = false;
+		AllocateMesh(mesh, shape, m_settings.segmentPixels / (float)(1 << level));
+		if (m_bDeferCaptures == false)
+		{
+			Capture(mesh, shape);
+		}
+		it = m_meshes.insert(std::make_pair(key, mesh)).first;
+	}
+
+	if (it->second.bCaptured == false)
+	{
+		drawMesh();
+		return;
+	}
+
+	glBindVertexArray(it->second.VAO);
+	glDrawTransformFeedback(GL_TRIANGLES, it->second.feedbackID);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DeferCaptures()
+ *
+ *  This method is used for leaving the captures of new levels
+ *  to CapturePending() while a conditional render is active.
+ *  A capture it drops would leave the mesh empty for good.
+ ***********************************************************/
+void TessellatedShapes::DeferCaptures(bool bDefer)
+{
+	m_bDeferCaptures = bDefer;
+}
+
+/***********************************************************
+ *  CapturePending()
+ *
+ *  This method is used for capturing the levels the draws
+ *  deferred, so they are tessellated from the next draw on.
+ ***********************************************************/
+void TessellatedShapes::CapturePending()
+{
+	std::map<int, TESSELLATED_MESH>::iterator it;
+	for (it = m_meshes.begin(); it != m_meshes.end(); it++)
+	{
+		if (it->second.bCaptured == false)
+		{
+			Capture(it->second, (SHAPE_TYPE)(it->first / (g_MaxLevel + 1)));
+		}
+	}
+}
+
+/***********************************************************
+ *  Capture()
+ *
+ *  This method is used for tessellating the patches of the
+ *  shape into the mesh buffer, with rasterization off.  The
+ *  segment length is the target length in pixels over the
+ *  pixels per unit of the level, so every edge gets as many
+ *  segments as it is long on screen.  The count of captured
+ *  vertices stays in the transform feedback object for the
+ *  draws, so the capture never waits for the GPU.
+ ***********************************************************/
+void TessellatedShapes::Capture(TESSELLATED_MESH& mesh, SHAPE_TYPE shape)
+{
+	// no fragments, the vertices only go into the buffer
+	PipelineState saved = PipelineState::GetCurrent();
+	PipelineState::Bind(PipelineState(m_programID, PipelineState::BLEND_NONE, PipelineState::DEPTH_OFF,
+		true, PipelineState::CULL_NONE, PipelineState::RASTER_DISCARD));
+	glUniform1f(glGetUniformLocation(m_programID, "segmentLength"), mesh.segmentLength);
+	glPatchParameteri(GL_PATCH_VERTICES, g_PatchCorners);
+
+	// the buffer binding is part of the transform feedback object
+	glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, mesh.feedbackID);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, mesh.VBO);
+	glBeginTransformFeedback(GL_TRIANGLES);
+	glBindVertexArray(m_patchVAO);
+	glDrawArrays(GL_PATCHES, m_patchFirst[shape], m_patchCount[shape]);
+	glBindVertexArray(0);
+	glEndTransformFeedback();
+	glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+	mesh.bCaptured = true;
+
+	PipelineState::Bind(saved);
+}
+
+/***********************************************************
+ *  AllocateMesh()
+ *
+ *  This method is used for creating the buffer of a captured
+ *  mesh, the transform feedback object that captures into it,
+ *  and the vertex array that draws it with the scene shader's
+ *  position, normal and texture coordinate attributes.  Every
+ *  edge of a patch gets at most as many segments as the
+ *  longest edge, and a quad patch with N segments on each
+ *  edge has at most 2 * N * N triangles.
+ ***********************************************************/
+void TessellatedShapes::AllocateMesh(TESSELLATED_MESH& mesh, SHAPE_TYPE shape, float segmentLength)
+{
+	glGenVertexArrays(1, &mesh.VAO);
+	glGenBuffers(1, &mesh.VBO);
+	glGenTransformFeedbacks(1, &mesh.feedbackID);
+	mesh.segmentLength = segmentLength;
+
+	float segments = std::ceil(g_MaxEdgeLength / segmentLength);
+	segments = (segments < 1.0f) ? 1.0f : ((segments > g_MaxSegments) ? g_MaxSegments : segments);
+	// the range of the shape counts patch corners, not patches
+	int patches = m_patchCount[shape] / g_PatchCorners;
+	int capacity = patches * 6 * (int)segments * (int)segments;
+
+	glBindVertexArray(mesh.VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+	GL_DEBUG_LABEL(GL_BUFFER, mesh.VBO, "tessellated mesh");
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)capacity * g_FloatsPerVertex * sizeof(float), NULL, GL_STATIC_DRAW);
+	GLsizei stride = g_FloatsPerVertex * sizeof(float);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// tessellatedshapes.h
+// ============
+// manage the tessellated curved shapes - coarse patches refined by the GPU
+// tessellator to a density that follows the size of the object on screen
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <functional>
+#include <map>
+
+/***********************************************************
+ *  TessellatedShapes
+ *
+ *  This class contains the code for drawing the curved basic
+ *  shapes at a density that fits their size on screen.  Each
+ *  shape is a few dozen patches whose corners are points on
+ *  the surface.  The control shader splits every patch edge
+ *  into segments of a target length in pixels, and the
+ *  evaluation shader places the new vertices on the exact
+ *  surface.  Like the deformed meshes, the result is captured
+ *  with transform feedback and drawn with the scene shader,
+ *  and it is only captured again for a new density level.
+ *  The draws read the triangle count from the transform
+ *  feedback object on the GPU, so nothing waits for it.
+ ***********************************************************/
+class TessellatedShapes
+{
+public:
+	// constructor
+	TessellatedShapes();
+	// destructor
+	~TessellatedShapes();
+
+	// the shapes with a tessellated version, all unit sized like
+	// the basic meshes
+	enum SHAPE_TYPE
+	{
+		SHAPE_SPHERE = 0,
+		// upper half of the sphere, without a cap
+		SHAPE_HALF_SPHERE = 1,
+		// sides with the top and bottom caps
+		SHAPE_CYLINDER = 2,
+		SHAPE_CYLINDER_SIDES = 3,
+		SHAPE_COUNT = 4
+	};
+
+	// adjustable settings for the tessellation
+	struct TESSELLATION_SETTINGS
+	{
+		bool bEnabled;
+		// length of one segment of a patch edge on screen
+		float segmentPixels;
+	};
+
+	// build the tessellation program and the patches, false when the
+	// context has no tessellation stages
+	bool Create();
+	// free the program, the patches and every cached mesh
+	void Destroy();
+
+	// draw the shape at the density for pixelsPerUnit, the screen
+	// size of one unit of the mesh.  drawMesh draws the fixed
+	// basic mesh and is used when there is no tessellation.
+	void Draw(SHAPE_TYPE shape, float pixelsPerUnit, std::function<void()> drawMesh);
+	// while set, a new level is left for CapturePending() instead of
+	// captured in the draw - a conditional render could drop it
+	void DeferCaptures(bool bDefer);
+	// capture the levels deferred by the last draws
+	void CapturePending();
+
+	// settings used by the next call to Draw()
+	TESSELLATION_SETTINGS m_settings;
+
+private:
+	// captured triangles of one shape at one density level
+	struct TESSELLATED_MESH
+	{
+		GLuint VAO;
+		GLuint VBO;
+		// holds the number of vertices captured into the buffer
+		GLuint feedbackID;
+		// target segment length the buffer was sized for
+		float segmentLength;
+		bool bCaptured;
+	};
+
+	// transform feedback program with the tessellation stages
+	GLuint m_programID;
+	// patch corners of every shape, and the range of each shape
+	GLuint m_patchVAO;
+	GLuint m_patchVBO;
+	int m_patchFirst[SHAPE_COUNT];
+	int m_patchCount[SHAPE_COUNT];
+	// captured meshes by shape and density level
+	std::map<int, TESSELLATED_MESH> m_meshes;
+	bool m_bDeferCaptures;
+
+	// build the patch corners of every shape into one buffer
+	void CreatePatches();
+	// capture the shape into the mesh buffer
+	void Capture(TESSELLATED_MESH& mesh, SHAPE_TYPE shape);
+	// create the buffer of a captured mesh, with room for every
+	// triangle the shape can have at the segment length
+	void AllocateMesh(TESSELLATED_MESH& mesh, SHAPE_TYPE shape, float segmentLength);
+};
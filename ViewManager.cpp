@@ -23,6 +23,8 @@ namespace
 	const int WINDOW_HEIGHT = 800;
 	const char* g_ViewName = "view";
 	const char* g_ProjectionName = "projection";
+	const char* g_ViewProjectionName = "currentViewProjection";
+	const char* g_PreviousViewProjectionName = "previousViewProjection";
 
 	// camera object used for viewing and interacting with
 	// the 3D scene
@@ -53,6 +55,10 @@ ViewManager::ViewManager(
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
 	m_pWindow = NULL;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_previousViewProjection = glm::mat4(1.0f);
+	m_projectionJitter = glm::vec2(0.0f);
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.5f, 5.5f, 20.0f);
@@ -122,10 +128,6 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	// Scroll events
 	glfwSetScrollCallback(window, ScrollCallback);
 
-	// enable blending for supporting tranparent rendering
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
 	m_pWindow = window;
 
 	return(window);
@@ -282,14 +284,85 @@ void ViewManager::PrepareSceneView()
 	// define the current projection matrix
 	projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
 
+	// keep last frame's matrices for the passes that reproject
+	m_previousViewProjection = m_projectionMatrix * m_viewMatrix;
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+
 	// if the shader manager object is valid
 	if (NULL != m_pShaderManager)
 	{
 		// set the view matrix into the shader for proper rendering
 		m_pShaderManager->setMat4Value(g_ViewName, view);
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
+		// the rasterized projection is shifted by the jitter, which
+		// moves clip x and y by the jitter times w
+		glm::mat4 jitteredProjection = projection;
+		jitteredProjection[2][0] -= m_projectionJitter.x;
+		jitteredProjection[2][1] -= m_projectionJitter.y;
+		// set the projection matrix into the shader for proper rendering
+		m_pShaderManager->setMat4Value(g_ProjectionName, jitteredProjection);
+		// unjittered matrices of this frame and the last one for the
+		// motion vectors
+		m_pShaderManager->setMat4Value(g_ViewProjectionName, projection * view);
+		m_pShaderManager->setMat4Value(g_PreviousViewProjectionName, m_previousViewProjection);
 		// set the view position of the camera into the shader for proper rendering
 		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
 	}
-}
\ No newline at end of file
+}
+
+/***********************************************************
+ *  GetViewMatrix()
+ *
+ *  This method is used for getting the view matrix set by
+ *  the last call to PrepareSceneView().
+ ***********************************************************/
+glm::mat4 ViewManager::GetViewMatrix() const
+{
+	return(m_viewMatrix);
+}
+
+/***********************************************************
+ *  GetProjectionMatrix()
+ *
+ *  This method is used for getting the projection matrix set
+ *  by the last call to PrepareSceneView().
+ ***********************************************************/
+glm::mat4 ViewManager::GetProjectionMatrix() const
+{
+	return(m_projectionMatrix);
+}
+
+/***********************************************************
+ *  GetPreviousViewProjection()
+ *
+ *  This method is used for getting the view-projection
+ *  matrix of the frame before the last PrepareSceneView(),
+ *  which passes use to reproject into last frame's images.
+ ***********************************************************/
+glm::mat4 ViewManager::GetPreviousViewProjection() const
+{
+	return(m_previousViewProjection);
+}
+
+/***********************************************************
+ *  SetProjectionJitter()
+ *
+ *  This method is used for setting the sub-pixel shift of
+ *  the projection that the next PrepareSceneView() sends to
+ *  the scene shader.
+ ***********************************************************/
+void ViewManager::SetProjectionJitter(glm::vec2 jitter)
+{
+	m_projectionJitter = jitter;
+}
+
+/***********************************************************
+ *  GetProjectionJitter()
+ *
+ *  This method is used for getting the sub-pixel shift, so
+ *  geometry drawn with other shaders lines up with the scene.
+ ***********************************************************/
+glm::vec2 ViewManager::GetProjectionJitter() const
+{
+	return(m_projectionJitter);
+}
@@ -42,4 +42,24 @@ public:
 	
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+
+	// matrices set by the last call to PrepareSceneView()
+	glm::mat4 GetViewMatrix() const;
+	glm::mat4 GetProjectionMatrix() const;
+	// view-projection matrix of the frame before the last one
+	glm::mat4 GetPreviousViewProjection() const;
+
+	// sub-pixel shift of the scene projection in normalized device
+	// coordinates, used by the temporal anti-aliasing
+	void SetProjectionJitter(glm::vec2 jitter);
+	glm::vec2 GetProjectionJitter() const;
+
+private:
+	// matrices of the current and the previous frame
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	glm::mat4 m_previousViewProjection;
+	// shift applied to the projection sent to the scene shader only,
+	// the matrices above stay unjittered for the reprojections
+	glm::vec2 m_projectionJitter;
 };
\ No newline at end of file
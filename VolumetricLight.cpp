@@ -0,0 +1,421 @@
+///////////////////////////////////////////////////////////////////////////////
+// volumetriclight.cpp
+// ============
+// manage the light shafts of the window light - a low resolution ray march
+// through the light's shadow map with temporal reuse and depth aware upsample
+///////////////////////////////////////////////////////////////////////////////
+
+#include "VolumetricLight.h"
+#include "FullscreenPass.h"
+#include "GLDebug.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+
+// declare the global variables
+namespace
+{
+	// the march and its history are a quarter of the scene size
+	const int g_MarchDivisor = 4;
+	// scattered light in R, distance to the surface in G for the
+	// reprojection and the upsample
+	const GLenum g_ScatteringFormat = GL_RG16F;
+	// edge of the light's depth map in texels
+	const int g_ShadowSize = 1024;
+	// the window is well inside the light's frustum
+	const float g_ShadowFieldOfView = 90.0f;
+	const float g_ShadowNear = 1.0f;
+	const float g_ShadowFar = 300.0f;
+	// steps added or removed per budget adjustment
+	const int g_StepStep = 2;
+}
+
+/***********************************************************
+ *  VolumetricLight()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+VolumetricLight::VolumetricLight(ViewManager* pViewManager, ShaderManager* pSceneShader)
+{
+	m_pViewManager = pViewManager;
+	m_pSceneShader = pSceneShader;
+	m_pRenderTargetPool = NULL;
+	m_pFrameGraph = NULL;
+	m_pMarchShader = NULL;
+	m_pTemporalShader = NULL;
+	m_pCompositeShader = NULL;
+	m_shadowTexture = 0;
+	m_shadowFramebuffer = 0;
+	m_lightViewProjection = glm::mat4(1.0f);
+	m_lightPosition = glm::vec3(0.0f);
+	m_historyTargets[0] = -1;
+	m_historyTargets[1] = -1;
+	m_historyIndex = 0;
+	m_bHistoryValid = false;
+	m_frameIndex = 0;
+	m_marchQuery = 0;
+	m_bMarchPending = false;
+	m_width = 0;
+	m_height = 0;
+	m_marchWidth = 0;
+	m_marchHeight = 0;
+
+	// faint warm haze - the shafts should only show where the
+	// window light crosses a dark background
+	m_settings.bEnabled = true;
+	m_settings.density = 0.004f;
+	m_settings.anisotropy = 0.6f;
+	m_settings.lightColor = glm::vec3(1.0f, 0.95f, 0.85f);
+	m_settings.maxDistance = 80.0f;
+	m_settings.historyWeight = 0.9f;
+	m_settings.marchBudget = 0.5f;
+	m_settings.minSteps = 8;
+	m_settings.maxSteps = 48;
+	m_steps = 24;
+}
+
+/***********************************************************
+ *  ~VolumetricLight()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+VolumetricLight::~VolumetricLight()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for loading the shaders, creating the
+ *  history targets and rendering the light's depth map.  The
+ *  room does not move, so the depth map is rendered once.
+ ***********************************************************/
+bool VolumetricLight::Create(int width, int height, RenderTargetPool* pRenderTargetPool,
+	glm::vec3 lightPosition, glm::vec3 lightTarget, std::function<void()> renderScene)
+{
+	if ((NULL == pRenderTargetPool) || (NULL == m_pSceneShader))
+	{
+		return false;
+	}
+
+	m_pRenderTargetPool = pRenderTargetPool;
+	m_width = width;
+	m_height = height;
+	m_marchWidth = (width / g_MarchDivisor > 1) ? width / g_MarchDivisor : 1;
+	m_marchHeight = (height / g_MarchDivisor > 1) ? height / g_MarchDivisor : 1;
+	m_lightPosition = lightPosition;
+
+	m_pMarchShader = FullscreenPass::LoadShader("volumetricMarchFragmentShader.glsl");
+	m_pTemporalShader = FullscreenPass::LoadShader("reprojectTemporalFragmentShader.glsl");
+	m_pCompositeShader = FullscreenPass::LoadShader("volumetricCompositeFragmentShader.glsl");
+	m_marchState = FullscreenPass::GetState(m_pMarchShader);
+	m_temporalState = FullscreenPass::GetState(m_pTemporalShader);
+	m_compositeState = FullscreenPass::GetState(m_pCompositeShader, PipelineState::BLEND_ADDITIVE);
+
+	if (RenderShadowMap(lightTarget, renderScene) == false)
+	{
+		return false;
+	}
+
+	// the history is held for the whole run, so it is acquired once
+	// and never handed back to the pool
+	for (int i = 0; i < 2; i++)
+	{
+		m_historyTargets[i] = m_pRenderTargetPool->AcquireTarget(
+			m_marchWidth, m_marchHeight, g_ScatteringFormat);
+		if (m_historyTargets[i] < 0)
+		{
+			std::cout << "Failed to create the light shaft history" << std::endl;
+			return false;
+		}
+	}
+
+	glGenQueries(1, &m_marchQuery);
+
+	std::cout << "INFO: Light shaft march " << m_marchWidth << "x" << m_marchHeight << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shader programs, the
+ *  light's depth map and the timer query.
+ ***********************************************************/
+void VolumetricLight::Destroy()
+{
+	if (NULL != m_pMarchShader)
+	{
+		delete m_pMarchShader;
+		m_pMarchShader = NULL;
+	}
+	if (NULL != m_pTemporalShader)
+	{
+		delete m_pTemporalShader;
+		m_pTemporalShader = NULL;
+	}
+	if (NULL != m_pCompositeShader)
+	{
+		delete m_pCompositeShader;
+		m_pCompositeShader = NULL;
+	}
+
+	if (m_shadowFramebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_shadowFramebuffer);
+		m_shadowFramebuffer = 0;
+	}
+	if (m_shadowTexture != 0)
+	{
+		glDeleteTextures(1, &m_shadowTexture);
+		m_shadowTexture = 0;
+	}
+	if (m_marchQuery != 0)
+	{
+		glDeleteQueries(1, &m_marchQuery);
+		m_marchQuery = 0;
+	}
+
+	// the pool frees the history targets when it is destroyed
+	if (NULL != m_pRenderTargetPool)
+	{
+		m_pRenderTargetPool->ReleaseTarget(m_historyTargets[0]);
+		m_pRenderTargetPool->ReleaseTarget(m_historyTargets[1]);
+		m_pRenderTargetPool = NULL;
+	}
+	m_historyTargets[0] = -1;
+	m_historyTargets[1] = -1;
+	m_bHistoryValid = false;
+	m_pFrameGraph = NULL;
+}
+
+/***********************************************************
+ *  AddPasses()
+ *
+ *  This method is used for adding the light shaft passes to
+ *  the frame graph:
+ *    1. quarter resolution march through the light's depth map
+ *    2. temporal accumulation into the history
+ *    3. depth aware upsample added to the HDR color
+ ***********************************************************/
+void VolumetricLight::AddPasses(FrameGraph* pFrameGraph, int hdrColor, int sceneDepth)
+{
+	if ((NULL == pFrameGraph) || (m_settings.bEnabled == false) || (m_shadowTexture == 0))
+	{
+		m_bHistoryValid = false;
+		return;
+	}
+	m_pFrameGraph = pFrameGraph;
+	m_frameIndex++;
+
+	UpdateStepBudget();
+
+	int readIndex = m_historyIndex;
+	int writeIndex = 1 - m_historyIndex;
+	m_historyIndex = writeIndex;
+	int historyRead = pFrameGraph->ImportTarget("shaftHistoryRead",
+		m_pRenderTargetPool->GetFramebuffer(m_historyTargets[readIndex]),
+		m_pRenderTargetPool->GetTexture(m_historyTargets[readIndex]),
+		m_marchWidth, m_marchHeight);
+	int historyWrite = pFrameGraph->ImportTarget("shaftHistoryWrite",
+		m_pRenderTargetPool->GetFramebuffer(m_historyTargets[writeIndex]),
+		m_pRenderTargetPool->GetTexture(m_historyTargets[writeIndex]),
+		m_marchWidth, m_marchHeight);
+	int marchColor = pFrameGraph->CreateTarget("shaftMarch", m_marchWidth, m_marchHeight,
+		g_ScatteringFormat);
+
+	pFrameGraph->AddPass("shaftMarch", { sceneDepth }, { marchColor },
+		[this, sceneDepth]()
+		{
+			glm::mat4 view = m_pViewManager->GetViewMatrix();
+			glm::mat4 inverseView = glm::inverse(view);
+			// the depth was rasterized with the jittered projection
+			glm::mat4 projection = m_pViewManager->GetProjectionMatrix();
+			glm::vec2 jitter = m_pViewManager->GetProjectionJitter();
+			projection[2][0] -= jitter.x;
+			projection[2][1] -= jitter.y;
+			glm::mat4 viewProjection = projection * view;
+
+			PipelineState::Bind(m_marchState);
+			m_pMarchShader->setMat4Value("inverseViewProjection", glm::inverse(viewProjection));
+			m_pMarchShader->setMat4Value("lightViewProjection", m_lightViewProjection);
+			m_pMarchShader->setVec3Value("viewPosition", glm::vec3(inverseView[3].x, inverseView[3].y, inverseView[3].z));
+			m_pMarchShader->setVec3Value("lightPosition", m_lightPosition);
+			m_pMarchShader->setIntValue("stepCount", m_steps);
+			m_pMarchShader->setIntValue("frameIndex", m_frameIndex);
+			m_pMarchShader->setFloatValue("maxDistance", m_settings.maxDistance);
+			m_pMarchShader->setFloatValue("density", m_settings.density);
+			m_pMarchShader->setFloatValue("anisotropy", m_settings.anisotropy);
+			FullscreenPass::BindTexture(m_pMarchShader, "depthTexture", 0, m_pFrameGraph->GetTexture(sceneDepth));
+			FullscreenPass::BindTexture(m_pMarchShader, "shadowTexture", 1, m_shadowTexture);
+
+			// only one timing is in flight, so reading it back never stalls
+			bool bTimed = (m_bMarchPending == false);
+			if (bTimed == true)
+			{
+				glBeginQuery(GL_TIME_ELAPSED, m_marchQuery);
+			}
+			FullscreenPass::Draw();
+			if (bTimed == true)
+			{
+				glEndQuery(GL_TIME_ELAPSED);
+				m_bMarchPending = true;
+			}
+		});
+
+	pFrameGraph->AddPass("shaftTemporal", { marchColor, historyRead }, { historyWrite },
+		[this, marchColor, historyRead]()
+		{
+			glm::mat4 view = m_pViewManager->GetViewMatrix();
+			glm::mat4 inverseView = glm::inverse(view);
+			glm::mat4 projection = m_pViewManager->GetProjectionMatrix();
+			glm::vec2 jitter = m_pViewManager->GetProjectionJitter();
+			projection[2][0] -= jitter.x;
+			projection[2][1] -= jitter.y;
+			glm::mat4 viewProjection = projection * view;
+
+			PipelineState::Bind(m_temporalState);
+			m_pTemporalShader->setMat4Value("inverseViewProjection", glm::inverse(viewProjection));
+			m_pTemporalShader->setMat4Value("previousViewProjection", m_pViewManager->GetPreviousViewProjection());
+			m_pTemporalShader->setVec3Value("viewPosition", glm::vec3(inverseView[3].x, inverseView[3].y, inverseView[3].z));
+			m_pTemporalShader->setBoolValue("bHistoryValid", m_bHistoryValid);
+			m_pTemporalShader->setFloatValue("historyWeight", m_settings.historyWeight);
+			FullscreenPass::BindTexture(m_pTemporalShader, "currentTexture", 0, m_pFrameGraph->GetTexture(marchColor));
+			FullscreenPass::BindTexture(m_pTemporalShader, "historyTexture", 1, m_pFrameGraph->GetTexture(historyRead));
+			FullscreenPass::Draw();
+
+			m_bHistoryValid = true;
+		});
+
+	// the shafts are added to the HDR color
+	pFrameGraph->AddPass("shaftComposite", { historyWrite, sceneDepth, hdrColor }, { hdrColor },
+		[this, historyWrite, sceneDepth]()
+		{
+			glm::mat4 view = m_pViewManager->GetViewMatrix();
+			glm::mat4 inverseView = glm::inverse(view);
+			glm::mat4 projection = m_pViewManager->GetProjectionMatrix();
+			glm::vec2 jitter = m_pViewManager->GetProjectionJitter();
+			projection[2][0] -= jitter.x;
+			projection[2][1] -= jitter.y;
+			glm::mat4 viewProjection = projection * view;
+
+			PipelineState::Bind(m_compositeState);
+			m_pCompositeShader->setMat4Value("inverseViewProjection", glm::inverse(viewProjection));
+			m_pCompositeShader->setVec3Value("viewPosition", glm::vec3(inverseView[3].x, inverseView[3].y, inverseView[3].z));
+			m_pCompositeShader->setVec3Value("lightColor", m_settings.lightColor);
+			FullscreenPass::BindTexture(m_pCompositeShader, "scatteringTexture", 0, m_pFrameGraph->GetTexture(historyWrite));
+			FullscreenPass::BindTexture(m_pCompositeShader, "depthTexture", 1, m_pFrameGraph->GetTexture(sceneDepth));
+			FullscreenPass::Draw();
+		});
+}
+
+/***********************************************************
+ *  RenderShadowMap()
+ *
+ *  This method is used for rendering the scene depth as the
+ *  window light sees it.  The scene shader draws the room
+ *  with only a depth attachment, and bShadowPass makes it
+ *  skip the lighting and cut the window glass out instead of
+ *  using alpha to coverage, which a single sample target
+ *  does not have.  The depth map is sampled with hardware
+ *  comparison and filtering.
+ ***********************************************************/
+bool VolumetricLight::RenderShadowMap(glm::vec3 lightTarget, std::function<void()> renderScene)
+{
+	glGenTextures(1, &m_shadowTexture);
+	glBindTexture(GL_TEXTURE_2D, m_shadowTexture);
+	GL_DEBUG_LABEL(GL_TEXTURE, m_shadowTexture, "window light depth");
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, g_ShadowSize, g_ShadowSize, 0,
+		GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffers(1, &m_shadowFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_shadowFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_shadowTexture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Failed to create the window light depth map" << std::endl;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		return false;
+	}
+
+	glm::mat4 view = glm::lookAt(m_lightPosition, lightTarget, glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(g_ShadowFieldOfView), 1.0f, g_ShadowNear, g_ShadowFar);
+	m_lightViewProjection = projection * view;
+
+	glViewport(0, 0, g_ShadowSize, g_ShadowSize);
+	PipelineState::Bind(PipelineState(PipelineState::GetProgram(m_pSceneShader),
+		PipelineState::BLEND_NONE, PipelineState::DEPTH_LESS, true, PipelineState::CULL_BACK));
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	m_pSceneShader->setMat4Value("view", view);
+	m_pSceneShader->setMat4Value("projection", projection);
+	m_pSceneShader->setVec3Value("viewPosition", m_lightPosition);
+	m_pSceneShader->setBoolValue("bShadowPass", true);
+	if (renderScene)
+	{
+		renderScene();
+	}
+	m_pSceneShader->setBoolValue("bShadowPass", false);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	return true;
+}
+
+/***********************************************************
+ *  UpdateStepBudget()
+ *
+ *  This method is used for reading back the time of the last
+ *  timed march, once the GPU has it, and moving the step
+ *  count towards the march budget.  The result is only read
+ *  when available, so the CPU never waits on the GPU.
+ ***********************************************************/
+void VolumetricLight::UpdateStepBudget()
+{
+	if ((m_bMarchPending == false) || (m_marchQuery == 0))
+	{
+		return;
+	}
+
+	GLint bAvailable = 0;
+	glGetQueryObjectiv(m_marchQuery, GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+	if (bAvailable == 0)
+	{
+		return;
+	}
+
+	GLuint64 elapsed = 0;
+	glGetQueryObjectui64v(m_marchQuery, GL_QUERY_RESULT, &elapsed);
+	m_bMarchPending = false;
+
+	float milliseconds = elapsed / 1000000.0f;
+	if (milliseconds > m_settings.marchBudget)
+	{
+		m_steps -= g_StepStep;
+	}
+	else if (milliseconds < m_settings.marchBudget * 0.75f)
+	{
+		m_steps += g_StepStep;
+	}
+
+	if (m_steps < m_settings.minSteps)
+	{
+		m_steps = m_settings.minSteps;
+	}
+	if (m_steps > m_settings.maxSteps)
+	{
+		m_steps = m_settings.maxSteps;
+	}
+}
@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////
+// volumetriclight.h
+// ============
+// manage the light shafts of the window light - a low resolution ray march
+// through the light's shadow map with temporal reuse and depth aware upsample
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "PipelineState.h"
+#include "ViewManager.h"
+#include "FrameGraph.h"
+#include "RenderTargetPool.h"
+
+#include <glm/glm.hpp>
+
+#include <functional>
+
+/***********************************************************
+ *  VolumetricLight
+ *
+ *  This class contains the code for the light scattered by
+ *  the air between the window and the camera.  The window
+ *  light renders a depth map once, through the window.  Each
+ *  frame, view rays are marched at a quarter of the scene
+ *  size, summing the lit steps with a jittered start that
+ *  the history averages out.  The result is upsampled with
+ *  depth weights so the shafts stop at object edges, and is
+ *  added to the HDR color.  The march is timed on the GPU and
+ *  its step count is adjusted to stay inside a fixed budget.
+ ***********************************************************/
+class VolumetricLight
+{
+public:
+	// constructor
+	VolumetricLight(ViewManager* pViewManager, ShaderManager* pSceneShader);
+	// destructor
+	~VolumetricLight();
+
+	// adjustable settings for the light shafts
+	struct VOLUMETRIC_SETTINGS
+	{
+		bool bEnabled;
+		// scattering per world unit of air
+		float density;
+		// Henyey-Greenstein g, above 0 scatters towards the camera
+		// when looking into the light
+		float anisotropy;
+		// color and strength of the scattered light
+		glm::vec3 lightColor;
+		// longest marched ray in world units
+		float maxDistance;
+		// share of last frame's result kept each frame
+		float historyWeight;
+		// GPU time the march may take in milliseconds
+		float marchBudget;
+		// range the step count is adjusted within
+		int minSteps;
+		int maxSteps;
+	};
+
+	// load the shaders, create the persistent targets and render the
+	// light's depth map from lightPosition towards lightTarget with
+	// the scene drawn by renderScene
+	bool Create(int width, int height, RenderTargetPool* pRenderTargetPool,
+		glm::vec3 lightPosition, glm::vec3 lightTarget, std::function<void()> renderScene);
+	// free the shaders and OpenGL objects
+	void Destroy();
+
+	// add the passes that march the shafts and add them to the
+	// resolved HDR color
+	void AddPasses(FrameGraph* pFrameGraph, int hdrColor, int sceneDepth);
+
+	// settings used by the next call to AddPasses()
+	VOLUMETRIC_SETTINGS m_settings;
+
+private:
+	// pointer to the view manager for the camera matrices
+	ViewManager* m_pViewManager;
+	// pointer to the scene shader used for the light's depth map
+	ShaderManager* m_pSceneShader;
+	// pool that owns the history targets
+	RenderTargetPool* m_pRenderTargetPool;
+	// frame graph the passes were added to
+	FrameGraph* m_pFrameGraph;
+	// one shader program per pass
+	ShaderManager* m_pMarchShader;
+	ShaderManager* m_pTemporalShader;
+	ShaderManager* m_pCompositeShader;
+	// the state each pass draws with
+	PipelineState m_marchState;
+	PipelineState m_temporalState;
+	PipelineState m_compositeState;
+	// depth map of the window light
+	GLuint m_shadowTexture;
+	GLuint m_shadowFramebuffer;
+	glm::mat4 m_lightViewProjection;
+	glm::vec3 m_lightPosition;
+	// scattering history, read and written on alternate frames
+	int m_historyTargets[2];
+	int m_historyIndex;
+	bool m_bHistoryValid;
+	// changes the jitter of the march start every frame
+	int m_frameIndex;
+	// GPU timer for the march pass
+	GLuint m_marchQuery;
+	bool m_bMarchPending;
+	int m_steps;
+	// size of the scene and of the march in pixels
+	int m_width;
+	int m_height;
+	int m_marchWidth;
+	int m_marchHeight;
+
+	// render the scene depth as seen from the light
+	bool RenderShadowMap(glm::vec3 lightTarget, std::function<void()> renderScene);
+	// read the last march time and adjust the step count
+	void UpdateStepBudget();
+};
@@ -0,0 +1,47 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 fragmentTextureCoordinate;
+
+uniform sampler2D sourceTexture;
+uniform vec2 sourceTexelSize;
+uniform bool bPrefilter = false;
+uniform float bloomThreshold = 1.0;
+uniform float bloomSoftKnee = 0.5;
+
+// keeps only the light above the threshold, with a soft knee so
+// the window light fades into the bloom instead of popping
+vec3 Prefilter(vec3 color)
+{
+    float brightness = max(color.r, max(color.g, color.b));
+    float knee = bloomThreshold * bloomSoftKnee + 0.00001;
+    float soft = clamp(brightness - bloomThreshold + knee, 0.0, 2.0 * knee);
+    soft = (soft * soft) / (4.0 * knee);
+    float contribution = max(soft, brightness - bloomThreshold) / max(brightness, 0.00001);
+    return color * contribution;
+}
+
+void main()
+{
+    // dual filter downsample - the center plus four diagonal taps
+    // placed between texels, so each tap averages four texels
+    vec2 offset = sourceTexelSize;
+    vec3 center = texture(sourceTexture, fragmentTextureCoordinate).rgb;
+    vec3 a = texture(sourceTexture, fragmentTextureCoordinate + vec2(-offset.x, -offset.y)).rgb;
+    vec3 b = texture(sourceTexture, fragmentTextureCoordinate + vec2( offset.x, -offset.y)).rgb;
+    vec3 c = texture(sourceTexture, fragmentTextureCoordinate + vec2(-offset.x,  offset.y)).rgb;
+    vec3 d = texture(sourceTexture, fragmentTextureCoordinate + vec2( offset.x,  offset.y)).rgb;
+
+    // the bright pass is folded into the first downsample, so it
+    // costs no extra fullscreen pass at full resolution
+    if (bPrefilter == true)
+    {
+        center = Prefilter(center);
+        a = Prefilter(a);
+        b = Prefilter(b);
+        c = Prefilter(c);
+        d = Prefilter(d);
+    }
+
+    fragmentColor = vec4((center * 4.0 + a + b + c + d) / 8.0, 1.0);
+}
@@ -0,0 +1,28 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 fragmentTextureCoordinate;
+
+uniform sampler2D sourceTexture;
+uniform vec2 sourceTexelSize;
+uniform float bloomRadius = 1.0;
+
+void main()
+{
+    // 3x3 tent filter on the smaller mip - the result is added on
+    // top of the next larger mip with additive blending
+    vec2 offset = sourceTexelSize * bloomRadius;
+    vec2 uv = fragmentTextureCoordinate;
+
+    vec3 color = texture(sourceTexture, uv).rgb * 4.0;
+    color += texture(sourceTexture, uv + vec2(-offset.x, 0.0)).rgb * 2.0;
+    color += texture(sourceTexture, uv + vec2( offset.x, 0.0)).rgb * 2.0;
+    color += texture(sourceTexture, uv + vec2(0.0, -offset.y)).rgb * 2.0;
+    color += texture(sourceTexture, uv + vec2(0.0,  offset.y)).rgb * 2.0;
+    color += texture(sourceTexture, uv + vec2(-offset.x, -offset.y)).rgb;
+    color += texture(sourceTexture, uv + vec2( offset.x, -offset.y)).rgb;
+    color += texture(sourceTexture, uv + vec2(-offset.x,  offset.y)).rgb;
+    color += texture(sourceTexture, uv + vec2( offset.x,  offset.y)).rgb;
+
+    fragmentColor = vec4(color / 16.0, 1.0);
+}
@@ -0,0 +1,57 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 fragmentTextureCoordinate;
+
+// what the scene shader wrote for the view, see DebugViews.h
+uniform sampler2D sceneTexture;
+uniform int debugView;
+uniform float maxOverdraw = 8.0;
+uniform float maxLightCount = 7.0;
+
+#define DEBUG_WIREFRAME 1
+#define DEBUG_OVERDRAW 2
+#define DEBUG_LIGHT_COUNT 3
+#define DEBUG_MIP_LEVEL 4
+
+// black through blue, cyan, green and yellow to red as t goes 0 to 1
+vec3 HeatColor(float t)
+{
+    const vec3 ramp[6] = vec3[6](vec3(0.0), vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 1.0),
+                                 vec3(0.0, 1.0, 0.0), vec3(1.0, 1.0, 0.0), vec3(1.0, 0.0, 0.0));
+    float x = clamp(t, 0.0, 1.0) * 5.0;
+    int i = min(int(x), 4);
+    return mix(ramp[i], ramp[i + 1], x - float(i));
+}
+
+void main()
+{
+    vec4 scene = texture(sceneTexture, fragmentTextureCoordinate);
+    vec3 color = vec3(0.0);
+
+    if (debugView == DEBUG_WIREFRAME)
+    {
+        // plain Reinhard, the grading of the post chain is left out
+        color = scene.rgb / (1.0 + scene.rgb);
+    }
+    else if (debugView == DEBUG_OVERDRAW)
+    {
+        color = HeatColor(scene.r / maxOverdraw);
+    }
+    else if (debugView == DEBUG_LIGHT_COUNT)
+    {
+        color = HeatColor(scene.r / maxLightCount);
+    }
+    else if (debugView == DEBUG_MIP_LEVEL)
+    {
+        // g is 1 on textured surfaces and 0.5 on untextured ones,
+        // the clear color leaves the background at 0.  Whole levels
+        // are banded so the steps show, magnified texels are blue.
+        if (scene.g > 0.75)
+            color = HeatColor(0.2 + 0.8 * (clamp(floor(scene.r + 0.5), -1.0, 8.0) + 1.0) / 9.0);
+        else if (scene.g > 0.25)
+            color = vec3(0.15);
+    }
+
+    fragmentColor = vec4(color, 1.0);
+}
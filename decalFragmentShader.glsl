@@ -0,0 +1,56 @@
+#version 330 core
+layout(location = 0) out vec4 fragmentColor;
+layout(location = 1) out vec4 fragmentSurface;
+
+flat in mat4 decalInverseModel;
+flat in vec3 decalAxis;
+flat in vec4 decalColor;
+// texture layer (-1 for none), bump strength
+flat in vec4 decalParams;
+
+uniform sampler2D depthTexture;
+// diffuse light that reached each pixel, stored by the scene pass
+uniform sampler2D lightingTexture;
+uniform sampler2DArray decalTextures;
+uniform mat4 inverseViewProjection;
+uniform mat4 view;
+uniform vec2 screenSize;
+
+void main()
+{
+    vec2 screenUV = gl_FragCoord.xy / screenSize;
+    float depth = texture(depthTexture, screenUV).r;
+    vec4 world = inverseViewProjection * vec4(vec3(screenUV, depth) * 2.0 - 1.0, 1.0);
+    vec3 position = world.xyz / world.w;
+    vec3 local = (decalInverseModel * vec4(position, 1.0)).xyz;
+
+    // the image lies over the box's X and Z, like the overlay layers
+    vec2 decalUV = vec2(local.x + 0.5, 0.5 - local.z);
+    bool bTextured = (decalParams.x >= 0.0);
+    vec4 image = texture(decalTextures, vec3(decalUV, max(decalParams.x, 0.0)));
+    if (bTextured == false)
+        image = vec4(1.0);
+
+    // everything that needs derivatives is done before the discard -
+    // the surface normal from the depth, then bent by the slope of
+    // the image brightness (bump mapping without a tangent frame)
+    vec3 sigmaS = dFdx(position);
+    vec3 sigmaT = dFdy(position);
+    vec3 normal = normalize(cross(sigmaS, sigmaT));
+    float height = dot(image.rgb, vec3(0.299, 0.587, 0.114)) * image.a * decalParams.y;
+    vec3 r1 = cross(sigmaT, normal);
+    vec3 r2 = cross(normal, sigmaS);
+    float det = dot(sigmaS, r1);
+    vec3 surfaceGradient = sign(det) * (dFdx(height) * r1 + dFdy(height) * r2);
+    vec3 bentNormal = normalize(abs(det) * normal - surfaceGradient);
+
+    // outside the box, or on a surface turned away from the projection
+    float facing = smoothstep(0.2, 0.5, dot(normal, decalAxis));
+    float alpha = decalColor.a * image.a * facing;
+    if (any(greaterThan(abs(local), vec3(0.5))) || (alpha <= 0.001))
+        discard;
+
+    vec3 lighting = texture(lightingTexture, screenUV).rgb;
+    fragmentColor = vec4(decalColor.rgb * image.rgb * lighting, alpha);
+    fragmentSurface = vec4(normalize(mat3(view) * bentNormal), alpha);
+}
@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec3 inVertexPosition;
+// per decal - the box transform, its inverse, color and parameters
+layout (location = 1) in mat4 inModel;
+layout (location = 5) in mat4 inInverseModel;
+layout (location = 9) in vec4 inColor;
+layout (location = 10) in vec4 inParams;
+
+flat out mat4 decalInverseModel;
+flat out vec3 decalAxis;
+flat out vec4 decalColor;
+flat out vec4 decalParams;
+
+uniform mat4 viewProjection;
+
+// draws one decal box, the fragments do the projection
+void main()
+{
+    gl_Position = viewProjection * inModel * vec4(inVertexPosition, 1.0);
+
+    decalInverseModel = inInverseModel;
+    decalAxis = normalize(inModel[1].xyz);
+    decalColor = inColor;
+    decalParams = inParams;
+}
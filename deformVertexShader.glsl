@@ -0,0 +1,91 @@
+#version 330 core
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+
+// captured by transform feedback, in object space
+out vec3 deformedPosition;
+out vec3 deformedNormal;
+out vec2 deformedTextureCoordinate;
+
+#define MAX_DEFORMERS 4
+#define DEFORM_BEND 0
+#define DEFORM_TWIST 1
+#define DEFORM_TAPER 2
+#define DEFORM_WAVE 3
+
+uniform int deformerCount = 0;
+uniform int deformerTypes[MAX_DEFORMERS];
+// the mesh axis each deformer varies along
+uniform int deformerAxes[MAX_DEFORMERS];
+// amount, frequency, phase
+uniform vec3 deformerParams[MAX_DEFORMERS];
+
+// applies every deformer in order.  Each one works on the position
+// along its axis and the two coordinates across it (a and b).
+vec3 Deform(vec3 position)
+{
+    for (int i = 0; i < deformerCount; i++)
+    {
+        int axis = deformerAxes[i];
+        int axisA = (axis + 1) % 3;
+        int axisB = (axis + 2) % 3;
+        float along = position[axis];
+        float a = position[axisA];
+        float b = position[axisB];
+        float amount = deformerParams[i].x;
+
+        if (deformerTypes[i] == DEFORM_BEND)
+        {
+            // wrap the axis around a circle of radius 1 / amount
+            if (abs(amount) > 0.0001)
+            {
+                float radius = 1.0 / amount;
+                float angle = along * amount;
+                along = (radius - a) * sin(angle);
+                a = radius - (radius - a) * cos(angle);
+            }
+        }
+        else if (deformerTypes[i] == DEFORM_TWIST)
+        {
+            float angle = along * amount;
+            float c = cos(angle);
+            float s = sin(angle);
+            float twistedA = a * c - b * s;
+            b = a * s + b * c;
+            a = twistedA;
+        }
+        else if (deformerTypes[i] == DEFORM_TAPER)
+        {
+            float scale = 1.0 + along * amount;
+            a *= scale;
+            b *= scale;
+        }
+        else if (deformerTypes[i] == DEFORM_WAVE)
+        {
+            a += amount * sin(along * deformerParams[i].y + deformerParams[i].z);
+        }
+
+        position[axis] = along;
+        position[axisA] = a;
+        position[axisB] = b;
+    }
+    return position;
+}
+
+void main()
+{
+    deformedPosition = Deform(inVertexPosition);
+
+    // the normal follows the deformation through the inverse
+    // transpose of its Jacobian, taken by finite differences
+    const float h = 0.001;
+    mat3 jacobian = mat3(
+        (Deform(inVertexPosition + vec3(h, 0.0, 0.0)) - deformedPosition) / h,
+        (Deform(inVertexPosition + vec3(0.0, h, 0.0)) - deformedPosition) / h,
+        (Deform(inVertexPosition + vec3(0.0, 0.0, h)) - deformedPosition) / h);
+    deformedNormal = normalize(transpose(inverse(jacobian)) * inVertexNormal);
+
+    deformedTextureCoordinate = inTextureCoordinate;
+    gl_Position = vec4(deformedPosition, 1.0);
+}
@@ -1,14 +1,27 @@
 #version 330 core
-out vec4 fragmentColor;
+layout(location = 0) out vec4 fragmentColor;
+// view space normal and reflectivity for screen space reflections
+layout(location = 1) out vec4 fragmentSurface;
+// diffuse light reaching the surface, so decals can be lit later
+layout(location = 2) out vec4 fragmentLighting;
+// screen movement since last frame in texture coordinates
+layout(location = 3) out vec2 fragmentVelocity;
 
 in vec3 fragmentPosition;
 in vec3 fragmentVertexNormal;
 in vec2 fragmentTextureCoordinate;
+in vec3 fragmentObjectPosition;
+in vec3 fragmentObjectNormal;
+in vec4 fragmentCurrentClip;
+in vec4 fragmentPreviousClip;
 
 struct Material {
     vec3 diffuseColor;
-    vec3 specularColor;
-    float shininess;
+    float metallic;
+    float roughness;
+    float reflectivity;
+    bool bParallax;
+    float parallaxDepth;
 }; 
 
 struct DirectionalLight {
@@ -48,175 +61,365 @@ struct SpotLight {
     bool bActive;
 };
 
+// per-fragment values shared by every light
+struct Surface {
+    vec3 normal;
+    vec3 viewDir;
+    vec3 diffuseColor;
+    vec3 F0;
+    float alpha;
+    float NdotV;
+};
+
 #define TOTAL_POINT_LIGHTS 5
+#define PI 3.14159265
+#define MAX_OVERLAYS 4
+#define DEBUG_WIREFRAME 1
+#define DEBUG_OVERDRAW 2
+#define DEBUG_LIGHT_COUNT 3
+#define DEBUG_MIP_LEVEL 4
+#define MAX_FIELD_OBJECTS 8
+#define MAX_NORMAL_LEVELS 13
 
 uniform bool bUseTexture=false;
 uniform bool bUseLighting=false;
-uniform bool bUseTextureOverlay=false;
+uniform bool bAlphaToCoverage=false;
+uniform bool bSharpenAlpha=false;
+// depth only pass for a light, no color targets are bound
+uniform bool bShadowPass=false;
+uniform bool bUseNormalMap=false;
 uniform vec4 objectColor = vec4(1.0f);
 uniform vec3 viewPosition;
+uniform mat4 view;
 uniform DirectionalLight directionalLight;
 uniform PointLight pointLights[TOTAL_POINT_LIGHTS];
 uniform SpotLight spotLight;
 uniform Material material;
 uniform sampler2D objectTexture;
-uniform sampler2D overlayTexture;
+// texture layers over the object, each projected onto the top (side 1)
+// or bottom (side -1) of the mesh, within a rect of center.xy, size.zw
+uniform int overlayCount = 0;
+uniform sampler2D overlayTextures[MAX_OVERLAYS];
+uniform vec4 overlayRects[MAX_OVERLAYS];
+uniform float overlaySides[MAX_OVERLAYS];
+// one layer can carry relief - the normal map on normalTexture bends
+// the surface under it, and its brightness is marched for parallax
+uniform int overlayReliefLayer = -1;
+uniform sampler2D overlayReliefTexture;
+uniform float overlayParallaxDepth;
+uniform sampler2D normalTexture;
+// Toksvig variance of the normals averaged into each normal map level
+uniform int normalMapLevels = 0;
+uniform float normalMapVariance[MAX_NORMAL_LEVELS];
+// specular antialiasing - screen space filter width for the normal
+// derivatives, and the most the variance can add to alpha squared
+uniform float specularAAVariance = 0.25;
+uniform float specularAAThreshold = 0.18;
+// split-sum BRDF lookup - scale and bias for F0 by NdotV and roughness
+uniform sampler2D brdfTexture;
+// room captured from a probe, one roughness per mip level
+uniform samplerCube environmentTexture;
+uniform bool bUseEnvironment=false;
+uniform float environmentMaxLevel;
 uniform vec2 UVscale = vec2(1.0f, 1.0f);
+// parallax occlusion fades out between these distances from the camera
+uniform float parallaxFadeStart = 6.0;
+uniform float parallaxFadeEnd = 12.0;
+uniform int parallaxMinSteps = 4;
+uniform int parallaxMaxSteps = 24;
+// diagnostic output in place of the lit color, see DebugViews.h
+uniform int debugView = 0;
+// distance fields of the composite objects, one brick of the atlas
+// over the bounds of each, see DistanceFields.h
+uniform bool bUseDistanceFields = false;
+uniform sampler3D distanceAtlas;
+uniform int fieldObjectCount = 0;
+uniform vec3 fieldBoundsMin[MAX_FIELD_OBJECTS];
+uniform vec3 fieldBoundsMax[MAX_FIELD_OBJECTS];
+uniform vec3 fieldAtlasOffset[MAX_FIELD_OBJECTS];
+uniform vec3 fieldBrickScale;
+// the point light with the traced shadow, and the fixed step budgets
+uniform int fieldShadowLight = 0;
+uniform int fieldShadowSteps = 16;
+uniform int fieldOcclusionSteps = 5;
+uniform float fieldShadowConeWidth = 0.08;
+uniform float fieldShadowStart = 1.0;
+uniform float fieldShadowDistance = 60.0;
+uniform float fieldOcclusionDistance = 4.0;
+uniform float fieldOcclusionIntensity = 0.8;
+
+// texture coordinate of the visible surface point, after parallax
+vec2 surfaceUV;
+// shift the parallax of the relief layer moved its coordinates by
+vec2 overlayReliefShift = vec2(0.0);
+// diffuse light summed by CalcLight(), without the surface color
+vec3 diffuseIrradiance = vec3(0.0);
+// lights that ran the full BRDF in CalcLight(), for the debug view
+int lightCount = 0;
 
 // function prototypes
-vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir);
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcDirectionalLight(DirectionalLight light, Surface surface);
+vec3 CalcPointLight(PointLight light, Surface surface, vec3 fragPos, float shadow);
+vec3 CalcSpotLight(SpotLight light, Surface surface, vec3 fragPos);
+vec3 CalcLight(Surface surface, vec3 lightDir, vec3 diffuse, vec3 specular);
+mat3 GetTangentFrame(vec3 normal, vec3 fragPos, vec2 uv);
+vec3 PerturbNormal(mat3 tbn, vec2 uv);
+vec2 ParallaxOcclusion(sampler2D heightMap, float depth, mat3 tbn, vec2 uv, vec2 dx, vec2 dy, vec3 viewDir, float fade);
+vec2 OverlayUV(vec4 rect, float side);
+// a layer only covers its rect on the face it was placed on
+float OverlayCoverage(vec2 uv, float side);
+vec3 BlendOverlay(vec3 albedo, sampler2D layer, vec4 rect, float side, vec2 shift);
+float NormalVariance(vec3 normal, bool bNormalMap);
+float SceneDistance(vec3 point);
+float DistanceFieldShadow(vec3 fragPos, vec3 lightPos);
+float DistanceFieldOcclusion(vec3 fragPos, vec3 normal);
 
 void main()
 {
-    vec4 texColor = texture(objectTexture, fragmentTextureCoordinate * UVscale);
+    fragmentVelocity = (fragmentCurrentClip.xy / fragmentCurrentClip.w -
+        fragmentPreviousClip.xy / fragmentPreviousClip.w) * 0.5;
+
+    vec3 norm = normalize(fragmentVertexNormal);
+    surfaceUV = fragmentTextureCoordinate * UVscale;
+
+    // the tangent frame is only needed for the normal map and parallax
+    bool bParallax = (bUseTexture == true) && (material.bParallax == true);
+    bool bNormalMap = (bUseTexture == true) && (bUseNormalMap == true);
+    if ((bParallax == true) || (bNormalMap == true))
+    {
+        mat3 tbn = GetTangentFrame(norm, fragmentPosition, surfaceUV);
+        vec2 dx = dFdx(surfaceUV);
+        vec2 dy = dFdy(surfaceUV);
+
+        // the ray march only runs on near surfaces
+        float fade = 1.0 - smoothstep(parallaxFadeStart, parallaxFadeEnd, distance(viewPosition, fragmentPosition));
+        if ((bParallax == true) && (fade > 0.0))
+            surfaceUV = ParallaxOcclusion(objectTexture, material.parallaxDepth, tbn, surfaceUV, dx, dy, normalize(viewPosition - fragmentPosition), fade);
+
+        if (bNormalMap == true)
+            norm = PerturbNormal(tbn, surfaceUV);
+    }
+    else if ((overlayReliefLayer >= 0) && (overlayReliefLayer < overlayCount))
+    {
+        // the relief layer has its own coordinates, and only bends the
+        // surface where the layer is drawn
+        vec4 rect = overlayRects[overlayReliefLayer];
+        float side = overlaySides[overlayReliefLayer];
+        vec2 uv = OverlayUV(rect, side);
+        mat3 tbn = GetTangentFrame(norm, fragmentPosition, uv);
+        vec2 dx = dFdx(uv);
+        vec2 dy = dFdy(uv);
+
+        float fade = 1.0 - smoothstep(parallaxFadeStart, parallaxFadeEnd, distance(viewPosition, fragmentPosition));
+        vec2 reliefUV = uv;
+        if (fade > 0.0)
+            reliefUV = ParallaxOcclusion(overlayReliefTexture, overlayParallaxDepth, tbn, uv, dx, dy, normalize(viewPosition - fragmentPosition), fade);
+
+        // sampled before masking so the mip selection stays in uniform flow
+        vec3 reliefNormal = PerturbNormal(tbn, reliefUV);
+        float coverage = OverlayCoverage(uv, side) * step(0.1, textureGrad(overlayReliefTexture, reliefUV, dx, dy).a);
+        overlayReliefShift = (reliefUV - uv) * coverage;
+        norm = normalize(mix(norm, reliefNormal, coverage));
+    }
+
+    // spread of the normals inside the pixel for the specular
+    // antialiasing, found while the flow is still uniform
+    float normalVariance = NormalVariance(norm, bNormalMap);
+
+    // the mip level needs derivatives, so it is found before any
+    // fragment can be discarded
+    float mipLevel = 0.0;
+    if (debugView == DEBUG_MIP_LEVEL)
+    {
+        vec2 texel = surfaceUV * vec2(textureSize(objectTexture, 0));
+        vec2 dx = dFdx(texel);
+        vec2 dy = dFdy(texel);
+        mipLevel = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8));
+    }
+
+    vec4 texColor = texture(objectTexture, surfaceUV);
+
+    // a single sample depth map has no coverage to turn the alpha
+    // into, so the cutout is a plain alpha test there
+    if (bShadowPass == true)
+    {
+        if ((bAlphaToCoverage == true) && (texColor.a < 0.5))
+            discard;
+        return;
+    }
     
-    // Ensure transparency is applied
-    if (texColor.a < 0.1)
+    if (bAlphaToCoverage == true)
+    {
+        // alpha becomes the MSAA coverage mask; cutout edges are
+        // sharpened to about one pixel wide so they stay crisp
+        if (bSharpenAlpha == true)
+            texColor.a = clamp((texColor.a - 0.1) / max(fwidth(texColor.a), 0.0001) + 0.5, 0.0, 1.0);
+    }
+    else if (texColor.a < 0.1)
+    {
         discard;  // Discard fully transparent fragments
+    }
     
     // Preserve alpha in the final color
     fragmentColor = texColor;  
+    fragmentSurface = vec4(normalize(mat3(view) * norm), material.reflectivity);
+    fragmentLighting = vec4(1.0);
 
     if (bUseLighting == true)
     {
-        vec3 phongResult = vec3(0.0f);
-        vec3 norm = normalize(fragmentVertexNormal);
-        vec3 viewDir = normalize(viewPosition - fragmentPosition);
+        // the overlay layers are blended over the base in order - the
+        // indices must be constant to address the sampler array
+        vec3 albedo = (bUseTexture == true) ? texColor.rgb : objectColor.rgb;
+        if (overlayCount > 0)
+            albedo = BlendOverlay(albedo, overlayTextures[0], overlayRects[0], overlaySides[0],
+                (overlayReliefLayer == 0) ? overlayReliefShift : vec2(0.0));
+        if (overlayCount > 1)
+            albedo = BlendOverlay(albedo, overlayTextures[1], overlayRects[1], overlaySides[1],
+                (overlayReliefLayer == 1) ? overlayReliefShift : vec2(0.0));
+        if (overlayCount > 2)
+            albedo = BlendOverlay(albedo, overlayTextures[2], overlayRects[2], overlaySides[2],
+                (overlayReliefLayer == 2) ? overlayReliefShift : vec2(0.0));
+        if (overlayCount > 3)
+            albedo = BlendOverlay(albedo, overlayTextures[3], overlayRects[3], overlaySides[3],
+                (overlayReliefLayer == 3) ? overlayReliefShift : vec2(0.0));
+
+        // metallic/roughness surface - metals tint their reflection
+        // and have no diffuse, everything else reflects 4% head on
+        Surface surface;
+        surface.normal = norm;
+        surface.viewDir = normalize(viewPosition - fragmentPosition);
+        vec3 baseColor = albedo * material.diffuseColor;
+        surface.diffuseColor = baseColor * (1.0 - material.metallic);
+        surface.F0 = mix(vec3(0.04), baseColor, material.metallic);
+        // the spread of the normals widens the lobe, so a highlight
+        // smaller than the pixel does not sparkle as it moves
+        float alpha = max(material.roughness * material.roughness, 0.002);
+        surface.alpha = sqrt(min(alpha * alpha + min(2.0 * normalVariance, specularAAThreshold), 1.0));
+        float roughness = sqrt(surface.alpha);
+        surface.NdotV = max(dot(surface.normal, surface.viewDir), 0.0001);
+
+        vec3 ambientLight = vec3(0.0f);
+        vec3 result = vec3(0.0f);
 
         if (directionalLight.bActive == true)
-            phongResult += CalcDirectionalLight(directionalLight, norm, viewDir);
+        {
+            ambientLight += directionalLight.ambient;
+            result += CalcDirectionalLight(directionalLight, surface);
+        }
         
         for (int i = 0; i < TOTAL_POINT_LIGHTS; i++)
         {
             if (pointLights[i].bActive == true)
-                phongResult += CalcPointLight(pointLights[i], norm, fragmentPosition, viewDir);
+            {
+                // one light is traced through the distance fields,
+                // only from the surfaces that face it
+                float shadow = 1.0;
+                if ((bUseDistanceFields == true) && (i == fieldShadowLight) &&
+                    (dot(surface.normal, pointLights[i].position - fragmentPosition) > 0.0))
+                    shadow = DistanceFieldShadow(fragmentPosition, pointLights[i].position);
+
+                ambientLight += pointLights[i].ambient;
+                result += CalcPointLight(pointLights[i], surface, fragmentPosition, shadow);
+            }
         } 
         
         if (spotLight.bActive == true)
-            phongResult += CalcSpotLight(spotLight, norm, fragmentPosition, viewDir);
+            result += CalcSpotLight(spotLight, surface, fragmentPosition);
+
+        // the objects nearby hide part of the ambient light and of
+        // the environment
+        float occlusion = 1.0;
+        if (bUseDistanceFields == true)
+            occlusion = DistanceFieldOcclusion(fragmentPosition, surface.normal);
+        ambientLight *= occlusion;
+
+        // the split-sum lookup gives how much of the environment is
+        // reflected - the prefiltered probe when there is one, else
+        // the ambient light stands in for it
+        vec2 brdf = texture(brdfTexture, vec2(surface.NdotV, roughness)).rg;
+        vec3 environment = ambientLight;
+        if (bUseEnvironment == true)
+        {
+            vec3 reflected = reflect(-surface.viewDir, surface.normal);
+            environment = textureLod(environmentTexture, reflected, roughness * environmentMaxLevel).rgb * occlusion;
+        }
+        vec3 ambientSpecular = environment * (surface.F0 * brdf.x + brdf.y);
+        result += ambientLight * albedo * (1.0 - material.metallic) + ambientSpecular;
+        fragmentLighting = vec4(ambientLight + diffuseIrradiance, 1.0);
 
         if (bUseTexture == true)
         {
-            fragmentColor = vec4(phongResult, texColor.a);  // Preserve transparency
+            fragmentColor = vec4(result, texColor.a);  // Preserve transparency
         }
         else
         {
-            fragmentColor = vec4(phongResult, objectColor.a);
+            fragmentColor = vec4(result, objectColor.a);
         }
     }
+
+    // the debug views write what they measure, and the heat map
+    // pass turns it into a color
+    if (debugView == DEBUG_WIREFRAME)
+        fragmentColor = vec4(0.2, 4.0, 0.4, 1.0);
+    else if (debugView == DEBUG_OVERDRAW)
+        fragmentColor = vec4(1.0);
+    else if (debugView == DEBUG_LIGHT_COUNT)
+        fragmentColor = vec4(float(lightCount), 0.0, 0.0, 1.0);
+    else if (debugView == DEBUG_MIP_LEVEL)
+        fragmentColor = vec4(mipLevel, (bUseTexture == true) ? 1.0 : 0.5, 0.0, 1.0);
 }
 
 
-// calculates the color when using a directional light.
-vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir)
+// calculates the light reflected towards the viewer from one light.
+// GGX distribution, Smith-Schlick visibility and Schlick fresnel -
+// no pow() calls, and the texture was read once in main().
+vec3 CalcLight(Surface surface, vec3 lightDir, vec3 diffuse, vec3 specular)
 {
-    vec3 ambient = vec3(0.0f);
-    vec3 diffuse = vec3(0.0f);
-    vec3 specular = vec3(0.0f);
-
-    vec3 lightDirection = normalize(-light.direction);
-    // diffuse shading
-    float diff = max(dot(normal, lightDirection), 0.0);
-    // specular shading
-    vec3 reflectDir = reflect(-lightDirection, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    // combine results
-    if(bUseTexture == true)
-    {
-        if(bUseTextureOverlay == true)
-        {
-            if(texture(overlayTexture, fragmentTextureCoordinate * UVscale).a > 0.1)
-            {
-                ambient = light.ambient * vec3(texture(overlayTexture, fragmentTextureCoordinate * UVscale));
-                diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(overlayTexture, fragmentTextureCoordinate * UVscale));
-                specular = light.specular * spec * material.specularColor * vec3(texture(overlayTexture, fragmentTextureCoordinate * UVscale));
-            }
-            else
-            {
-                ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinate * UVscale));
-                diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinate * UVscale));
-                specular = light.specular * spec * material.specularColor * vec3(texture(objectTexture, fragmentTextureCoordinate * UVscale));
-            }
-        }
-        else
-        {
-            ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinate * UVscale));
-            diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinate * UVscale));
-            specular = light.specular * spec * material.specularColor * vec3(texture(objectTexture, fragmentTextureCoordinate * UVscale));
-        }
-    }
-    else
-    {
-        ambient = light.ambient * vec3(objectColor);
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
-        specular = light.specular * spec * material.specularColor * vec3(objectColor);
-    }
-    
-    return (ambient + diffuse + specular);
+    float NdotL = dot(surface.normal, lightDir);
+    if (NdotL <= 0.0)
+        return vec3(0.0f);
+    lightCount++;
+
+    vec3 halfway = normalize(lightDir + surface.viewDir);
+    float NdotH = max(dot(surface.normal, halfway), 0.0);
+    float VdotH = max(dot(surface.viewDir, halfway), 0.0);
+
+    float alpha2 = surface.alpha * surface.alpha;
+    float denom = NdotH * NdotH * (alpha2 - 1.0) + 1.0;
+    float D = alpha2 / (PI * denom * denom);
+
+    float k = surface.alpha * 0.5;
+    float visibility = 0.25 / ((NdotL * (1.0 - k) + k) * (surface.NdotV * (1.0 - k) + k));
+
+    float f = 1.0 - VdotH;
+    float f2 = f * f;
+    vec3 F = surface.F0 + (1.0 - surface.F0) * (f2 * f2 * f);
+
+    // the light colors were tuned for the old model, which had no
+    // 1/PI in the diffuse term, so both terms are scaled by PI
+    diffuseIrradiance += diffuse * NdotL;
+    vec3 diffuseTerm = (1.0 - F) * surface.diffuseColor * diffuse;
+    vec3 specularTerm = F * (D * visibility * PI) * specular;
+    return (diffuseTerm + specularTerm) * NdotL;
 }
 
-// calculates the color when using a point light.
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+// calculates the color when using a directional light.
+vec3 CalcDirectionalLight(DirectionalLight light, Surface surface)
 {
-    vec3 ambient = vec3(0.0f);
-    vec3 diffuse = vec3(0.0f);
-    vec3 specular= vec3(0.0f);
-
-    vec3 lightDir = normalize(light.position - fragPos);
-    // diffuse shading
-    float diff = max(dot(normal, lightDir), 0.0);
-    // specular shading
-    vec3 reflectDir = reflect(-lightDir, normal);
-    // Calculate specular component
-    float specularComponent = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-   
-    // combine results
-    if(bUseTexture == true)
-    {
-        if(bUseTextureOverlay == true)
-        {
-            if(texture(overlayTexture, fragmentTextureCoordinate * UVscale).a > 0.1)
-            {
-                ambient = light.ambient * vec3(texture(overlayTexture, fragmentTextureCoordinate * UVscale));
-                diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(overlayTexture, fragmentTextureCoordinate * UVscale));
-            }
-            else
-            {
-                ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinate * UVscale));
-                diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinate * UVscale));
-            } 
-        }
-        else
-        {
-            ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinate * UVscale));
-            diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinate * UVscale));
-        }
-    }
-    else
-    {
-        ambient = light.ambient * vec3(objectColor);
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
-    }
-    specular = light.specular * specularComponent * material.specularColor; 
+    return CalcLight(surface, normalize(-light.direction), light.diffuse, light.specular);
+}
 
-    return (ambient + diffuse + specular);
+// calculates the color when using a point light, scaled by the share
+// of the light that is not shadowed.
+vec3 CalcPointLight(PointLight light, Surface surface, vec3 fragPos, float shadow)
+{
+    return CalcLight(surface, normalize(light.position - fragPos), light.diffuse * shadow, light.specular * shadow);
 }
 
 // calculates the color when using a spot light.
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+vec3 CalcSpotLight(SpotLight light, Surface surface, vec3 fragPos)
 {
-    vec3 ambient = vec3(0.0f);
-    vec3 diffuse = vec3(0.0f);
-    vec3 specular = vec3(0.0f);
-
     vec3 lightDir = normalize(light.position - fragPos);
-    // diffuse shading
-    float diff = max(dot(normal, lightDir), 0.0);
-    // specular shading
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
     // attenuation
     float distance = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
@@ -224,40 +427,189 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float theta = dot(lightDir, normalize(-light.direction)); 
     float epsilon = light.cutOff - light.outerCutOff;
     float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
-    // combine results
-    if(bUseTexture == true)
+
+    // the falloff scales the light colors, so the diffuse light
+    // summed for the decals is attenuated too
+    float falloff = attenuation * intensity;
+    diffuseIrradiance += light.ambient * falloff;
+    vec3 ambient = light.ambient * surface.diffuseColor * falloff;
+    return ambient + CalcLight(surface, lightDir, light.diffuse * falloff, light.specular * falloff);
+}
+
+// builds the tangent frame from the screen space derivatives of the
+// position and the texture coordinates, so the meshes need no
+// tangent attribute.
+mat3 GetTangentFrame(vec3 normal, vec3 fragPos, vec2 uv)
+{
+    vec3 dp1 = dFdx(fragPos);
+    vec3 dp2 = dFdy(fragPos);
+    vec2 duv1 = dFdx(uv);
+    vec2 duv2 = dFdy(uv);
+
+    // solve for the directions of increasing u and v on the surface
+    vec3 dp2perp = cross(dp2, normal);
+    vec3 dp1perp = cross(normal, dp1);
+    vec3 tangent = dp2perp * duv1.x + dp1perp * duv2.x;
+    vec3 bitangent = dp2perp * duv1.y + dp1perp * duv2.y;
+    float invScale = inversesqrt(max(max(dot(tangent, tangent), dot(bitangent, bitangent)), 1e-12));
+    return mat3(tangent * invScale, bitangent * invScale, normal);
+}
+
+// bends the normal by the two-channel normal map
+vec3 PerturbNormal(mat3 tbn, vec2 uv)
+{
+    // only X and Y are stored, Z is rebuilt from the unit length
+    vec2 xy = texture(normalTexture, uv).rg * 2.0 - 1.0;
+    vec3 mapNormal = vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
+    return normalize(tbn * mapNormal);
+}
+
+// marches the view ray down into the height field (the brightness of
+// the texture) and returns where it first hits.  Grazing views get
+// more steps than views from straight above, and the depth fades to
+// nothing with distance so the switch off is not visible.
+vec2 ParallaxOcclusion(sampler2D heightMap, float depth, mat3 tbn, vec2 uv, vec2 dx, vec2 dy, vec3 viewDir, float fade)
+{
+    vec3 tangentView = normalize(transpose(tbn) * viewDir);
+    int steps = int(mix(float(parallaxMaxSteps), float(parallaxMinSteps), clamp(tangentView.z, 0.0, 1.0)));
+    float layerStep = 1.0 / float(steps);
+    vec2 shift = tangentView.xy / max(tangentView.z, 0.1) * depth * fade;
+    vec2 uvStep = shift * layerStep;
+
+    // the gradients of the unshifted coordinates (dx, dy) keep the
+    // mip level stable inside the loop
+    const vec3 luma = vec3(0.299, 0.587, 0.114);
+
+    vec2 currentUV = uv;
+    float layer = 0.0;
+    float height = 1.0 - dot(textureGrad(heightMap, currentUV, dx, dy).rgb, luma);
+    for (int i = 0; (i < steps) && (layer < height); i++)
     {
-        if(bUseTextureOverlay == true)
-        {
-            if(texture(overlayTexture, fragmentTextureCoordinate * UVscale).a > 0.1)
-            {
-                ambient = light.ambient * vec3(texture(overlayTexture, fragmentTextureCoordinate * UVscale));
-                diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(overlayTexture, fragmentTextureCoordinate * UVscale));
-                specular = light.specular * spec * material.specularColor * vec3(texture(overlayTexture, fragmentTextureCoordinate * UVscale));
-            }
-            else
-            {
-                ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinate * UVscale));
-                diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinate * UVscale));
-                specular = light.specular * spec * material.specularColor * vec3(texture(objectTexture, fragmentTextureCoordinate * UVscale));
-            }
-        }
-        else
-        {
-            ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinate * UVscale));
-            diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinate * UVscale));
-            specular = light.specular * spec * material.specularColor * vec3(texture(objectTexture, fragmentTextureCoordinate * UVscale));
-        }
+        currentUV -= uvStep;
+        layer += layerStep;
+        height = 1.0 - dot(textureGrad(heightMap, currentUV, dx, dy).rgb, luma);
+    }
+
+    // interpolate between the last step above and the first below
+    vec2 previousUV = currentUV + uvStep;
+    float after = height - layer;
+    float before = (1.0 - dot(textureGrad(heightMap, previousUV, dx, dy).rgb, luma)) - (layer - layerStep);
+    float weight = after / min(after - before, -0.0001);
+    return mix(currentUV, previousUV, clamp(weight, 0.0, 1.0));
+}
+
+// spread of the normals the pixel covers.  The change of the normal to
+// the next pixels covers the curvature of the mesh and the detail of the
+// normal map at the sampled level, and the Toksvig variance of that
+// level covers the detail its mips averaged away.
+float NormalVariance(vec3 normal, bool bNormalMap)
+{
+    vec3 dndx = dFdx(normal);
+    vec3 dndy = dFdy(normal);
+    float variance = specularAAVariance * (dot(dndx, dndx) + dot(dndy, dndy));
+
+    if ((bNormalMap == true) && (normalMapLevels > 0))
+    {
+        // the level the sampler picks, from the texel footprint
+        vec2 texel = surfaceUV * vec2(textureSize(normalTexture, 0));
+        vec2 dx = dFdx(texel);
+        vec2 dy = dFdy(texel);
+        float level = clamp(0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)), 0.0, float(normalMapLevels - 1));
+        int lower = int(level);
+        int upper = min(lower + 1, normalMapLevels - 1);
+        variance += mix(normalMapVariance[lower], normalMapVariance[upper], level - float(lower));
     }
-    else
+    return variance;
+}
+
+// coordinates of an overlay layer - the layer is projected along the mesh
+// Y axis, and the bottom face is mirrored so it reads correctly from below
+vec2 OverlayUV(vec4 rect, float side)
+{
+    return vec2((fragmentObjectPosition.x - rect.x) * side / rect.z + 0.5,
+                0.5 - (fragmentObjectPosition.z - rect.y) / rect.w);
+}
+
+// a layer only covers its rect on the face it was placed on
+float OverlayCoverage(vec2 uv, float side)
+{
+    float coverage = step(0.5, normalize(fragmentObjectNormal).y * side);
+    return coverage * step(0.0, uv.x) * step(uv.x, 1.0) * step(0.0, uv.y) * step(uv.y, 1.0);
+}
+
+// blends one overlay layer by its alpha.  The relief layer passes its
+// parallax shift, so its image moves with the surface it bends
+vec3 BlendOverlay(vec3 albedo, sampler2D layer, vec4 rect, float side, vec2 shift)
+{
+    vec2 uv = OverlayUV(rect, side);
+
+    // sampled before masking so the mip selection stays in uniform flow
+    vec4 overlayColor = texture(layer, uv + shift);
+    float coverage = OverlayCoverage(uv, side);
+
+    return mix(albedo, overlayColor.rgb, overlayColor.a * coverage);
+}
+
+// distance from a point to the nearest composite object.  Outside an
+// object's bounds the distance to the bounds is added to the field at
+// the closest point of them, which is never too long, and objects
+// whose bounds are farther than the nearest so far are skipped.
+float SceneDistance(vec3 point)
+{
+    float nearest = 1e6;
+    for (int i = 0; i < fieldObjectCount; i++)
     {
-        ambient = light.ambient * vec3(objectColor);
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
-        specular = light.specular * spec * material.specularColor * vec3(objectColor);
+        vec3 inside = clamp(point, fieldBoundsMin[i], fieldBoundsMax[i]);
+        float outside = length(point - inside);
+        if (outside >= nearest)
+            continue;
+
+        vec3 uvw = fieldAtlasOffset[i] + (inside - fieldBoundsMin[i]) / (fieldBoundsMax[i] - fieldBoundsMin[i]) * fieldBrickScale;
+        nearest = min(nearest, outside + textureLod(distanceAtlas, uvw, 0.0).r);
     }
-    
-    ambient *= attenuation * intensity;
-    diffuse *= attenuation * intensity;
-    specular *= attenuation * intensity;
-    return (ambient + diffuse + specular);
+    return nearest;
+}
+
+// soft shadow towards a point light, 1 fully lit and 0 fully hidden.
+// The ray marches a cone that widens with the distance traced, and an
+// object closer to the ray than the cone is wide hides that share of
+// the light.  Each step is at least an even share of the length, so
+// the fixed step budget always reaches the light.  The trace starts
+// past the error of the coarse fields around the surface.
+float DistanceFieldShadow(vec3 fragPos, vec3 lightPos)
+{
+    vec3 toLight = lightPos - fragPos;
+    float traceLength = min(length(toLight), fieldShadowDistance);
+    vec3 direction = normalize(toLight);
+    float minStep = traceLength / float(fieldShadowSteps);
+
+    float visibility = 1.0;
+    float t = fieldShadowStart;
+    for (int i = 0; (i < fieldShadowSteps) && (t < traceLength); i++)
+    {
+        float d = SceneDistance(fragPos + direction * t);
+        visibility = min(visibility, d / (fieldShadowConeWidth * t));
+        if (visibility <= 0.0)
+            break;
+        t += max(d, minStep);
+    }
+    return smoothstep(0.0, 1.0, visibility);
+}
+
+// occlusion of the ambient light by the objects nearby, 1 for none.
+// The fields are sampled at even heights along the normal, and a
+// sample nearer an object than its height is partly covered - the
+// low samples weigh the most.
+float DistanceFieldOcclusion(vec3 fragPos, vec3 normal)
+{
+    float occluded = 0.0;
+    float weight = 0.5;
+    for (int i = 1; i <= fieldOcclusionSteps; i++)
+    {
+        float height = fieldOcclusionDistance * float(i) / float(fieldOcclusionSteps);
+        float d = SceneDistance(fragPos + normal * height);
+        occluded += weight * clamp((height - d) / height, 0.0, 1.0);
+        weight *= 0.5;
+    }
+    return clamp(1.0 - fieldOcclusionIntensity * occluded, 0.0, 1.0);
 }
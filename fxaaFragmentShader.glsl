@@ -0,0 +1,49 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 fragmentTextureCoordinate;
+
+uniform sampler2D sourceTexture;
+uniform vec2 sourceTexelSize;
+
+#define FXAA_REDUCE_MIN (1.0 / 128.0)
+#define FXAA_REDUCE_MUL (1.0 / 8.0)
+#define FXAA_SPAN_MAX 8.0
+
+// FXAA - finds the local edge direction from the luma of the
+// neighbors (stored in alpha by the composite pass) and blurs
+// along that edge only
+void main()
+{
+    vec2 uv = fragmentTextureCoordinate;
+    float lumaNW = texture(sourceTexture, uv + vec2(-1.0, -1.0) * sourceTexelSize).a;
+    float lumaNE = texture(sourceTexture, uv + vec2( 1.0, -1.0) * sourceTexelSize).a;
+    float lumaSW = texture(sourceTexture, uv + vec2(-1.0,  1.0) * sourceTexelSize).a;
+    float lumaSE = texture(sourceTexture, uv + vec2( 1.0,  1.0) * sourceTexelSize).a;
+    vec4 center = texture(sourceTexture, uv);
+    float lumaM = center.a;
+
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    vec2 direction;
+    direction.x = -((lumaNW + lumaNE) - (lumaSW + lumaSE));
+    direction.y =  ((lumaNW + lumaSW) - (lumaNE + lumaSE));
+
+    float directionReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * (0.25 * FXAA_REDUCE_MUL), FXAA_REDUCE_MIN);
+    float inverseDirectionMin = 1.0 / (min(abs(direction.x), abs(direction.y)) + directionReduce);
+    direction = clamp(direction * inverseDirectionMin, vec2(-FXAA_SPAN_MAX), vec2(FXAA_SPAN_MAX)) * sourceTexelSize;
+
+    vec3 colorA = 0.5 * (
+        texture(sourceTexture, uv + direction * (1.0 / 3.0 - 0.5)).rgb +
+        texture(sourceTexture, uv + direction * (2.0 / 3.0 - 0.5)).rgb);
+    vec3 colorB = colorA * 0.5 + 0.25 * (
+        texture(sourceTexture, uv + direction * -0.5).rgb +
+        texture(sourceTexture, uv + direction * 0.5).rgb);
+
+    float lumaB = dot(colorB, vec3(0.299, 0.587, 0.114));
+    if ((lumaB < lumaMin) || (lumaB > lumaMax))
+        fragmentColor = vec4(colorA, 1.0);
+    else
+        fragmentColor = vec4(colorB, 1.0);
+}
@@ -0,0 +1,42 @@
+#version 330 core
+out vec4 fragmentColor;
+
+uniform sampler2D sourceTexture;
+uniform vec2 sourceSize;
+
+// builds one level of the hierarchical depth pyramid - each texel
+// keeps the nearest (smallest) depth of the texels it covers, so a
+// ray in front of it is in front of everything underneath
+void main()
+{
+    ivec2 target = ivec2(gl_FragCoord.xy);
+    ivec2 source = target * 2;
+    ivec2 size = ivec2(sourceSize);
+    ivec2 last = size - 1;
+
+    float depth = texelFetch(sourceTexture, min(source, last), 0).r;
+    depth = min(depth, texelFetch(sourceTexture, min(source + ivec2(1, 0), last), 0).r);
+    depth = min(depth, texelFetch(sourceTexture, min(source + ivec2(0, 1), last), 0).r);
+    depth = min(depth, texelFetch(sourceTexture, min(source + ivec2(1, 1), last), 0).r);
+
+    // an odd source edge leaves an extra row or column that the
+    // last target texel has to cover as well
+    bool bExtraColumn = ((size.x & 1) != 0) && (source.x + 2 == last.x);
+    bool bExtraRow = ((size.y & 1) != 0) && (source.y + 2 == last.y);
+    if (bExtraColumn == true)
+    {
+        depth = min(depth, texelFetch(sourceTexture, ivec2(last.x, min(source.y, last.y)), 0).r);
+        depth = min(depth, texelFetch(sourceTexture, ivec2(last.x, min(source.y + 1, last.y)), 0).r);
+    }
+    if (bExtraRow == true)
+    {
+        depth = min(depth, texelFetch(sourceTexture, ivec2(min(source.x, last.x), last.y), 0).r);
+        depth = min(depth, texelFetch(sourceTexture, ivec2(min(source.x + 1, last.x), last.y), 0).r);
+    }
+    if ((bExtraColumn == true) && (bExtraRow == true))
+    {
+        depth = min(depth, texelFetch(sourceTexture, last, 0).r);
+    }
+
+    fragmentColor = vec4(depth, 0.0, 0.0, 0.0);
+}
@@ -0,0 +1,31 @@
+#version 330 core
+in vec3 atlasCoordinate;
+in vec4 fragmentCurrentClip;
+in vec4 fragmentPreviousClip;
+
+// same targets as the scene shader
+layout(location = 0) out vec4 fragmentColor;
+layout(location = 1) out vec4 fragmentSurface;
+layout(location = 2) out vec4 fragmentLighting;
+layout(location = 3) out vec2 fragmentVelocity;
+
+uniform sampler2DArray impostorTexture;
+
+void main()
+{
+    vec4 baked = texture(impostorTexture, atlasCoordinate);
+    if (baked.a < 0.5)
+    {
+        discard;
+    }
+
+    // the background was cleared to 0, so the filtered edges are
+    // darkened by the alpha - divide it back out
+    fragmentColor = vec4(baked.rgb / baked.a, 1.0);
+    // the billboard faces the camera and reflects nothing
+    fragmentSurface = vec4(0.0, 0.0, 1.0, 0.0);
+    // the lighting is already in the baked color
+    fragmentLighting = vec4(1.0);
+    fragmentVelocity = (fragmentCurrentClip.xy / fragmentCurrentClip.w -
+        fragmentPreviousClip.xy / fragmentPreviousClip.w) * 0.5;
+}
@@ -0,0 +1,50 @@
+#version 330 core
+// bounding sphere and atlas layer of the billboard
+layout (location = 0) in vec4 inCenterRadius;
+layout (location = 1) in float inLayer;
+
+out vec3 atlasCoordinate;
+// unjittered clip positions this frame and last frame for the motion vectors
+out vec4 fragmentCurrentClip;
+out vec4 fragmentPreviousClip;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 currentViewProjection;
+uniform mat4 previousViewProjection;
+uniform vec3 viewPosition;
+// layout of the baked views, see Impostors.cpp
+uniform int azimuthCount;
+uniform int elevationCount;
+uniform float elevationStep;
+
+const float PI = 3.14159265;
+
+// draws a quad facing the camera over the bounding sphere, with the
+// baked view whose direction is closest to the camera's
+void main()
+{
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    vec3 center = inCenterRadius.xyz;
+    float radius = inCenterRadius.w;
+
+    vec3 toCamera = normalize(viewPosition - center);
+    float azimuth = atan(toCamera.x, toCamera.z);
+    float elevation = asin(clamp(toCamera.y, -1.0, 1.0));
+    int column = int(floor(fract(azimuth / (2.0 * PI)) * azimuthCount + 0.5)) % azimuthCount;
+    int row = clamp(int(floor(elevation / elevationStep + 0.5)), 0, elevationCount - 1);
+
+    // same axes as the lookAt() the views were baked with.  Straight
+    // above or below, the cross product with the Y axis is zero, so
+    // the Z axis is the reference there instead.
+    vec3 reference = (abs(toCamera.y) > 0.999) ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(reference, toCamera));
+    vec3 up = cross(toCamera, right);
+    vec3 position = center + (right * (corner.x * 2.0 - 1.0) + up * (corner.y * 2.0 - 1.0)) * radius;
+
+    gl_Position = projection * view * vec4(position, 1.0);
+    fragmentCurrentClip = currentViewProjection * vec4(position, 1.0);
+    fragmentPreviousClip = previousViewProjection * vec4(position, 1.0);
+
+    atlasCoordinate = vec3((vec2(column, row) + corner) / vec2(azimuthCount, elevationCount), inLayer);
+}
@@ -0,0 +1,7 @@
+#version 330 core
+
+// the color and depth writes are off, only the samples that pass
+// the depth test are counted
+void main()
+{
+}
@@ -0,0 +1,13 @@
+#version 330 core
+layout (location = 0) in vec3 inVertexPosition;
+
+uniform mat4 viewProjection;
+uniform vec3 boxCenter;
+uniform vec3 boxHalfSize;
+
+// stretches the unit cube over the bounding box of the object
+void main()
+{
+    vec3 position = boxCenter + inVertexPosition * 2.0 * boxHalfSize;
+    gl_Position = viewProjection * vec4(position, 1.0);
+}
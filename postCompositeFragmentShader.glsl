@@ -0,0 +1,45 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 fragmentTextureCoordinate;
+
+uniform sampler2D sceneTexture;
+uniform sampler2D bloomTexture;
+uniform bool bUseBloom = false;
+uniform float bloomIntensity = 0.5;
+uniform float exposure = 1.0;
+uniform vec3 colorFilter = vec3(1.0f);
+uniform float saturation = 1.0;
+uniform float contrast = 1.0;
+
+// ACES filmic curve (Narkowicz fit) for mapping HDR to display range
+vec3 TonemapACES(vec3 color)
+{
+    const float a = 2.51;
+    const float b = 0.03;
+    const float c = 2.43;
+    const float d = 0.59;
+    const float e = 0.14;
+    return clamp((color * (a * color + b)) / (color * (c * color + d) + e), 0.0, 1.0);
+}
+
+// bloom composite, tonemapping and color grading are fused into a
+// single pass so the HDR image is only read once at full resolution
+void main()
+{
+    vec3 color = texture(sceneTexture, fragmentTextureCoordinate).rgb;
+
+    if (bUseBloom == true)
+        color += texture(bloomTexture, fragmentTextureCoordinate).rgb * bloomIntensity;
+
+    color = TonemapACES(color * exposure);
+
+    // color grading
+    color *= colorFilter;
+    float luma = dot(color, vec3(0.299, 0.587, 0.114));
+    color = mix(vec3(luma), color, saturation);
+    color = clamp((color - 0.5) * contrast + 0.5, 0.0, 1.0);
+
+    // luma is stored in alpha for the FXAA pass that follows
+    fragmentColor = vec4(color, dot(color, vec3(0.299, 0.587, 0.114)));
+}
@@ -0,0 +1,11 @@
+#version 330 core
+out vec2 fragmentTextureCoordinate;
+
+// draws one triangle that covers the whole viewport, so no
+// vertex buffer is needed for the fullscreen post passes
+void main()
+{
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    fragmentTextureCoordinate = position;
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
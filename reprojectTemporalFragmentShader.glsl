@@ -0,0 +1,59 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 fragmentTextureCoordinate;
+
+// shared by the low resolution effects that store their value in R
+// and the distance to the surface in G - the light shafts and the
+// ambient occlusion
+uniform sampler2D currentTexture;
+uniform sampler2D historyTexture;
+uniform mat4 inverseViewProjection;
+uniform mat4 previousViewProjection;
+uniform vec3 viewPosition;
+uniform bool bHistoryValid = false;
+uniform float historyWeight = 0.9;
+
+void main()
+{
+    vec4 current = texture(currentTexture, fragmentTextureCoordinate);
+
+    if (bHistoryValid == false)
+    {
+        fragmentColor = current;
+        return;
+    }
+
+    // find where this surface was on screen last frame, from the
+    // distance stored along the view ray
+    vec4 farPoint = inverseViewProjection * vec4(fragmentTextureCoordinate * 2.0 - 1.0, 1.0, 1.0);
+    vec3 world = viewPosition + normalize(farPoint.xyz / farPoint.w - viewPosition) * current.g;
+    vec4 previous = previousViewProjection * vec4(world, 1.0);
+    vec2 previousUV = (previous.xy / previous.w) * 0.5 + 0.5;
+
+    if ((previousUV.x < 0.0) || (previousUV.x > 1.0) || (previousUV.y < 0.0) || (previousUV.y > 1.0))
+    {
+        fragmentColor = current;
+        return;
+    }
+
+    // clamp the history to the range of the current neighborhood so
+    // values uncovered by a moving edge do not leave trails - the
+    // per frame jitter makes the range wide enough to keep converging
+    ivec2 center = ivec2(gl_FragCoord.xy);
+    ivec2 last = textureSize(currentTexture, 0) - 1;
+    float neighborMin = current.r;
+    float neighborMax = current.r;
+    for (int y = -1; y <= 1; y++)
+    {
+        for (int x = -1; x <= 1; x++)
+        {
+            float neighbor = texelFetch(currentTexture, clamp(center + ivec2(x, y), ivec2(0), last), 0).r;
+            neighborMin = min(neighborMin, neighbor);
+            neighborMax = max(neighborMax, neighbor);
+        }
+    }
+
+    float history = clamp(texture(historyTexture, previousUV).r, neighborMin, neighborMax);
+    fragmentColor = vec4(mix(current.r, history, historyWeight), current.g, 0.0, 1.0);
+}
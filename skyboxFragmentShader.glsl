@@ -0,0 +1,25 @@
+#version 330 core
+in vec3 skyDirection;
+in vec2 skyPosition;
+
+// same targets as the scene shader
+layout(location = 0) out vec4 fragmentColor;
+layout(location = 1) out vec4 fragmentSurface;
+layout(location = 2) out vec4 fragmentLighting;
+layout(location = 3) out vec2 fragmentVelocity;
+
+uniform samplerCube skyTexture;
+// rotation-only view-projection of the last frame
+uniform mat4 previousViewProjection;
+
+void main()
+{
+    fragmentColor = vec4(texture(skyTexture, normalize(skyDirection)).rgb, 1.0);
+    // the sky reflects nothing, and the decals never reach it
+    fragmentSurface = vec4(0.0);
+    fragmentLighting = vec4(1.0);
+
+    // the sky is infinitely far, so only the camera's turn moves it
+    vec4 previous = previousViewProjection * vec4(skyDirection, 0.0);
+    fragmentVelocity = (skyPosition - previous.xy / previous.w) * 0.5;
+}
@@ -0,0 +1,17 @@
+#version 330 core
+out vec3 skyDirection;
+out vec2 skyPosition;
+
+uniform mat4 inverseViewProjection;
+
+// draws one triangle that covers the whole viewport at the far
+// plane (z = w), and turns each corner back into a view direction
+// with the rotation-only view-projection
+void main()
+{
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+    vec4 farPoint = inverseViewProjection * vec4(position, 1.0, 1.0);
+    skyDirection = farPoint.xyz / farPoint.w;
+    skyPosition = position;
+    gl_Position = vec4(position, 1.0, 1.0);
+}
@@ -0,0 +1,48 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 fragmentTextureCoordinate;
+
+// occlusion in R and surface distance in G, at half size
+uniform sampler2D occlusionTexture;
+uniform sampler2D depthTexture;
+uniform mat4 inverseViewProjection;
+uniform vec3 viewPosition;
+uniform float intensity = 1.5;
+
+// how quickly a half resolution texel loses weight as its surface
+// distance moves away from this pixel's, relative to the distance
+const float depthSharpness = 20.0;
+
+void main()
+{
+    float depth = texture(depthTexture, fragmentTextureCoordinate).r;
+    vec4 world = inverseViewProjection * vec4(vec3(fragmentTextureCoordinate, depth) * 2.0 - 1.0, 1.0);
+    float pixelDistance = distance(world.xyz / world.w, viewPosition);
+
+    // the four nearest half resolution texels, weighted bilinearly
+    // and by how close their surface is to this pixel's, so the
+    // shading under an object does not spread over its edge
+    ivec2 size = textureSize(occlusionTexture, 0);
+    vec2 position = fragmentTextureCoordinate * vec2(size) - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 blend = position - floor(position);
+
+    float occlusion = 0.0;
+    float totalWeight = 0.0;
+    for (int y = 0; y <= 1; y++)
+    {
+        for (int x = 0; x <= 1; x++)
+        {
+            vec2 texel = texelFetch(occlusionTexture, clamp(base + ivec2(x, y), ivec2(0), size - 1), 0).rg;
+            float bilinear = ((x == 0) ? 1.0 - blend.x : blend.x) * ((y == 0) ? 1.0 - blend.y : blend.y);
+            float similarity = exp(-depthSharpness * abs(texel.g - pixelDistance) / max(pixelDistance, 0.001));
+            float weight = bilinear * similarity + 0.0001;
+            occlusion += texel.r * weight;
+            totalWeight += weight;
+        }
+    }
+
+    // multiplied into the color by the blend
+    fragmentColor = vec4(vec3(pow(occlusion / totalWeight, intensity)), 1.0);
+}
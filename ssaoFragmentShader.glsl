@@ -0,0 +1,80 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 fragmentTextureCoordinate;
+
+uniform sampler2D depthTexture;
+// view space normal in RGB
+uniform sampler2D surfaceTexture;
+uniform mat4 projection;
+uniform mat4 inverseProjection;
+uniform float radius = 1.5;
+uniform int sampleCount = 8;
+uniform int frameIndex = 0;
+
+const float PI = 3.14159265359;
+// keeps flat surfaces from occluding themselves
+const float depthBias = 0.02;
+
+vec3 ViewPosition(vec2 uv, float depth)
+{
+    vec4 position = inverseProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
+// per pixel noise with little low frequency content, so the few
+// samples of a pixel differ from its neighbors and from last frame
+float InterleavedGradientNoise(vec2 pixel)
+{
+    return fract(52.9829189 * fract(dot(pixel, vec2(0.06711056, 0.00583715))));
+}
+
+void main()
+{
+    // the full size depth and normal under the center of this pixel
+    ivec2 fullSize = textureSize(depthTexture, 0);
+    ivec2 fullTexel = clamp(ivec2(fragmentTextureCoordinate * vec2(fullSize)), ivec2(0), fullSize - 1);
+    float depth = texelFetch(depthTexture, fullTexel, 0).r;
+    vec3 normal = texelFetch(surfaceTexture, fullTexel, 0).xyz;
+    vec3 position = ViewPosition(fragmentTextureCoordinate, depth);
+
+    // the sky has no normal and nothing to occlude it
+    if ((depth >= 1.0) || (dot(normal, normal) < 0.5))
+    {
+        fragmentColor = vec4(1.0, length(position), 0.0, 1.0);
+        return;
+    }
+    normal = normalize(normal);
+
+    // a frame with the normal as Z, turned by the noise
+    float noise = fract(InterleavedGradientNoise(gl_FragCoord.xy) + float(frameIndex) * 0.618034);
+    float angle = noise * 2.0 * PI;
+    vec3 helper = (abs(normal.z) < 0.999) ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+    vec3 tangent = normalize(cross(helper, normal));
+    vec3 bitangent = cross(normal, tangent);
+    mat3 tbn = mat3(tangent * cos(angle) + bitangent * sin(angle),
+        bitangent * cos(angle) - tangent * sin(angle), normal);
+
+    // cosine weighted directions on a golden angle spiral, with
+    // more of the samples close to the pixel where contact matters
+    float occlusion = 0.0;
+    for (int i = 0; i < sampleCount; i++)
+    {
+        float spread = sqrt((float(i) + 0.5) / float(sampleCount));
+        float phi = float(i) * 2.39996;
+        vec3 direction = vec3(spread * cos(phi), spread * sin(phi), sqrt(1.0 - spread * spread));
+        float reach = fract(float(i) * 0.754877 + noise);
+        vec3 samplePosition = position + tbn * direction * (radius * mix(0.1, 1.0, reach * reach));
+
+        vec4 clip = projection * vec4(samplePosition, 1.0);
+        vec2 sampleUV = (clip.xy / clip.w) * 0.5 + 0.5;
+        float sceneZ = ViewPosition(sampleUV, textureLod(depthTexture, sampleUV, 0.0).r).z;
+
+        // geometry far in front of the sample is a separate object,
+        // not a crease, so it fades out past the radius
+        float range = smoothstep(0.0, 1.0, radius / abs(position.z - sceneZ));
+        occlusion += ((sceneZ >= samplePosition.z + depthBias) ? 1.0 : 0.0) * range;
+    }
+
+    fragmentColor = vec4(1.0 - occlusion / float(sampleCount), length(position), 0.0, 1.0);
+}
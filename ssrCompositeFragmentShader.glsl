@@ -0,0 +1,32 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 fragmentTextureCoordinate;
+
+uniform sampler2D reflectionTexture;
+uniform sampler2D surfaceTexture;
+uniform sampler2D depthTexture;
+uniform mat4 inverseProjection;
+
+void main()
+{
+    vec4 surface = texture(surfaceTexture, fragmentTextureCoordinate);
+    if (surface.a <= 0.001)
+    {
+        discard;
+    }
+
+    float depth = texture(depthTexture, fragmentTextureCoordinate).r;
+    vec4 viewPosition = inverseProjection * vec4(vec3(fragmentTextureCoordinate, depth) * 2.0 - 1.0, 1.0);
+    vec3 viewDir = normalize(-viewPosition.xyz / viewPosition.w);
+    vec3 normal = normalize(surface.xyz);
+
+    // Schlick fresnel with the material reflectivity at normal
+    // incidence, so glancing angles reflect more
+    float cosTheta = clamp(dot(normal, viewDir), 0.0, 1.0);
+    float fresnel = surface.a + (1.0 - surface.a) * pow(1.0 - cosTheta, 5.0);
+
+    // blended over the lit surface by the alpha
+    vec4 reflection = texture(reflectionTexture, fragmentTextureCoordinate);
+    fragmentColor = vec4(reflection.rgb, clamp(fresnel * reflection.a, 0.0, 1.0));
+}
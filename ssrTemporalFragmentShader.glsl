@@ -0,0 +1,54 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 fragmentTextureCoordinate;
+
+uniform sampler2D currentTexture;
+uniform sampler2D historyTexture;
+uniform sampler2D depthTexture;
+uniform mat4 inverseViewProjection;
+uniform mat4 previousViewProjection;
+uniform bool bHistoryValid = false;
+uniform float historyWeight = 0.9;
+
+void main()
+{
+    vec4 current = texture(currentTexture, fragmentTextureCoordinate);
+
+    if (bHistoryValid == false)
+    {
+        fragmentColor = current;
+        return;
+    }
+
+    // find where this surface was on screen last frame
+    float depth = textureLod(depthTexture, fragmentTextureCoordinate, 0.0).r;
+    vec4 world = inverseViewProjection * vec4(vec3(fragmentTextureCoordinate, depth) * 2.0 - 1.0, 1.0);
+    vec4 previous = previousViewProjection * vec4(world.xyz / world.w, 1.0);
+    vec2 previousUV = (previous.xy / previous.w) * 0.5 + 0.5;
+
+    if ((previousUV.x < 0.0) || (previousUV.x > 1.0) || (previousUV.y < 0.0) || (previousUV.y > 1.0))
+    {
+        fragmentColor = current;
+        return;
+    }
+
+    // clamp the history to the range of the current neighborhood so
+    // reflections that moved or disappeared do not leave trails
+    ivec2 center = ivec2(gl_FragCoord.xy);
+    ivec2 last = textureSize(currentTexture, 0) - 1;
+    vec4 neighborMin = current;
+    vec4 neighborMax = current;
+    for (int y = -1; y <= 1; y++)
+    {
+        for (int x = -1; x <= 1; x++)
+        {
+            vec4 neighbor = texelFetch(currentTexture, clamp(center + ivec2(x, y), ivec2(0), last), 0);
+            neighborMin = min(neighborMin, neighbor);
+            neighborMax = max(neighborMax, neighbor);
+        }
+    }
+
+    vec4 history = clamp(texture(historyTexture, previousUV), neighborMin, neighborMax);
+    fragmentColor = mix(current, history, historyWeight);
+}
@@ -0,0 +1,145 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 fragmentTextureCoordinate;
+
+uniform sampler2D hiZTexture;
+uniform sampler2D surfaceTexture;
+uniform sampler2D colorTexture;
+uniform mat4 projection;
+uniform mat4 inverseProjection;
+uniform vec2 hiZSize;
+uniform int hiZLevels = 1;
+uniform int maxIterations = 32;
+uniform float maxDistance = 20.0;
+uniform float thickness = 0.5;
+uniform float nearPlane = 0.1;
+
+// view space position of a texture coordinate and depth
+vec3 GetViewPosition(vec2 uv, float depth)
+{
+    vec4 position = inverseProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
+// texture coordinate and depth of a view space position
+vec3 GetScreenPosition(vec3 viewPosition)
+{
+    vec4 clip = projection * vec4(viewPosition, 1.0);
+    return (clip.xyz / clip.w) * 0.5 + 0.5;
+}
+
+void main()
+{
+    vec4 surface = texture(surfaceTexture, fragmentTextureCoordinate);
+
+    // only reflective materials pay for a trace
+    if (surface.a <= 0.001)
+    {
+        fragmentColor = vec4(0.0);
+        return;
+    }
+
+    float depth = textureLod(hiZTexture, fragmentTextureCoordinate, 0.0).r;
+    if (depth >= 1.0)
+    {
+        fragmentColor = vec4(0.0);
+        return;
+    }
+
+    vec3 viewPosition = GetViewPosition(fragmentTextureCoordinate, depth);
+    vec3 normal = normalize(surface.xyz);
+    vec3 reflection = normalize(reflect(normalize(viewPosition), normal));
+
+    // rays heading back towards the camera leave the screen almost
+    // at once, so they are faded out and never traced
+    float facingFade = 1.0 - smoothstep(0.0, 0.25, reflection.z);
+    if (facingFade <= 0.0)
+    {
+        fragmentColor = vec4(0.0);
+        return;
+    }
+
+    // clip the ray against the near plane before projecting it
+    float rayLength = maxDistance;
+    if (viewPosition.z + reflection.z * rayLength > -nearPlane)
+    {
+        rayLength = (-nearPlane - viewPosition.z) / reflection.z;
+    }
+    vec3 rayStart = GetScreenPosition(viewPosition);
+    vec3 rayEnd = GetScreenPosition(viewPosition + reflection * rayLength);
+    vec3 rayDirection = rayEnd - rayStart;
+
+    // hierarchical traversal - step over whole cells of the pyramid
+    // while the ray is in front of their nearest depth, and drop a
+    // level whenever it might pass behind something
+    vec2 crossStep = vec2(rayDirection.x >= 0.0 ? 1.0 : 0.0, rayDirection.y >= 0.0 ? 1.0 : 0.0);
+    vec2 crossOffset = (crossStep * 2.0 - 1.0) * 0.001 / hiZSize;
+    vec2 safeDirection = vec2(
+        abs(rayDirection.x) < 0.000001 ? 0.000001 : rayDirection.x,
+        abs(rayDirection.y) < 0.000001 ? 0.000001 : rayDirection.y);
+
+    int level = 0;
+    int iterations = 0;
+    // start one texel along the ray so it does not hit itself
+    float t = 1.0 / max(length(rayDirection.xy * hiZSize), 1.0);
+
+    while ((level >= 0) && (iterations < maxIterations) && (t < 1.0))
+    {
+        vec2 cellCount = max(floor(hiZSize / exp2(float(level))), vec2(1.0));
+        vec3 ray = rayStart + rayDirection * t;
+        vec2 cell = floor(ray.xy * cellCount);
+
+        // ray parameter where it leaves the current cell
+        vec2 boundary = (cell + crossStep) / cellCount + crossOffset;
+        vec2 exitT = (boundary - rayStart.xy) / safeDirection;
+        float cellExit = min(exitT.x, exitT.y);
+
+        float minDepth = texelFetch(hiZTexture, ivec2(cell), level).r;
+        if (ray.z < minDepth)
+        {
+            // in front of the whole cell - move to the depth plane or
+            // the cell edge, whichever comes first
+            float planeT = (rayDirection.z > 0.0) ? (minDepth - rayStart.z) / rayDirection.z : 2.0;
+            if (planeT < cellExit)
+            {
+                t = max(t, planeT);
+                level--;
+            }
+            else
+            {
+                t = cellExit;
+                level = min(level + 1, hiZLevels - 1);
+            }
+        }
+        else
+        {
+            level--;
+        }
+        iterations++;
+    }
+
+    if ((level >= 0) || (t >= 1.0))
+    {
+        fragmentColor = vec4(0.0);
+        return;
+    }
+
+    // reject hits that passed far behind the surface in front
+    vec3 hit = rayStart + rayDirection * t;
+    float sceneDepth = textureLod(hiZTexture, hit.xy, 0.0).r;
+    float behind = GetViewPosition(hit.xy, sceneDepth).z - GetViewPosition(hit.xy, hit.z).z;
+    if (behind > thickness)
+    {
+        fragmentColor = vec4(0.0);
+        return;
+    }
+
+    // fade towards the screen edges and the end of the ray
+    vec2 edge = abs(hit.xy * 2.0 - 1.0);
+    float edgeFade = 1.0 - smoothstep(0.85, 1.0, max(edge.x, edge.y));
+    float distanceFade = 1.0 - t * t;
+
+    vec3 color = textureLod(colorTexture, hit.xy, 0.0).rgb;
+    fragmentColor = vec4(color, edgeFade * distanceFade * facingFade);
+}
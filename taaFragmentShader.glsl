@@ -0,0 +1,128 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 fragmentTextureCoordinate;
+
+uniform sampler2D currentTexture;
+uniform sampler2D historyTexture;
+// screen movement since last frame in texture coordinates
+uniform sampler2D velocityTexture;
+uniform sampler2D depthTexture;
+uniform bool bHistoryValid = false;
+uniform float currentWeight = 0.1;
+
+vec3 RGBToYCoCg(vec3 color)
+{
+    return vec3(
+        0.25 * color.r + 0.5 * color.g + 0.25 * color.b,
+        0.5 * color.r - 0.5 * color.b,
+        -0.25 * color.r + 0.5 * color.g - 0.25 * color.b);
+}
+
+vec3 YCoCgToRGB(vec3 color)
+{
+    return vec3(
+        color.x + color.y - color.z,
+        color.x + color.z,
+        color.x - color.y - color.z);
+}
+
+// Catmull-Rom filtered history from nine bilinear reads - a plain
+// bilinear read would blur the history a little every frame
+vec3 SampleHistory(vec2 uv)
+{
+    vec2 size = vec2(textureSize(historyTexture, 0));
+    vec2 samplePosition = uv * size;
+    vec2 center = floor(samplePosition - 0.5) + 0.5;
+    vec2 f = samplePosition - center;
+
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+    vec2 w12 = w1 + w2;
+
+    vec2 uv0 = (center - 1.0) / size;
+    vec2 uv12 = (center + w2 / w12) / size;
+    vec2 uv3 = (center + 2.0) / size;
+
+    vec3 result =
+        textureLod(historyTexture, vec2(uv0.x, uv0.y), 0.0).rgb * w0.x * w0.y +
+        textureLod(historyTexture, vec2(uv12.x, uv0.y), 0.0).rgb * w12.x * w0.y +
+        textureLod(historyTexture, vec2(uv3.x, uv0.y), 0.0).rgb * w3.x * w0.y +
+        textureLod(historyTexture, vec2(uv0.x, uv12.y), 0.0).rgb * w0.x * w12.y +
+        textureLod(historyTexture, vec2(uv12.x, uv12.y), 0.0).rgb * w12.x * w12.y +
+        textureLod(historyTexture, vec2(uv3.x, uv12.y), 0.0).rgb * w3.x * w12.y +
+        textureLod(historyTexture, vec2(uv0.x, uv3.y), 0.0).rgb * w0.x * w3.y +
+        textureLod(historyTexture, vec2(uv12.x, uv3.y), 0.0).rgb * w12.x * w3.y +
+        textureLod(historyTexture, vec2(uv3.x, uv3.y), 0.0).rgb * w3.x * w3.y;
+    return max(result, vec3(0.0));
+}
+
+void main()
+{
+    ivec2 center = ivec2(gl_FragCoord.xy);
+    ivec2 last = textureSize(currentTexture, 0) - 1;
+    vec3 current = texelFetch(currentTexture, center, 0).rgb;
+
+    if (bHistoryValid == false)
+    {
+        fragmentColor = vec4(current, 1.0);
+        return;
+    }
+
+    // the range of colors around the pixel this frame, and the
+    // motion of the nearest surface around it, so the edges of a
+    // moving object carry its motion rather than the background's
+    vec3 neighborMin = RGBToYCoCg(current);
+    vec3 neighborMax = neighborMin;
+    float closestDepth = 1.0;
+    ivec2 closestTexel = center;
+    for (int y = -1; y <= 1; y++)
+    {
+        for (int x = -1; x <= 1; x++)
+        {
+            ivec2 texel = clamp(center + ivec2(x, y), ivec2(0), last);
+            vec3 neighbor = RGBToYCoCg(texelFetch(currentTexture, texel, 0).rgb);
+            neighborMin = min(neighborMin, neighbor);
+            neighborMax = max(neighborMax, neighbor);
+
+            float depth = texelFetch(depthTexture, texel, 0).r;
+            if (depth < closestDepth)
+            {
+                closestDepth = depth;
+                closestTexel = texel;
+            }
+        }
+    }
+
+    vec2 velocity = texelFetch(velocityTexture, closestTexel, 0).rg;
+    vec2 previousUV = fragmentTextureCoordinate - velocity;
+    if ((previousUV.x < 0.0) || (previousUV.x > 1.0) || (previousUV.y < 0.0) || (previousUV.y > 1.0))
+    {
+        fragmentColor = vec4(current, 1.0);
+        return;
+    }
+
+    // clip the history towards the middle of the neighborhood box,
+    // which keeps its hue better than clamping each channel
+    vec3 history = RGBToYCoCg(SampleHistory(previousUV));
+    vec3 boxCenter = 0.5 * (neighborMax + neighborMin);
+    vec3 boxExtent = 0.5 * (neighborMax - neighborMin) + 0.0001;
+    vec3 offset = history - boxCenter;
+    vec3 units = abs(offset / boxExtent);
+    float largest = max(units.x, max(units.y, units.z));
+    if (largest > 1.0)
+        history = boxCenter + offset / largest;
+    history = YCoCgToRGB(history);
+
+    // weighting by inverse brightness keeps single bright samples
+    // from flickering through the average
+    float currentLuma = RGBToYCoCg(current).x;
+    float historyLuma = RGBToYCoCg(history).x;
+    float weightCurrent = currentWeight / (1.0 + currentLuma);
+    float weightHistory = (1.0 - currentWeight) / (1.0 + historyLuma);
+    vec3 result = (current * weightCurrent + history * weightHistory) / (weightCurrent + weightHistory);
+
+    fragmentColor = vec4(result, 1.0);
+}
@@ -0,0 +1,73 @@
+#version 400 core
+layout (vertices = 4) out;
+
+in vec3 patchCorner[];
+out vec3 controlCorner[];
+
+// target length of one segment in mesh units, the pixels per
+// segment over the pixels per unit of the density level
+uniform float segmentLength;
+
+#define PART_SPHERE 0
+#define PART_CYLINDER_SIDE 1
+#define PART_CYLINDER_TOP 2
+
+const float PI = 3.14159265;
+// the most segments an edge is split into
+const float MAX_SEGMENTS = 64.0;
+
+// position on the unit shape at the patch coordinate, the same as in
+// the evaluation shader
+vec3 SurfacePosition(vec3 corner)
+{
+    float angle = corner.x * 2.0 * PI;
+    vec3 around = vec3(cos(angle), 0.0, sin(angle));
+    int part = int(corner.z + 0.5);
+    if (part == PART_SPHERE)
+    {
+        float latitude = corner.y * 0.5 * PI;
+        return around * cos(latitude) + vec3(0.0, sin(latitude), 0.0);
+    }
+    if (part == PART_CYLINDER_SIDE)
+    {
+        return around + vec3(0.0, corner.y, 0.0);
+    }
+    if (part == PART_CYLINDER_TOP)
+    {
+        return around * (1.0 - corner.y) + vec3(0.0, 1.0, 0.0);
+    }
+    return around * corner.y;
+}
+
+// number of segments for the edge between two corners, from the
+// length of the curve between them.  Neighbouring patches measure a
+// shared edge from the same two corners, so they split it the same
+// way and leave no cracks.
+float EdgeSegments(vec3 start, vec3 end)
+{
+    float curveLength = 0.0;
+    vec3 previous = SurfacePosition(start);
+    for (int i = 1; i <= 4; i++)
+    {
+        vec3 current = SurfacePosition(mix(start, end, float(i) / 4.0));
+        curveLength += distance(previous, current);
+        previous = current;
+    }
+    return clamp(ceil(curveLength / segmentLength), 1.0, MAX_SEGMENTS);
+}
+
+void main()
+{
+    controlCorner[gl_InvocationID] = patchCorner[gl_InvocationID];
+
+    if (gl_InvocationID == 0)
+    {
+        // the corners go (u0, v0), (u1, v0), (u1, v1), (u0, v1)
+        gl_TessLevelOuter[0] = EdgeSegments(patchCorner[0], patchCorner[3]);
+        gl_TessLevelOuter[1] = EdgeSegments(patchCorner[0], patchCorner[1]);
+        gl_TessLevelOuter[2] = EdgeSegments(patchCorner[1], patchCorner[2]);
+        gl_TessLevelOuter[3] = EdgeSegments(patchCorner[3], patchCorner[2]);
+        gl_TessLevelInner[0] = max(gl_TessLevelOuter[1], gl_TessLevelOuter[3]);
+        gl_TessLevelInner[1] = max(gl_TessLevelOuter[0], gl_TessLevelOuter[2]);
+    }
+}
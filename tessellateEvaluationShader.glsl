@@ -0,0 +1,58 @@
+#version 400 core
+// u runs around the Y axis from +X towards +Z, so u and v span the
+// surface the inward way round - the triangles are emitted clockwise
+// in the patch to face outwards
+layout (quads, equal_spacing, cw) in;
+
+in vec3 controlCorner[];
+
+// captured by transform feedback, in object space
+out vec3 tessellatedPosition;
+out vec3 tessellatedNormal;
+out vec2 tessellatedTextureCoordinate;
+
+#define PART_SPHERE 0
+#define PART_CYLINDER_SIDE 1
+#define PART_CYLINDER_TOP 2
+
+const float PI = 3.14159265;
+
+// places the vertex on the exact surface of the unit shape - a
+// sphere of radius 1 around the origin, or a cylinder of radius 1
+// from y = 0 to y = 1, like the basic meshes
+void main()
+{
+    vec3 bottom = mix(controlCorner[0], controlCorner[1], gl_TessCoord.x);
+    vec3 top = mix(controlCorner[3], controlCorner[2], gl_TessCoord.x);
+    vec3 corner = mix(bottom, top, gl_TessCoord.y);
+
+    float angle = corner.x * 2.0 * PI;
+    vec3 around = vec3(cos(angle), 0.0, sin(angle));
+    int part = int(corner.z + 0.5);
+    if (part == PART_SPHERE)
+    {
+        float latitude = corner.y * 0.5 * PI;
+        tessellatedPosition = around * cos(latitude) + vec3(0.0, sin(latitude), 0.0);
+        tessellatedNormal = tessellatedPosition;
+        tessellatedTextureCoordinate = vec2(corner.x, corner.y * 0.5 + 0.5);
+    }
+    else if (part == PART_CYLINDER_SIDE)
+    {
+        tessellatedPosition = around + vec3(0.0, corner.y, 0.0);
+        tessellatedNormal = around;
+        tessellatedTextureCoordinate = corner.xy;
+    }
+    else if (part == PART_CYLINDER_TOP)
+    {
+        // v runs from the rim to the center, so the cap faces up
+        tessellatedPosition = around * (1.0 - corner.y) + vec3(0.0, 1.0, 0.0);
+        tessellatedNormal = vec3(0.0, 1.0, 0.0);
+        tessellatedTextureCoordinate = tessellatedPosition.xz * 0.5 + 0.5;
+    }
+    else
+    {
+        tessellatedPosition = around * corner.y;
+        tessellatedNormal = vec3(0.0, -1.0, 0.0);
+        tessellatedTextureCoordinate = tessellatedPosition.xz * 0.5 + 0.5;
+    }
+}
@@ -0,0 +1,10 @@
+#version 400 core
+// patch corner on the shape - u around it, v along it, and the part
+layout (location = 0) in vec3 inPatchCorner;
+
+out vec3 patchCorner;
+
+void main()
+{
+    patchCorner = inPatchCorner;
+}
@@ -6,21 +6,30 @@ layout (location = 2) in vec2 inTextureCoordinate;
 out vec3 fragmentPosition;
 out vec3 fragmentVertexNormal;
 out vec2 fragmentTextureCoordinate;
+// unscaled mesh position and normal for the overlay projection
+out vec3 fragmentObjectPosition;
+out vec3 fragmentObjectNormal;
+// unjittered clip positions this frame and last frame for the motion vectors
+out vec4 fragmentCurrentClip;
+out vec4 fragmentPreviousClip;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
-uniform float bendStrength;
+uniform mat4 previousModel;
+uniform mat4 currentViewProjection;
+uniform mat4 previousViewProjection;
 
 void main()
 {
-    // Apply bending effect
+    // deformed meshes arrive already deformed, see MeshDeformer
     vec3 modifiedPosition = inVertexPosition;
-    modifiedPosition.y += bendStrength * sin(modifiedPosition.x);
 
     // Transform the modified position
     fragmentPosition = vec3(model * vec4(modifiedPosition, 1.0));
     gl_Position = projection * view * vec4(fragmentPosition, 1.0);
+    fragmentCurrentClip = currentViewProjection * vec4(fragmentPosition, 1.0);
+    fragmentPreviousClip = previousViewProjection * previousModel * vec4(modifiedPosition, 1.0);
 
     // ✅ Fix: Use correct normal transformation
     vec3 modifiedNormal = normalize(mat3(transpose(inverse(model))) * inVertexNormal);
@@ -28,4 +37,6 @@ void main()
 
     // Pass through other attributes
     fragmentTextureCoordinate = inTextureCoordinate;
+    fragmentObjectPosition = modifiedPosition;
+    fragmentObjectNormal = inVertexNormal;
 }
@@ -0,0 +1,47 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 fragmentTextureCoordinate;
+
+// scattering in R and surface distance in G, at a quarter size
+uniform sampler2D scatteringTexture;
+uniform sampler2D depthTexture;
+uniform mat4 inverseViewProjection;
+uniform vec3 viewPosition;
+uniform vec3 lightColor;
+
+// how quickly a low resolution texel loses weight as its surface
+// distance moves away from this pixel's, relative to the distance
+const float depthSharpness = 20.0;
+
+void main()
+{
+    float depth = texture(depthTexture, fragmentTextureCoordinate).r;
+    vec4 world = inverseViewProjection * vec4(vec3(fragmentTextureCoordinate, depth) * 2.0 - 1.0, 1.0);
+    float pixelDistance = distance(world.xyz / world.w, viewPosition);
+
+    // the four nearest low resolution texels, weighted bilinearly and
+    // by how close their surface is to this pixel's, so shafts behind
+    // an object do not bleed over its edge
+    ivec2 size = textureSize(scatteringTexture, 0);
+    vec2 position = fragmentTextureCoordinate * vec2(size) - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 blend = position - floor(position);
+
+    float scattering = 0.0;
+    float totalWeight = 0.0;
+    for (int y = 0; y <= 1; y++)
+    {
+        for (int x = 0; x <= 1; x++)
+        {
+            vec2 texel = texelFetch(scatteringTexture, clamp(base + ivec2(x, y), ivec2(0), size - 1), 0).rg;
+            float bilinear = ((x == 0) ? 1.0 - blend.x : blend.x) * ((y == 0) ? 1.0 - blend.y : blend.y);
+            float similarity = exp(-depthSharpness * abs(texel.g - pixelDistance) / max(pixelDistance, 0.001));
+            float weight = bilinear * similarity + 0.0001;
+            scattering += texel.r * weight;
+            totalWeight += weight;
+        }
+    }
+
+    fragmentColor = vec4(lightColor * (scattering / totalWeight), 1.0);
+}
@@ -0,0 +1,69 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 fragmentTextureCoordinate;
+
+uniform sampler2D depthTexture;
+uniform sampler2DShadow shadowTexture;
+uniform mat4 inverseViewProjection;
+uniform mat4 lightViewProjection;
+uniform vec3 viewPosition;
+uniform vec3 lightPosition;
+uniform int stepCount = 24;
+uniform int frameIndex = 0;
+uniform float maxDistance = 80.0;
+uniform float density = 0.004;
+uniform float anisotropy = 0.6;
+
+const float PI = 3.14159265359;
+// keeps the lit air right in front of a surface from shadowing itself
+const float shadowBias = 0.0005;
+
+// share of the light scattered towards the camera for the angle
+// between the view ray and the direction to the light
+float HenyeyGreenstein(float cosTheta, float g)
+{
+    float g2 = g * g;
+    return (1.0 - g2) / (4.0 * PI * pow(1.0 + g2 - 2.0 * g * cosTheta, 1.5));
+}
+
+// per pixel noise with little low frequency content, so the banding
+// of a few steps turns into noise the history averages out
+float InterleavedGradientNoise(vec2 pixel)
+{
+    return fract(52.9829189 * fract(dot(pixel, vec2(0.06711056, 0.00583715))));
+}
+
+void main()
+{
+    // the full size depth under the center of this pixel
+    ivec2 depthSize = textureSize(depthTexture, 0);
+    ivec2 depthTexel = clamp(ivec2(fragmentTextureCoordinate * vec2(depthSize)), ivec2(0), depthSize - 1);
+    float depth = texelFetch(depthTexture, depthTexel, 0).r;
+    vec4 world = inverseViewProjection * vec4(vec3(fragmentTextureCoordinate, depth) * 2.0 - 1.0, 1.0);
+    vec3 ray = world.xyz / world.w - viewPosition;
+    float surfaceDistance = length(ray);
+    vec3 direction = ray / surfaceDistance;
+
+    float marchDistance = min(surfaceDistance, maxDistance);
+    float stepLength = marchDistance / float(stepCount);
+    float offset = fract(InterleavedGradientNoise(gl_FragCoord.xy) + float(frameIndex) * 0.618034);
+
+    // only the air the light reaches through the window scatters;
+    // outside the light's frustum is the wall around the window
+    float scattering = 0.0;
+    for (int i = 0; i < stepCount; i++)
+    {
+        vec3 position = viewPosition + direction * ((float(i) + offset) * stepLength);
+        vec4 light = lightViewProjection * vec4(position, 1.0);
+        vec3 shadowCoord = (light.xyz / light.w) * 0.5 + 0.5;
+        if ((light.w > 0.0) &&
+            all(greaterThan(shadowCoord, vec3(0.0))) && all(lessThan(shadowCoord, vec3(1.0))))
+        {
+            float lit = texture(shadowTexture, vec3(shadowCoord.xy, shadowCoord.z - shadowBias));
+            scattering += lit * HenyeyGreenstein(dot(direction, normalize(lightPosition - position)), anisotropy);
+        }
+    }
+
+    fragmentColor = vec4(scattering * density * stepLength, surfaceDistance, 0.0, 1.0);
+}